@@ -21,14 +21,22 @@ private:
         bool m_wrongPassword = false;
         /// @brief Time since last packet from server
         float m_timeSinceLastPacket = 0.0;
+        float m_timeSincePing = 0.f;
+        RttEstimator m_rtt;
         unsigned short m_serverPort = 7777;
+        /// @brief coroutines waiting on connect (guarded by m_awaitMutex)
+        std::vector<std::shared_ptr<AsyncState<bool>>> m_connectWaiters;
+        /// @brief when the connect waiters time out
+        std::chrono::steady_clock::time_point m_connectDeadline;
+        /// @brief the random token the server gave this connection (sent back in answers to path challenges)
+        std::uint64_t m_token = 0;
 
     // -----------------
 
     //* Thread Functions
 
         virtual void m_update_function(float deltaTime) override;
-        inline virtual void m_second_update_function() override {} // dont want to do anything with the second update as a client
+        inline virtual void m_second_update_function() override { m_record_traffic_history((float)m_rtt.getRTT()); }
 
     // -----------------
 
@@ -36,6 +44,12 @@ private:
     
         /// @brief use only when connection is closed
         virtual void m_reset_connection_data() override;
+        /// @brief binds the socket and starts the threads if they are not already running
+        /// @returns false if the socket could not be bound or there is no server IP
+        bool m_open_socket();
+        /// @brief completes every coroutine waiting on connect with the given result
+        void m_complete_connect(bool connected);
+        virtual void m_cancel_awaiting() override;
     
     // ---------------------
 
@@ -45,6 +59,13 @@ private:
         virtual void m_parse_connection_close(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
         virtual void m_parse_connection_confirm(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
         virtual void m_parse_password_request(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_request(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_response(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_ping(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_pong(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_shared_memory_accept(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        /// @brief answers the server so it moves this client to the address the challenge was sent to
+        virtual void m_parse_path_challenge(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
         // virtual void m_parse_wrong_password(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
 
     // -------------------------
@@ -93,11 +114,34 @@ public:
         bool setServerData(PORT port);
         /// @brief sends the packet to the server
         /// @warning must not send data when there is an invalid server IP set
-        void sendToServer(sf::Packet& packet);
+        /// @returns what happened to the packet (SendResult::NotConnected if the connection is not open)
+        SendResult sendToServer(sf::Packet& packet);
+        /// @brief sends every packet to the server in as few sends as the transport can
+        /// @note packets of the same size are sent together
+        /// @returns SendResult::Sent if every packet was sent otherwise what happened to the first packet that was not
+        SendResult sendBatchToServer(std::span<sf::Packet> packets);
         /// @brief returns the time in seconds
         float getTimeSinceLastPacket() const;
         IpAddress_t getServerIP() const;
         unsigned int getServerPort() const;
+        /// @returns the smoothed round trip time to the server in seconds (0 until the first pong is received)
+        double getRTT() const;
+        /// @returns the round trip time variance in seconds
+        double getRTTVariance() const;
+        /// @returns the offset in seconds that has to be added to this clock to get the servers clock
+        double getServerClockOffset() const;
+        /// @returns the estimated current time on the server in microseconds (comparable with the servers getClockTime)
+        std::int64_t getServerTime() const;
+        /// @brief attempts to connect to the server and waits for the result
+        /// @note if a password is needed the current password is sent instead of a connection request
+        /// @note the coroutine is resumed on the update thread
+        /// @returns true if connected, false if the server requested a password, refused, or did not respond before the timeout
+        Awaitable<bool> connect();
+        /// @brief sends the given message as a request to the server and waits for the response
+        /// @note the server must have a request handler set to respond
+        /// @param message the request data (should not include any packet template)
+        /// @returns the response or std::nullopt if not connected, the request timed out, or the connection closed
+        Awaitable<std::optional<Message>> request(const sf::Packet& message, sf::Time timeout = sf::seconds(5));
 
         //* Pure Virtual Definitions
 
@@ -5,6 +5,7 @@
 
 #include <SFML/Config.hpp>
 #include <unordered_set>
+#include <chrono>
 
 #include "Networking/Socket.hpp"
 
@@ -12,29 +13,73 @@ namespace udp
 {
 
 class Server;
+class ClientPool;
+
+/// @brief the counters and history of one client
+/// @note kept by the ClientPool in its own storage so ClientData stays small for the sweeps over every client
+struct ClientStats
+{
+    RttEstimator rtt;
+    ClientMetrics metrics;
+    /// @brief every round trip time sample
+    Histogram rttHistogram;
+    /// @brief guarded by the traffic lock of the pool (see ClientPool::recordTraffic)
+    TrafficRing traffic;
+};
 
 class ClientData
 {
 public:
-    ClientData(unsigned short port, ID id);
+    /// @param pool where the per tick state of this client is stored
+    /// @param stats the counters and history of this client (owned by the pool)
+    ClientData(const ClientPool& pool, ClientStats& stats, ID id, sf::IpAddress ip, unsigned short port);
     
-    const unsigned short port = 0;
+    /// @brief the connection ID the server gave this client
     const ID id = 0;
 
+    /// @returns the ip that this clients packets come from
+    /// @note this can change while connected if the clients address changes (i.e. a NAT rebinding)
+    sf::IpAddress getIP() const;
+    /// @returns the port that this clients packets come from
+    /// @note this can change while connected if the clients address changes (i.e. a NAT rebinding)
+    unsigned short getPort() const;
     unsigned int getPacketsPerSecond() const;
     double getConnectionTime() const;
     float getTimeSinceLastPacket() const;
+    /// @returns the smoothed round trip time in seconds (0 until the first pong is received)
+    double getRTT() const;
+    /// @returns the round trip time variance in seconds
+    double getRTTVariance() const;
+    /// @returns the offset in seconds that has to be added to the server clock to get this clients clock
+    double getClockOffset() const;
+    /// @returns the packet and byte counters for this client
+    const ClientMetrics& getMetrics() const;
+    /// @returns every round trip time sample for this client
+    HistogramSnapshot getRTTHistogram() const;
+    /// @returns the traffic of this client for each of the last TrafficHistory::CAPACITY seconds (oldest first)
+    std::vector<TrafficSample> getTrafficHistory() const;
 
 private:
     friend Server;
+    friend ClientPool;
+
+    /// @brief holds the packet counts and timers of this client
+    const ClientPool& m_pool;
+    ClientStats* m_stats;
+    std::uint32_t m_ip = 0;
+    unsigned short m_port = 0;
+    /// @brief random value only sent to this client (in its confirmation) that it has to answer path challenges with
+    std::uint64_t m_token = 0;
+
+    //* Path Validation (guarded by the servers client mutex, only written while it is uniquely locked)
 
-    /// @brief TEMP var for storing how many packets are sent between seconds
-    unsigned int m_packetsSent = 0;
-    /// @brief Should be updated once every second using PacketsSent
-    unsigned int m_packetsPerSecond = 0;
+        /// @brief the nonce of the challenge sent to the address this client may have moved to (0 if none is waiting)
+        std::uint64_t m_challengeNonce = 0;
+        std::uint32_t m_challengeIP = 0;
+        unsigned short m_challengePort = 0;
+        std::chrono::steady_clock::time_point m_challengeTime;
 
-    double m_connectionTime = 0.f;
-    float m_timeSinceLastPacket = 0.f;
+    // ---------------------
 };
 
 }
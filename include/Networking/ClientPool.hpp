@@ -0,0 +1,230 @@
+#ifndef CLIENT_POOL_HPP
+#define CLIENT_POOL_HPP
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "Networking/ClientData.hpp"
+
+namespace udp
+{
+
+/// @brief storage for the clients of a server that gives each client a generational connection ID
+/// @note an ID is the slot of the client (low SLOT_BITS) and the generation of the slot (high bits), the generation changes every time
+///       the slot is freed so the ID of a client that disconnected never finds the next client in its slot
+/// @note clients are constructed in place in chunks that are kept until the pool is destroyed so connecting and disconnecting
+///       only allocates when more clients are connected than ever before
+/// @note iteration goes through the slots in order so clients are visited in the order they are stored in memory
+/// @note the state that is updated every tick (timers and packet counts) is kept in arrays by slot instead of in the clients
+///       so the per tick sweeps go through contiguous memory, ClientData reads it from here
+/// @note timers are kept as the pool time of the last event so a tick only moves the pool time forward instead of writing every client
+/// @note the counters and history of each client (ClientStats) are kept in chunks of their own by slot so ClientData only points at them
+/// @note not thread safe, the server guards it with its client mutex, the hot state can be used with the mutex only shared locked
+///       (packets are counted from the receive and shared memory threads while the update thread sweeps) so it is accessed with relaxed atomics
+class ClientPool
+{
+public:
+    static constexpr std::uint32_t SLOT_BITS = 16;
+    /// @brief the most clients that can be stored at once
+    static constexpr std::uint32_t MAX_CLIENTS = 1 << SLOT_BITS;
+    /// @brief the number of clients in each chunk of storage
+    static constexpr std::uint32_t CHUNK_SIZE = 64;
+
+    /// @brief goes through every client in slot order
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ClientData*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ClientData* const*;
+        using reference = ClientData*;
+
+        inline Iterator(const ClientPool* pool, std::uint32_t slot) : m_pool(pool), m_slot(slot)
+        {
+            m_skip_free();
+        }
+
+        inline ClientData* operator*() const { return m_pool->m_get(m_slot); }
+        inline Iterator& operator++() { m_slot++; m_skip_free(); return *this; }
+        inline Iterator operator++(int) { Iterator temp = *this; ++(*this); return temp; }
+        inline bool operator==(const Iterator& other) const { return m_slot == other.m_slot; }
+        inline bool operator!=(const Iterator& other) const { return m_slot != other.m_slot; }
+
+    private:
+        inline void m_skip_free()
+        {
+            while (m_slot < m_pool->m_slotCount && !m_pool->m_used[m_slot])
+                m_slot++;
+        }
+
+        const ClientPool* m_pool;
+        std::uint32_t m_slot;
+    };
+
+    ClientPool() = default;
+    ~ClientPool();
+    ClientPool(const ClientPool&) = delete;
+    ClientPool& operator=(const ClientPool&) = delete;
+
+    /// @brief constructs a client in a free slot and gives it a new path token
+    /// @note if another client is at the same address this one replaces it in find
+    /// @returns the new client or nullptr if there are already MAX_CLIENTS clients
+    ClientData* add(sf::IpAddress ip, unsigned short port);
+    /// @brief destroys the client and frees its slot
+    void remove(ClientData* client);
+    /// @brief destroys every client
+    /// @note the storage is kept for the next clients
+    void clear();
+    /// @brief changes the address of the client
+    void move(ClientData* client, sf::IpAddress ip, unsigned short port);
+
+    /// @returns the client with the given ID or nullptr if there is none (i.e. the client disconnected)
+    ClientData* get(ID id) const;
+    /// @returns the client at the given address or nullptr if there is none
+    ClientData* find(sf::IpAddress ip, unsigned short port) const;
+    /// @returns the number of clients
+    std::size_t size() const;
+    bool empty() const;
+    /// @returns the number of clients that can be stored without allocating
+    std::size_t getCapacity() const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    /// @returns the slot part of the ID
+    static std::uint32_t getSlot(ID id);
+    /// @returns 64 bits from the systems random source (never 0)
+    /// @note used for the path tokens and challenges, these can not be worked out from the IDs like the generations could
+    static std::uint64_t makeToken();
+
+    //* Hot State
+
+        /// @brief resets the time since the last packet of the client
+        /// @param countPacket if the packet counts towards the packets per second of the client
+        /// @note safe to call from any thread while the pool is shared locked
+        inline void onReceive(const ClientData* client, bool countPacket = true)
+        {
+            std::uint32_t slot = getSlot(client->id);
+            std::atomic_ref(m_lastPacketTime[slot]).store(m_time.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            if (countPacket)
+                std::atomic_ref(m_packetsSent[slot]).fetch_add(1, std::memory_order_relaxed);
+        }
+        /// @brief adds the time to the connection time, the time since the last packet, and the time since the last ping of every client
+        /// @note only moves the pool time forward (every client is timed against it)
+        /// @note should only be called from one thread at a time (the update thread)
+        void addTime(float deltaTime);
+        /// @brief adds the ID of every client that has not sent anything for at least timeout seconds
+        void getTimedOut(float timeout, std::vector<ID>& timedOut) const;
+        /// @brief adds every client that has not been pinged for at least interval seconds and resets their ping timer
+        /// @note should only be called from the thread that calls addTime
+        void getPingsDue(float interval, std::vector<ClientData*>& due);
+        /// @brief makes the packets received since the last call the packets per second of every client
+        /// @note should be called once a second from one thread at a time
+        void updatePacketsPerSecond();
+
+        float getTimeSinceLastPacket(const ClientData* client) const;
+        double getConnectionTime(const ClientData* client) const;
+        unsigned int getPacketsPerSecond(const ClientData* client) const;
+
+    // -------------
+
+    //* Traffic History
+
+        /// @brief adds a sample to the traffic history of every client from its counters and round trip time
+        /// @note should be called once a second from one thread at a time, the traffic lock is taken once for every client
+        void recordTraffic();
+        /// @returns the traffic samples of the client from oldest to newest
+        /// @note safe to call from any thread while the pool is shared locked
+        std::vector<TrafficSample> getTrafficHistory(const ClientData* client) const;
+
+    // ------------------
+
+private:
+    struct alignas(ClientData) Storage
+    {
+        std::byte data[sizeof(ClientData)];
+    };
+    struct alignas(ClientStats) StatsStorage
+    {
+        std::byte data[sizeof(ClientStats)];
+    };
+
+    /// @brief a slot in the open addressing table of client addresses
+    struct Endpoint
+    {
+        static constexpr std::uint32_t EMPTY = 0xFFFFFFFF;
+
+        std::uint64_t key = 0;
+        std::uint32_t slot = EMPTY;
+    };
+
+    ClientData* m_get(std::uint32_t slot) const;
+    ClientStats* m_get_stats(std::uint32_t slot) const;
+    /// @returns the value with a relaxed atomic load (for hot state that receiving threads can write)
+    template <typename T>
+    static inline T m_load(const T& value)
+    {
+        return std::atomic_ref<T>(const_cast<T&>(value)).load(std::memory_order_relaxed);
+    }
+    /// @brief adds a chunk of storage and grows the address table to fit it
+    void m_grow();
+    /// @returns where the key would be in the address table if nothing collided with it
+    std::size_t m_get_home(std::uint64_t key) const;
+    /// @brief points the address at the slot (replacing any other slot at that address)
+    void m_insert_endpoint(std::uint64_t key, std::uint32_t slot);
+    /// @brief removes the address if it points at the slot
+    void m_erase_endpoint(std::uint64_t key, std::uint32_t slot);
+
+    std::vector<std::unique_ptr<Storage[]>> m_chunks;
+    /// @brief the stats of the client in each slot (same chunks as m_chunks)
+    std::vector<std::unique_ptr<StatsStorage[]>> m_statsChunks;
+    /// @brief guards the traffic ring of every client
+    mutable std::mutex m_trafficMutex;
+    /// @brief the generation of every slot that has been used (the high bits of the ID of the client in it)
+    std::vector<std::uint16_t> m_generations;
+    /// @brief if there is a client in each slot
+    std::vector<std::uint8_t> m_used;
+    /// @brief freed slots from oldest to newest (ring buffer) so slots are reused as late as possible
+    std::vector<std::uint32_t> m_freeSlots;
+    std::size_t m_freeHead = 0;
+    std::size_t m_freeCount = 0;
+    /// @brief one more than the highest slot ever used
+    std::uint32_t m_slotCount = 0;
+    std::size_t m_size = 0;
+
+    //* Hot State (by slot, free slots hold old values that are reset when the slot is used again)
+
+        /// @brief the seconds added by addTime since the pool was made, every timer is measured against this
+        /// @note written by the update thread and read by any thread that receives packets
+        std::atomic<double> m_time = 0.0;
+        /// @brief the pool time when each client last sent something (written by receiving threads with relaxed atomics)
+        std::vector<double> m_lastPacketTime;
+        /// @brief the pool time each client was last pinged (only used by the update thread)
+        std::vector<double> m_lastPingTime;
+        /// @brief the pool time each client connected (only written while the pool is uniquely locked)
+        std::vector<double> m_connectTime;
+        /// @brief packets received since the last call to updatePacketsPerSecond (counted by receiving threads with relaxed atomics)
+        std::vector<std::uint32_t> m_packetsSent;
+        /// @brief read from any thread with relaxed atomics
+        std::vector<std::uint32_t> m_packetsPerSecond;
+
+    // -------------
+
+    /// @brief the slot of the client at each address (power of two size at least twice the capacity)
+    std::vector<Endpoint> m_endpoints;
+    /// @brief gives each slot a random first generation so IDs can not be guessed from the slot
+    std::mt19937 m_generator{std::random_device{}()};
+};
+
+}
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef COROUTINE_HPP
+#define COROUTINE_HPP
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace udp
+{
+
+/// @brief the state shared between an asynchronous operation and the coroutine waiting on it
+/// @note the first call to complete sets the result, any later calls are ignored
+template <typename T>
+class AsyncState
+{
+public:
+    /// @brief sets the result if the state is not already completed
+    /// @returns the coroutine that should be resumed (null if nothing is waiting yet or if already completed)
+    inline std::coroutine_handle<> complete(T value)
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_completed)
+            return nullptr;
+        m_result.emplace(std::move(value));
+        m_completed = true;
+        return std::exchange(m_handle, nullptr);
+    }
+
+    inline bool isCompleted() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_completed;
+    }
+
+    /// @brief stores the coroutine that is waiting on the result
+    /// @returns false if the state was already completed (coroutine should not suspend)
+    inline bool suspend(std::coroutine_handle<> handle)
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_completed)
+            return false;
+        m_handle = handle;
+        return true;
+    }
+
+    /// @brief moves the result out of the state
+    /// @warning only valid once completed
+    inline T take()
+    {
+        std::lock_guard lock(m_mutex);
+        return std::move(m_result.value());
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::optional<T> m_result;
+    std::coroutine_handle<> m_handle = nullptr;
+    bool m_completed = false;
+};
+
+/// @brief returned by asynchronous socket operations so they can be used with co_await
+/// @note coroutines are resumed on the sockets update thread unless the result was already available
+template <typename T>
+class Awaitable
+{
+public:
+    /// @brief called with the state of the awaitable
+    using Callback = std::function<void(const std::shared_ptr<AsyncState<T>>&)>;
+
+    inline Awaitable(std::shared_ptr<AsyncState<T>> state) : m_state(std::move(state)) {}
+    /// @param onSuspend called the first time a coroutine awaits this (i.e. to register the state with whatever completes it)
+    ///        so an awaitable that is never awaited does not take a result from anything else
+    /// @param onAbandon called if the awaitable is destroyed after onSuspend without being completed (i.e. the coroutine was destroyed)
+    inline Awaitable(std::shared_ptr<AsyncState<T>> state, Callback onSuspend, Callback onAbandon) : 
+        m_state(std::move(state)), m_onSuspend(std::move(onSuspend)), m_onAbandon(std::move(onAbandon)) {}
+    inline Awaitable(Awaitable&& other) noexcept : 
+        m_state(std::move(other.m_state)), m_onSuspend(std::move(other.m_onSuspend)), m_onAbandon(std::move(other.m_onAbandon)), 
+        m_registered(std::exchange(other.m_registered, false)) {}
+    Awaitable(const Awaitable&) = delete;
+    Awaitable& operator=(const Awaitable&) = delete;
+    Awaitable& operator=(Awaitable&&) = delete;
+    inline ~Awaitable()
+    {
+        if (m_registered && m_onAbandon && !m_state->isCompleted())
+            m_onAbandon(m_state);
+    }
+
+    /// @returns an awaitable that is already completed with the given value
+    static inline Awaitable ready(T value)
+    {
+        auto state = std::make_shared<AsyncState<T>>();
+        state->complete(std::move(value));
+        return Awaitable(std::move(state));
+    }
+
+    inline bool await_ready() const { return m_state->isCompleted(); }
+    inline bool await_suspend(std::coroutine_handle<> handle)
+    {
+        // registered before the handle is stored so a result that arrives in between is taken by await_resume without suspending
+        if (m_onSuspend)
+        {
+            m_registered = true;
+            std::exchange(m_onSuspend, nullptr)(m_state);
+        }
+        return m_state->suspend(handle);
+    }
+    inline T await_resume() { return m_state->take(); }
+
+private:
+    std::shared_ptr<AsyncState<T>> m_state;
+    Callback m_onSuspend;
+    Callback m_onAbandon;
+    bool m_registered = false;
+};
+
+template <typename T = void>
+class Task;
+
+template <typename T>
+struct TaskPromiseBase
+{
+    /// @brief the coroutine to resume once this task is finished
+    std::coroutine_handle<> continuation = nullptr;
+    std::exception_ptr exception = nullptr;
+    /// @brief if true the coroutine frame destroys its self once finished
+    bool detached = false;
+
+    struct FinalAwaiter
+    {
+        inline bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        inline std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            auto& promise = handle.promise();
+            if (promise.detached)
+            {
+                handle.destroy();
+                return std::noop_coroutine();
+            }
+            if (promise.continuation)
+                return promise.continuation;
+            return std::noop_coroutine();
+        }
+        inline void await_resume() noexcept {}
+    };
+
+    inline std::suspend_always initial_suspend() noexcept { return {}; }
+    inline FinalAwaiter final_suspend() noexcept { return {}; }
+    inline void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : public TaskPromiseBase<T>
+{
+    std::optional<T> value;
+
+    inline Task<T> get_return_object();
+    inline void return_value(T v) { value.emplace(std::move(v)); }
+};
+
+template <>
+struct TaskPromise<void> : public TaskPromiseBase<void>
+{
+    inline Task<void> get_return_object();
+    inline void return_void() {}
+};
+
+/// @brief a coroutine that does not start until it is awaited or started
+/// @note co_await a task from another coroutine to get its result
+/// @note call start() to run a task without awaiting it (the task cleans its self up once finished)
+template <typename T>
+class Task
+{
+public:
+    using promise_type = TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    inline explicit Task(Handle handle) : m_handle(handle) {}
+    inline Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    inline Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    inline ~Task()
+    {
+        if (m_handle) m_handle.destroy();
+    }
+
+    /// @brief runs the task until its first suspension without waiting for a result
+    /// @note the task is no longer owned by this object and will be destroyed once finished
+    /// @note any exception thrown by a started task is discarded
+    inline void start()
+    {
+        if (!m_handle) return;
+        m_handle.promise().detached = true;
+        std::exchange(m_handle, nullptr).resume();
+    }
+
+    /// @returns true if the task has finished running
+    inline bool isDone() const
+    {
+        return !m_handle || m_handle.done();
+    }
+
+    inline bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+    inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    inline T await_resume()
+    {
+        if (m_handle.promise().exception)
+            std::rethrow_exception(m_handle.promise().exception);
+        if constexpr (!std::is_void_v<T>)
+            return std::move(m_handle.promise().value.value());
+    }
+
+private:
+    Handle m_handle;
+};
+
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+}
+
+#endif
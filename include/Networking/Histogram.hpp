@@ -0,0 +1,93 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#pragma once
+
+#include <bit>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace udp
+{
+
+/// @brief the bucket layout shared by Histogram and HistogramSnapshot
+/// @note values are in nanoseconds, every power of two range is split into SUB_BUCKETS linear buckets
+///       so any value is within 1/SUB_BUCKETS (~6%) of the bucket it lands in
+struct HistogramLayout
+{
+    static constexpr std::uint32_t SUB_BUCKET_BITS = 4;
+    static constexpr std::uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    /// @brief values are clamped to 2^MAX_BITS - 1 nanoseconds (~68 seconds)
+    static constexpr std::uint32_t MAX_BITS = 36;
+    static constexpr std::uint64_t MAX_VALUE = (std::uint64_t(1) << MAX_BITS) - 1;
+    static constexpr std::size_t BUCKET_COUNT = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    /// @returns the bucket that the value (in nanoseconds) belongs to
+    static inline std::size_t getIndex(std::uint64_t value)
+    {
+        if (value > MAX_VALUE)
+            value = MAX_VALUE;
+        if (value < SUB_BUCKETS)
+            return (std::size_t)value;
+        std::uint32_t highestBit = (std::uint32_t)std::bit_width(value) - 1;
+        std::uint32_t shift = highestBit - SUB_BUCKET_BITS;
+        return (std::size_t)(shift + 1) * SUB_BUCKETS + (std::size_t)((value >> shift) - SUB_BUCKETS);
+    }
+    /// @returns the smallest value that lands in the bucket
+    static std::uint64_t getLowerBound(std::size_t index);
+    /// @returns the largest value that lands in the bucket
+    static std::uint64_t getUpperBound(std::size_t index);
+};
+
+/// @brief a plain copy of a Histogram that can be queried and merged
+/// @note all times are in seconds
+struct HistogramSnapshot
+{
+    std::array<std::uint64_t, HistogramLayout::BUCKET_COUNT> buckets{};
+    std::uint64_t count = 0;
+    /// @brief in nanoseconds
+    std::uint64_t sum = 0;
+
+    /// @brief adds every value from the other snapshot to this one
+    void merge(const HistogramSnapshot& other);
+    /// @param percentile from 0 to 100
+    /// @returns the value that the given percent of values are at or below (the top of its bucket)
+    /// @note 0 if nothing has been recorded
+    double getPercentile(double percentile) const;
+    double getMin() const;
+    double getMax() const;
+    double getMean() const;
+};
+
+/// @brief fixed memory log-linear histogram for latencies
+/// @note recording is wait-free (relaxed atomic adds only) so it can be done from any number of threads at once
+/// @note values are in nanoseconds
+class Histogram
+{
+public:
+    inline void record(std::uint64_t nanoseconds)
+    {
+        m_buckets[HistogramLayout::getIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+    /// @note negative values are recorded as 0
+    void recordSeconds(double seconds);
+    /// @brief adds every value from the other histogram to this one
+    void merge(const Histogram& other);
+    /// @returns a copy of the histogram
+    /// @note values recorded while copying may or may not be included
+    HistogramSnapshot snapshot() const;
+    void reset();
+
+private:
+    std::array<std::atomic<std::uint64_t>, HistogramLayout::BUCKET_COUNT> m_buckets{};
+    std::atomic<std::uint64_t> m_count = 0;
+    std::atomic<std::uint64_t> m_sum = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef MEMORY_TRANSPORT_HPP
+#define MEMORY_TRANSPORT_HPP
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "Networking/Transport.hpp"
+#include "Networking/MessageQueue.hpp"
+
+namespace udp
+{
+
+/// @brief a transport that passes packets between sockets in the same process without any system calls
+/// @note every memory transport has its own virtual ip so that servers can tell clients apart
+/// @note packets sent to an address that is not bound or to a full receive queue are dropped the same as UDP
+class MemoryTransport : public Transport
+{
+public:
+    /// @param address the virtual ip of this transport, if not given a unique one is picked (10.x.x.x)
+    /// @param queueCapacity the max number of packets waiting to be received (rounded up to the next power of two)
+    MemoryTransport(std::optional<sf::IpAddress> address = std::nullopt, std::size_t queueCapacity = 1024);
+    ~MemoryTransport();
+
+    MemoryTransport(const MemoryTransport&) = delete;
+    MemoryTransport& operator=(const MemoryTransport&) = delete;
+
+    /// @note fails if the port is already bound with the same virtual ip
+    virtual sf::Socket::Status bind(unsigned short port) override;
+    virtual void unbind() override;
+    virtual unsigned short getLocalPort() const override;
+    virtual sf::Socket::Status send(sf::Packet& packet, sf::IpAddress ip, unsigned short port) override;
+    virtual sf::Socket::Status receive(sf::Packet& packet, std::optional<sf::IpAddress>& senderIP, unsigned short& senderPort) override;
+    virtual void interrupt() override;
+    /// @returns getDroppedCount() so a full queue shows up in the socket metrics like a full kernel receive buffer
+    virtual std::uint64_t getReceiveOverflowCount() const override;
+    /// @brief if senders should stamp packets with the time they were put in the queue of this transport
+    virtual void setTimestampsEnabled(bool enabled) override;
+    virtual std::uint64_t getReceiveTimestamp() const override;
+
+    /// @returns the virtual ip of this transport
+    sf::IpAddress getAddress() const;
+    /// @returns the number of packets that were sent to this transport and dropped because its queue was full
+    /// @note resets every time the transport is bound
+    std::uint64_t getDroppedCount() const;
+
+    /// @brief what is stored in a receive queue
+    struct Datagram
+    {
+        sf::Packet packet;
+        std::uint32_t senderIP = 0;
+        unsigned short senderPort = 0;
+        /// @brief when the packet was queued (steady clock nanoseconds, 0 if timestamps are disabled)
+        std::uint64_t arrivalTime = 0;
+    };
+
+    /// @brief the receiving side of a bound transport
+    /// @note kept alive by any sender that is currently using it so unbinding never frees it from under a send
+    struct Endpoint
+    {
+        inline Endpoint(std::size_t capacity) : queue(capacity) {}
+
+        MessageQueue<Datagram> queue;
+        /// @brief bumped every time a packet is pushed or the receiver is interrupted
+        std::atomic<std::uint32_t> signal = 0;
+        std::atomic<bool> waiting = false;
+        std::atomic<bool> interrupted = false;
+        std::atomic<std::uint64_t> dropped = 0;
+        /// @brief if senders should set the arrival time of each datagram
+        std::atomic<bool> timestamps = false;
+    };
+
+private:
+    sf::IpAddress m_address;
+    std::size_t m_queueCapacity;
+    unsigned short m_port = 0;
+    bool m_timestampsEnabled = false;
+    /// @brief the arrival time of the last datagram received
+    std::uint64_t m_receiveTimestamp = 0;
+    std::shared_ptr<Endpoint> m_endpoint = nullptr;
+};
+
+}
+
+#endif
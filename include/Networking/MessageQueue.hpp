@@ -0,0 +1,135 @@
+#ifndef MESSAGE_QUEUE_HPP
+#define MESSAGE_QUEUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace udp
+{
+
+/// @brief bounded lock-free queue that supports multiple producers and a single consumer
+/// @note values are swapped in and out of the queue instead of copied so that their resources (i.e. packet buffers) are reused
+template <typename T>
+class MessageQueue
+{
+public:
+    /// @param capacity rounded up to the next power of two
+    inline MessageQueue(std::size_t capacity = 1024)
+    {
+        m_allocate(capacity);
+    }
+
+    MessageQueue(const MessageQueue&) = delete;
+    MessageQueue& operator=(const MessageQueue&) = delete;
+
+    /// @brief swaps the given value into the queue
+    /// @note safe to call from multiple threads at once
+    /// @returns false if the queue is full (value is left untouched)
+    inline bool push(T& value)
+    {
+        Cell* cell;
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_buffer[pos & m_mask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = (std::intptr_t)sequence - (std::intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+        std::swap(cell->data, value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief swaps the oldest value in the queue into the given value
+    /// @note must only be called from one thread at a time
+    /// @returns false if the queue is empty
+    inline bool pop(T& value)
+    {
+        Cell* cell;
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_buffer[pos & m_mask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = (std::intptr_t)sequence - (std::intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+        }
+        std::swap(value, cell->data);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @returns the approximate number of values in the queue
+    inline std::size_t size() const
+    {
+        std::size_t enqueue = m_enqueuePos.load(std::memory_order_relaxed);
+        std::size_t dequeue = m_dequeuePos.load(std::memory_order_relaxed);
+        return enqueue > dequeue ? enqueue - dequeue : 0;
+    }
+
+    inline std::size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    /// @brief reallocates the queue removing all values
+    /// @warning must not be called while any other thread is using the queue
+    /// @param capacity rounded up to the next power of two
+    inline void reset(std::size_t capacity)
+    {
+        m_allocate(capacity);
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    inline void m_allocate(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        m_buffer = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; i++)
+            m_buffer[i].sequence.store(i, std::memory_order_relaxed);
+        m_mask = size - 1;
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<Cell[]> m_buffer;
+    std::size_t m_mask = 0;
+    // keeping the producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<std::size_t> m_enqueuePos = 0;
+    alignas(64) std::atomic<std::size_t> m_dequeuePos = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+#include "Networking/TickScheduler.hpp"
+
+namespace udp
+{
+
+/// @brief why a received packet was thrown away
+enum class DropReason : std::uint8_t
+{
+    /// @brief the message queue was full
+    QueueFull = 0,
+    /// @brief the sender is not connected (not a client of the server or not the server of the client)
+    /// @note includes packets with the ID of a client from an address the client has not been validated at yet
+    NotConnected = 1,
+    /// @brief lost or queue dropped by the incoming network simulator
+    Simulated = 2,
+    /// @brief dropped by the transport before it was received because the receive buffer was full
+    /// @note for a UdpTransport this is the kernel receive queue overflowing (see Socket::setBufferSizes)
+    ReceiveOverflow = 3,
+    Count
+};
+
+/// @returns the name used for the reason when exporting (i.e. "queue_full")
+const char* toString(DropReason reason);
+
+/// @brief counters for one socket
+/// @note every counter is a relaxed atomic so they can be updated from any thread without locking
+struct SocketMetrics
+{
+    std::atomic<std::uint64_t> packetsIn = 0;
+    std::atomic<std::uint64_t> bytesIn = 0;
+    std::atomic<std::uint64_t> packetsOut = 0;
+    std::atomic<std::uint64_t> bytesOut = 0;
+    /// @brief packets without a type or with an unknown type
+    std::atomic<std::uint64_t> parseErrors = 0;
+    /// @brief sends that the transport failed
+    std::atomic<std::uint64_t> sendFailures = 0;
+    /// @brief sends that the transport would have blocked on (the packet was queued or dropped instead)
+    std::atomic<std::uint64_t> sendWouldBlock = 0;
+    /// @brief packets thrown away because the send queue of their destination was full
+    std::atomic<std::uint64_t> sendQueueDrops = 0;
+    std::array<std::atomic<std::uint64_t>, (std::size_t)DropReason::Count> drops{};
+    /// @brief connection requests sent by a client or received by a server
+    std::atomic<std::uint64_t> connectionRequests = 0;
+    /// @brief confirmed connections (clients added by a server)
+    std::atomic<std::uint64_t> connectionsOpened = 0;
+    /// @brief wrong passwords (received by a server or rejected for a client)
+    std::atomic<std::uint64_t> passwordFailures = 0;
+    /// @brief connections that were closed (clients removed by a server)
+    std::atomic<std::uint64_t> disconnects = 0;
+    /// @brief connections that were closed because nothing was received for the timeout time
+    std::atomic<std::uint64_t> timeouts = 0;
+    /// @brief clients that kept their connection when their address changed (i.e. a NAT rebinding)
+    std::atomic<std::uint64_t> addressChanges = 0;
+    std::atomic<std::uint64_t> pingsOut = 0;
+    /// @brief pongs received for pings that were sent
+    std::atomic<std::uint64_t> pongsIn = 0;
+
+    inline void addIn(std::size_t bytes)
+    {
+        packetsIn.fetch_add(1, std::memory_order_relaxed);
+        bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    inline void addOut(std::size_t bytes)
+    {
+        packetsOut.fetch_add(1, std::memory_order_relaxed);
+        bytesOut.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    inline void addDrop(DropReason reason)
+    {
+        drops[(std::size_t)reason].fetch_add(1, std::memory_order_relaxed);
+    }
+    inline static void increment(std::atomic<std::uint64_t>& counter)
+    {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+    void reset();
+};
+
+/// @brief counters kept by a server for each of its clients
+struct ClientMetrics
+{
+    std::atomic<std::uint64_t> packetsIn = 0;
+    std::atomic<std::uint64_t> bytesIn = 0;
+    std::atomic<std::uint64_t> packetsOut = 0;
+    std::atomic<std::uint64_t> bytesOut = 0;
+    std::atomic<std::uint64_t> pingsOut = 0;
+    std::atomic<std::uint64_t> pongsIn = 0;
+
+    inline void addIn(std::size_t bytes)
+    {
+        packetsIn.fetch_add(1, std::memory_order_relaxed);
+        bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    inline void addOut(std::size_t bytes)
+    {
+        packetsOut.fetch_add(1, std::memory_order_relaxed);
+        bytesOut.fetch_add(bytes, std::memory_order_relaxed);
+    }
+};
+
+/// @brief the metrics of one client at the time of a snapshot
+struct ClientMetricsSnapshot
+{
+    /// @brief the connection ID of the client
+    std::uint32_t id = 0;
+    /// @brief the ip the client is sending from as an integer
+    std::uint32_t ip = 0;
+    unsigned short port = 0;
+    std::uint64_t packetsIn = 0;
+    std::uint64_t bytesIn = 0;
+    std::uint64_t packetsOut = 0;
+    std::uint64_t bytesOut = 0;
+    unsigned int packetsPerSecond = 0;
+    /// @brief in seconds
+    double rtt = 0.0;
+    /// @brief in seconds
+    double connectionTime = 0.0;
+    /// @brief in seconds
+    float timeSinceLastPacket = 0.f;
+    /// @brief packets waiting for the transport to be writable
+    std::size_t sendQueueDepth = 0;
+};
+
+/// @brief a copy of every metric of a socket
+/// @note each value is loaded on its own while the socket keeps running so values that change together (like packets and bytes) can be slightly out of step
+struct MetricsSnapshot
+{
+    /// @brief when the snapshot was taken (milliseconds since the unix epoch)
+    std::int64_t time = 0;
+
+    //* Counters
+
+        std::uint64_t packetsIn = 0;
+        std::uint64_t bytesIn = 0;
+        std::uint64_t packetsOut = 0;
+        std::uint64_t bytesOut = 0;
+        std::uint64_t parseErrors = 0;
+        std::uint64_t sendFailures = 0;
+        std::uint64_t sendWouldBlock = 0;
+        std::uint64_t sendQueueDrops = 0;
+        std::array<std::uint64_t, (std::size_t)DropReason::Count> drops{};
+        std::uint64_t connectionRequests = 0;
+        std::uint64_t connectionsOpened = 0;
+        std::uint64_t passwordFailures = 0;
+        std::uint64_t disconnects = 0;
+        std::uint64_t timeouts = 0;
+        std::uint64_t addressChanges = 0;
+        std::uint64_t pingsOut = 0;
+        std::uint64_t pongsIn = 0;
+
+    // ----------
+
+    //* Gauges
+
+        bool connectionOpen = false;
+        std::size_t messageQueueDepth = 0;
+        std::size_t messageQueueCapacity = 0;
+        /// @brief packets waiting for the transport to be writable
+        std::size_t sendQueueDepth = 0;
+        /// @brief the max packets that can wait for each destination
+        std::size_t sendQueueCapacity = 0;
+        /// @brief packets waiting in the incoming network simulator
+        std::size_t simulatorIncomingPending = 0;
+        /// @brief packets waiting in the outgoing network simulator
+        std::size_t simulatorOutgoingPending = 0;
+        std::size_t sharedMemoryChannels = 0;
+        /// @brief the update thread timing (includes tick overruns)
+        TickStats ticks;
+
+    // --------
+
+    /// @brief only filled in by a server
+    /// @note rebuilt once a second by the server update thread so these can be up to a second older than the rest of the snapshot
+    std::vector<ClientMetricsSnapshot> clients;
+
+    /// @brief copies the counters from the given metrics
+    void copyCounters(const SocketMetrics& metrics);
+};
+
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef METRICS_EXPORTER_HPP
+#define METRICS_EXPORTER_HPP
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "Networking/Metrics.hpp"
+
+namespace udp
+{
+
+class Socket;
+
+/// @brief writes metric snapshots of one or more sockets to a file on a timer
+/// @note the file is written to a temporary file first and then renamed so readers never see a partial file
+/// @note sockets must be removed (or the exporter stopped) before they are destroyed
+class MetricsExporter
+{
+public:
+    enum class Format
+    {
+        /// @brief prometheus text exposition format (can be read by the node exporter textfile collector)
+        Prometheus,
+        Json
+    };
+
+    /// @param interval seconds between writes
+    MetricsExporter(const std::string& path, Format format = Format::Prometheus, float interval = 5.f);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /// @brief adds a socket that is exported with the given name
+    /// @note if a socket with the same name was already added it is replaced
+    void add(const std::string& name, const Socket& socket);
+    void remove(const std::string& name);
+    /// @brief starts writing on the exporters own thread
+    void start();
+    /// @brief stops the exporter thread after writing one last time
+    void stop();
+    bool isRunning() const;
+    /// @brief takes a snapshot of every socket and writes the file from the calling thread
+    /// @returns false if the file could not be written
+    bool writeNow();
+
+    void setInterval(float interval);
+    float getInterval() const;
+    void setFormat(Format format);
+    Format getFormat() const;
+
+    /// @returns the snapshots in prometheus text format
+    static std::string toPrometheus(const std::vector<std::pair<std::string, MetricsSnapshot>>& snapshots);
+    /// @returns the snapshots as a json object with one member per socket name
+    static std::string toJson(const std::vector<std::pair<std::string, MetricsSnapshot>>& snapshots);
+
+protected:
+    void m_thread_function(std::stop_token sToken);
+
+private:
+    std::string m_path;
+    Format m_format;
+    float m_interval;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::vector<std::pair<std::string, const Socket*>> m_sockets;
+    std::jthread* m_thread = nullptr;
+    /// @brief only one write at a time so that the temporary file is not shared
+    std::mutex m_writeMutex;
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef NETWORK_SIMULATOR_HPP
+#define NETWORK_SIMULATOR_HPP
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <condition_variable>
+
+#include <SFML/Network/Packet.hpp>
+#include <SFML/Network/IpAddress.hpp>
+
+namespace udp
+{
+
+/// @brief the network conditions that a NetworkSimulator applies to packets
+/// @note all times are in seconds and all chances are from 0 to 1
+struct NetworkConditions
+{
+    /// @brief delay added to every packet
+    float latency = 0.f;
+    /// @brief a random delay from -jitter to +jitter is added to the latency (packets can be reordered by this)
+    float jitter = 0.f;
+    /// @brief chance that a packet is dropped
+    float loss = 0.f;
+    /// @brief chance that a packet is sent twice
+    float duplication = 0.f;
+    /// @brief chance that a packet is held back by reorderDelay so that packets sent after it arrive first
+    float reordering = 0.f;
+    float reorderDelay = 0.05f;
+    /// @brief bytes per second (0 for no limit)
+    std::uint64_t bandwidth = 0;
+    /// @brief the longest a packet can wait for bandwidth before it is dropped (like a full router buffer)
+    float maxQueueDelay = 0.25f;
+
+    /// @returns true if these conditions do not change packets in any way
+    bool isPerfect() const;
+};
+
+/// @brief counters kept by a NetworkSimulator
+struct NetworkSimulatorStats
+{
+    /// @brief packets given to the simulator
+    std::uint64_t packets = 0;
+    /// @brief packets that were passed on (includes duplicates)
+    std::uint64_t delivered = 0;
+    /// @brief packets dropped by the loss chance
+    std::uint64_t lost = 0;
+    /// @brief packets dropped because they would have waited longer than maxQueueDelay for bandwidth
+    std::uint64_t queueDropped = 0;
+    std::uint64_t duplicated = 0;
+    std::uint64_t reordered = 0;
+};
+
+/// @brief delays, drops, duplicates and reorders packets for one direction of a socket
+/// @note packets are passed on from the simulators own thread which is only started once packets need to be delayed
+/// @note randomness is seeded so that runs can be repeated
+class NetworkSimulator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    /// @brief called when a packet has made it through the simulator
+    using DeliverFunction = std::function<void(sf::Packet& packet, sf::IpAddress ip, unsigned short port)>;
+
+    NetworkSimulator(const DeliverFunction& deliver, std::uint64_t seed = 0);
+    ~NetworkSimulator();
+
+    NetworkSimulator(const NetworkSimulator&) = delete;
+    NetworkSimulator& operator=(const NetworkSimulator&) = delete;
+
+    /// @brief applies the current conditions to the packet
+    /// @note if the conditions are perfect the packet is passed on right away from the calling thread
+    /// @note otherwise the packet is copied so the given packet is left untouched
+    void push(sf::Packet& packet, sf::IpAddress ip, unsigned short port);
+    /// @brief stops the simulator thread
+    /// @param deliverPending if true every packet that is still waiting is passed on right away, otherwise they are dropped
+    /// @note if called from the simulator thread its self the thread is detached instead of joined
+    void stop(bool deliverPending);
+
+    /// @note can be changed at any time, only effects packets pushed after the change
+    void setConditions(const NetworkConditions& conditions);
+    NetworkConditions getConditions() const;
+    /// @returns true if the current conditions change packets in any way
+    bool isEnabled() const;
+    /// @brief restarts the random number generator with the given seed
+    void setSeed(std::uint64_t seed);
+    /// @returns the number of packets waiting to be passed on
+    std::size_t getPendingCount() const;
+    NetworkSimulatorStats getStats() const;
+    void resetStats();
+
+protected:
+    struct Pending
+    {
+        Clock::time_point time;
+        /// @brief keeps packets with the same time in order
+        std::uint64_t sequence;
+        sf::Packet packet;
+        sf::IpAddress ip;
+        unsigned short port;
+
+        inline bool operator>(const Pending& other) const
+        {
+            if (time != other.time)
+                return time > other.time;
+            return sequence > other.sequence;
+        }
+    };
+
+    void m_thread_function(std::stop_token sToken);
+    /// @note must be called with m_mutex locked
+    void m_schedule(const sf::Packet& packet, sf::IpAddress ip, unsigned short port, Clock::time_point time);
+    Clock::duration m_seconds(float seconds) const;
+
+private:
+    DeliverFunction m_deliver;
+    NetworkConditions m_conditions;
+    std::atomic<bool> m_enabled = false;
+    std::mt19937_64 m_random;
+    std::uniform_real_distribution<float> m_chance{0.f, 1.f};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> m_pending;
+    std::uint64_t m_nextSequence = 0;
+    /// @brief when the simulated link is done sending the packets before it
+    Clock::time_point m_linkFreeTime;
+    std::jthread* m_thread = nullptr;
+
+    //* Stats
+
+        std::atomic<std::uint64_t> m_packets = 0;
+        std::atomic<std::uint64_t> m_delivered = 0;
+        std::atomic<std::uint64_t> m_lost = 0;
+        std::atomic<std::uint64_t> m_queueDropped = 0;
+        std::atomic<std::uint64_t> m_duplicated = 0;
+        std::atomic<std::uint64_t> m_reordered = 0;
+
+    // ------
+};
+
+}
+
+#endif
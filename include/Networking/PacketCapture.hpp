@@ -0,0 +1,195 @@
+#ifndef PACKET_CAPTURE_HPP
+#define PACKET_CAPTURE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include <SFML/Network/IpAddress.hpp>
+
+#include "Networking/MessageQueue.hpp"
+
+namespace udp
+{
+
+/// @brief the kind of file a PacketCapture writes
+enum class CaptureFormat : std::uint8_t
+{
+    /// @brief standard pcap (sent and received packets)
+    Pcap = 0,
+    /// @brief compact log of received packets that can be replayed into a socket with TrafficReplay
+    Replay = 1
+};
+
+/// @brief the replay log layout (every value is little endian)
+/// @note header: magic (u32), version (u32), wall clock time the file was started in nanoseconds since the unix epoch (u64)
+/// @note record: nanoseconds since the last record (varint), sender ip (u32), sender port (u16), size (varint), data
+/// @note record times come from a steady clock (the first record is timed from when the file was started) so changes to the wall clock do not change them
+struct ReplayLogFormat
+{
+    static constexpr std::uint32_t MAGIC = 0x4C504455; // "UDPL"
+    /// @brief 2 added the connection ID to the packet header (see PACKET_HEADER_SIZE) so older logs can not be replayed
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::size_t HEADER_SIZE = 16;
+};
+
+/// @brief settings for a PacketCapture
+struct CaptureOptions
+{
+    CaptureFormat format = CaptureFormat::Pcap;
+    /// @brief the file to write to
+    /// @note if the capture rotates files a number is added before the extension (i.e. capture.pcap -> capture.0.pcap, capture.1.pcap)
+    std::string path = "capture.pcap";
+    /// @brief start a new file once the current one reaches this many bytes (0 for no limit)
+    std::uint64_t maxFileSize = 0;
+    /// @brief start a new file once the current one has been open this many seconds (0 for no limit)
+    float maxFileTime = 0.f;
+    /// @brief the oldest files are deleted once there are more than this many (0 keeps every file)
+    std::size_t maxFiles = 0;
+    /// @brief only 1 out of every sampleRate packets is captured (1 captures everything)
+    std::uint32_t sampleRate = 1;
+    /// @brief the most bytes of each packet that are written (the rest is cut off like tcpdump -s)
+    /// @note not used by the replay format since cut packets could not be replayed
+    std::uint32_t snapLength = 65535;
+    /// @brief the max number of packets waiting to be written, any packets captured while it is full are dropped
+    /// @note rounded up to the next power of two
+    std::size_t queueCapacity = 8192;
+};
+
+/// @brief counters kept by a PacketCapture
+struct CaptureStats
+{
+    /// @brief packets that were written
+    std::uint64_t written = 0;
+    /// @brief packets that were skipped by sampling
+    std::uint64_t sampledOut = 0;
+    /// @brief packets dropped because the queue was full
+    std::uint64_t dropped = 0;
+    /// @brief bytes written to every file (including headers)
+    std::uint64_t bytesWritten = 0;
+    /// @brief number of files that have been opened
+    std::uint64_t files = 0;
+    std::uint64_t writeErrors = 0;
+};
+
+/// @brief writes packets sent and received by sockets to pcap files that can be opened with wireshark or tcpdump
+///        or to replay logs (see CaptureFormat)
+/// @note IPv4 and UDP headers are made up for every pcap packet since only the payload is known (link type raw IPv4)
+/// @note capturing only copies the packet into a lock-free queue, the file is written on the captures own thread
+/// @note can be given to any number of sockets with Socket::setCapture
+class PacketCapture
+{
+public:
+    PacketCapture(const CaptureOptions& options = {});
+    ~PacketCapture();
+
+    PacketCapture(const PacketCapture&) = delete;
+    PacketCapture& operator=(const PacketCapture&) = delete;
+
+    /// @brief opens the first file and starts the writer thread
+    /// @returns false if the file could not be opened
+    bool start();
+    /// @brief writes every packet that is still queued then closes the file
+    void stop();
+    /// @returns true if packets are being captured
+    inline bool isRunning() const
+    {
+        return m_running.load(std::memory_order_relaxed);
+    }
+
+    /// @brief queues the packet to be written
+    /// @note does nothing if the capture is not running
+    /// @note safe to call from any thread
+    /// @param outgoing true if the local socket sent the packet
+    /// @param peerIP the ip the packet was sent to or received from
+    void capture(const void* data, std::size_t size, bool outgoing, sf::IpAddress peerIP, unsigned short peerPort, unsigned short localPort);
+
+    /// @note only takes effect on the next call to start
+    void setOptions(const CaptureOptions& options);
+    CaptureOptions getOptions() const;
+    CaptureStats getStats() const;
+    /// @returns the path of the file that is being written (empty if not running)
+    std::string getCurrentPath() const;
+
+protected:
+    struct Record
+    {
+        /// @brief wall clock time in nanoseconds since the unix epoch for pcap,
+        ///        steady clock time in nanoseconds for replay logs (only the differences between records are written)
+        std::int64_t time = 0;
+        std::uint32_t sourceIP = 0;
+        std::uint32_t destinationIP = 0;
+        unsigned short sourcePort = 0;
+        unsigned short destinationPort = 0;
+        /// @brief the size before being cut to the snap length
+        std::uint32_t originalSize = 0;
+        std::vector<std::uint8_t> data;
+    };
+
+    void m_thread_function(std::stop_token sToken);
+    /// @brief opens the next file and writes the pcap header
+    bool m_open_file();
+    void m_close_file();
+    void m_write_record(const Record& record);
+    /// @brief writes the record in the pcap format to the write buffer
+    void m_encode_pcap(const Record& record);
+    /// @brief writes the record in the replay format to the write buffer
+    void m_encode_replay(const Record& record);
+    /// @returns the path for the file with the given index
+    std::string m_file_path(std::uint64_t index) const;
+    /// @brief copies the packet into the queue (capture without the running check)
+    void m_capture(const void* data, std::size_t size, bool outgoing, sf::IpAddress peerIP, unsigned short peerPort, unsigned short localPort);
+
+private:
+    CaptureOptions m_options;
+    /// @brief the address used as the local side of packets to non loopback peers
+    std::uint32_t m_localIP = 0;
+
+    std::atomic<bool> m_running = false;
+    /// @brief captures that may have seen the capture running and could still be using the queue
+    /// @note stop waits for this to reach 0 so start can safely reset the queue
+    std::atomic<std::uint32_t> m_inFlight = 0;
+    std::atomic<std::uint64_t> m_sampleCounter = 0;
+    MessageQueue<Record> m_queue;
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::jthread* m_thread = nullptr;
+
+    //* Writer Thread Variables (only used by the writer thread while running)
+
+        std::FILE* m_file = nullptr;
+        /// @brief the index of the next file (atomic so the current path can be read from other threads)
+        std::atomic<std::uint64_t> m_fileIndex = 0;
+        std::uint64_t m_fileSize = 0;
+        std::chrono::steady_clock::time_point m_fileOpenTime;
+        std::vector<std::string> m_filePaths;
+        std::uint16_t m_nextIPID = 0;
+        /// @brief the steady clock time of the last record written to the current replay log
+        std::int64_t m_lastRecordTime = 0;
+        std::vector<std::uint8_t> m_writeBuffer;
+
+    // ------------------------------------------------------------------
+
+    //* Stats
+
+        std::atomic<std::uint64_t> m_written = 0;
+        std::atomic<std::uint64_t> m_sampledOut = 0;
+        std::atomic<std::uint64_t> m_dropped = 0;
+        std::atomic<std::uint64_t> m_bytesWritten = 0;
+        std::atomic<std::uint64_t> m_files = 0;
+        std::atomic<std::uint64_t> m_writeErrors = 0;
+
+    // ------
+};
+
+}
+
+#endif
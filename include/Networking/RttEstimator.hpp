@@ -0,0 +1,59 @@
+#ifndef RTT_ESTIMATOR_HPP
+#define RTT_ESTIMATOR_HPP
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace udp
+{
+
+/// @brief keeps a smoothed round trip time and clock offset from ping/pong samples
+/// @note samples must only be added from one thread at a time, the getters can be called from any thread
+/// @note all times are in seconds
+class RttEstimator
+{
+public:
+    /// @brief adds a sample using the four NTP style timestamps (in microseconds)
+    /// @param originTime when the ping was sent (local clock)
+    /// @param receiveTime when the ping was received (remote clock)
+    /// @param transmitTime when the pong was sent (remote clock)
+    /// @param arrivalTime when the pong was received (local clock)
+    void addSample(std::int64_t originTime, std::int64_t receiveTime, std::int64_t transmitTime, std::int64_t arrivalTime);
+    void reset();
+
+    /// @returns true if at least one sample has been added
+    bool hasSample() const;
+    /// @returns the smoothed round trip time
+    double getRTT() const;
+    /// @returns the round trip time variance (mean deviation)
+    double getRTTVariance() const;
+    /// @returns the last round trip time sample
+    double getLastRTT() const;
+    /// @returns the offset that has to be added to the local clock to get the remote clock
+    /// @note taken from the sample with the lowest round trip time out of the last few samples
+    double getClockOffset() const;
+
+private:
+    struct Sample
+    {
+        double rtt = 0.0;
+        double offset = 0.0;
+    };
+
+    /// @brief the last few samples used for filtering the clock offset
+    std::array<Sample, 8> m_samples;
+    std::size_t m_sampleCount = 0;
+
+    std::atomic<bool> m_hasSample = false;
+    std::atomic<double> m_rtt = 0.0;
+    std::atomic<double> m_rttVariance = 0.0;
+    std::atomic<double> m_lastRTT = 0.0;
+    std::atomic<double> m_clockOffset = 0.0;
+};
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef SEND_QUEUE_HPP
+#define SEND_QUEUE_HPP
+
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
+#include <SFML/Network/Packet.hpp>
+#include <SFML/Network/IpAddress.hpp>
+
+#include "Networking/Transport.hpp"
+
+namespace udp
+{
+
+/// @brief what happened to a packet that was sent
+enum class SendResult : std::uint8_t
+{
+    /// @brief handed to the transport (or to shared memory or the outgoing network simulator)
+    Sent = 0,
+    /// @brief the transport would have blocked so the packet is waiting in the send queue of its destination
+    Queued = 1,
+    /// @brief the send queue of the destination was full and the packet was thrown away (see SendQueuePolicy)
+    Dropped = 2,
+    /// @brief the transport could not send the packet (i.e. the destination is unreachable)
+    Failed = 3,
+    /// @brief there is nothing to send to (the client was not found or the client is not connected)
+    NotConnected = 4
+};
+
+/// @returns true if the packet was sent or is waiting to be sent
+inline bool isAccepted(SendResult result)
+{
+    return result == SendResult::Sent || result == SendResult::Queued;
+}
+
+/// @brief what is thrown away when a packet is queued for a destination whose queue is full
+enum class SendQueuePolicy : std::uint8_t
+{
+    /// @brief the new packet is dropped (SendResult::Dropped)
+    DropNewest = 0,
+    /// @brief the oldest queued packet is dropped to make room for the new one (SendResult::Queued)
+    /// @note better for state updates where only the latest packet matters
+    DropOldest = 1
+};
+
+/// @brief what happened while flushing a SendQueue
+struct SendQueueFlush
+{
+    std::size_t packets = 0;
+    std::size_t bytes = 0;
+    /// @brief packets that the transport failed to send (they are thrown away)
+    std::size_t failures = 0;
+    /// @brief if the transport would have blocked before every packet was sent
+    bool wouldBlock = false;
+};
+
+/// @brief bounded queues of packets by destination that wait for the transport to be writable again
+/// @note a packet is only queued once the transport would block, after that every packet to the same destination is queued behind it
+///       until the queue is flushed so the packets to each destination stay in order
+/// @note thread safe
+class SendQueue
+{
+public:
+    /// @param capacity the max number of packets queued for each destination
+    SendQueue(std::size_t capacity = 256, SendQueuePolicy policy = SendQueuePolicy::DropNewest);
+
+    /// @brief sets the max number of packets queued for each destination
+    /// @note if a queue is already larger than this nothing is dropped until it is flushed
+    void setCapacity(std::size_t capacity);
+    std::size_t getCapacity() const;
+    void setPolicy(SendQueuePolicy policy);
+    SendQueuePolicy getPolicy() const;
+
+    /// @brief copies the packet to the end of the queue for the destination
+    /// @param dropped set to true if a packet was thrown away to stay in the capacity (the new one or the oldest one)
+    /// @returns SendResult::Queued or SendResult::Dropped if the new packet was not queued
+    SendResult push(const sf::Packet& packet, sf::IpAddress ip, unsigned short port, bool& dropped);
+    /// @brief sends the packet unless packets are already waiting for the destination, it is queued if it has to wait
+    /// @note while anything is queued the check, the send, and the push are done under one lock so the packet can not go ahead
+    ///       of one that another thread is queueing for the same destination
+    /// @param dropped set to true if a packet was thrown away to stay in the capacity (the new one or the oldest one)
+    /// @returns SendResult::Sent, SendResult::Queued, SendResult::Dropped, or SendResult::Failed if the transport could not send it
+    SendResult send(Transport& transport, sf::Packet& packet, sf::IpAddress ip, unsigned short port, bool& dropped);
+    /// @brief same as send but the packets are given to the transport together and the ones it could not send are queued in order
+    /// @param sent set to the number of packets from the front that were sent
+    /// @param dropped set to the number of packets thrown away to stay in the capacity
+    /// @returns SendResult::Sent if every packet was sent otherwise what happened to the first packet that was not
+    SendResult sendBatch(Transport& transport, std::span<sf::Packet> packets, sf::IpAddress ip, unsigned short port, std::size_t& sent, std::size_t& dropped);
+    /// @brief sends queued packets to the transport, taking one packet from each destination in turn so no destination is starved
+    /// @note stops at the first send that would block
+    SendQueueFlush flush(Transport& transport);
+    /// @brief throws away every queued packet
+    void clear();
+
+    /// @returns true if nothing is queued for any destination
+    /// @note does not lock so this can be checked before every send
+    bool empty() const;
+    /// @returns the number of packets queued for every destination combined
+    std::size_t size() const;
+    /// @returns the number of packets queued for the destination
+    std::size_t size(sf::IpAddress ip, unsigned short port) const;
+
+private:
+    /// @note m_mutex must be locked
+    SendResult m_push(const sf::Packet& packet, std::uint64_t key, bool& dropped);
+    /// @brief pushes every packet in order
+    /// @param dropped increased by the number of packets thrown away
+    /// @returns what happened to the first packet
+    /// @note m_mutex must be locked
+    SendResult m_push_all(std::span<sf::Packet> packets, std::uint64_t key, std::size_t& dropped);
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::uint64_t, std::deque<sf::Packet>> m_queues;
+    std::atomic<std::size_t> m_size = 0;
+    std::size_t m_capacity;
+    SendQueuePolicy m_policy;
+};
+
+}
+
+#endif
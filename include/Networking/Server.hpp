@@ -3,26 +3,65 @@
 
 #pragma once
 
-#include <unordered_set>
+#include <mutex>
+#include <shared_mutex>
 
 #include "Socket.hpp"
 #include "ClientData.hpp"
+#include "ClientPool.hpp"
 
 namespace udp
 {
 
 class Server : public Socket
 {
+public:
+    /// @brief the most clients that can be connected at once
+    static constexpr std::uint32_t MAX_CLIENTS = ClientPool::MAX_CLIENTS;
+    /// @brief the least time between path challenges sent to the same new address of a client
+    static constexpr std::chrono::milliseconds PATH_CHALLENGE_INTERVAL{250};
+
 private:  
 
     //* Server Variables and Functions
 
-        /// @brief first value is for the ID and the second is for the client data
-        std::unordered_set<ClientData*> m_clientData;
+        /// @brief every client by its connection ID and its address
+        ClientPool m_clients;
+        /// @brief reused by the update thread so finding timed out clients and pings to send does not allocate every tick
+        std::vector<ID> m_timedOut;
+        std::vector<ClientData*> m_pingsDue;
+        /// @brief guards the client data as clients are added and removed from the receive thread while other threads look them up
+        mutable std::shared_mutex m_clientMutex;
         std::atomic<bool> m_allowClientConnection = true;
+        /// @brief the per client metrics published every second by the update thread so getMetrics does not take the client or send queue locks
+        std::vector<ClientMetricsSnapshot> m_clientMetrics;
+        /// @brief the rows the update thread is building, swapped with m_clientMetrics once they are done
+        /// @note only used by the update thread
+        std::vector<ClientMetricsSnapshot> m_clientMetricsBack;
+        /// @brief guards m_clientMetrics, only held to copy or swap it
+        mutable std::mutex m_clientMetricsMutex;
 
         /// @returns the clientData ptr or nullptr if no client found with given id
-        ClientData* m_getClientData(ID clientID);
+        /// @note m_clientMutex must be locked
+        ClientData* m_getClientData(ID clientID) const;
+        /// @brief finds the client that sent the packet being handled by its connection ID or by its address if the ID is not known
+        /// @note the address is only used for packets that do not have a known connection ID (i.e. before the client is confirmed)
+        /// @note if the ID is known but the address is not (i.e. a NAT rebinding or a spoofed packet) the new address is challenged
+        ///       and nullptr is returned, the client is only moved once it answers (see m_parse_path_response)
+        /// @param lock a shared lock on m_clientMutex, unlocked for a moment if a challenge has to be sent
+        /// @returns the clientData ptr or nullptr if the sender is not a client at this address
+        ClientData* m_get_sender(sf::IpAddress ip, PORT port, std::shared_lock<std::shared_mutex>& lock);
+        /// @brief sends a path challenge to the new address of the client unless one was sent there within PATH_CHALLENGE_INTERVAL
+        /// @param lock a shared lock on m_clientMutex, unlocked while the challenge is made and sent
+        void m_challenge_path(ID id, sf::IpAddress ip, PORT port, std::shared_lock<std::shared_mutex>& lock);
+        /// @brief adds the client if it is not already connected
+        /// @param added set to true if the client was added
+        /// @param token set to the path token of the client
+        /// @returns the connection ID of the client or 0 if there is no room for another client
+        ID m_add_client(sf::IpAddress ip, PORT port, bool& added, std::uint64_t& token);
+        /// @brief adds the client if it is not already connected and sends it the connection confirmation
+        /// @note if the server is full the connection is closed instead
+        void m_confirm_client(sf::IpAddress ip, PORT port);
 
         virtual void m_update_function(float deltaTime) override;
         /// @brief the function to be called every second in update
@@ -43,6 +82,13 @@ private:
         virtual void m_parse_connection_request(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
         virtual void m_parse_connection_close(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
         virtual void m_parse_password(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_request(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_response(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_ping(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_pong(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        virtual void m_parse_shared_memory_offer(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
+        /// @brief moves the client to the address the response came from if it answers the challenge sent there with the clients token
+        virtual void m_parse_path_response(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort) override;
 
     // -------------------------
 
@@ -80,24 +126,52 @@ public:
         /// @param reason the reason for the disconnect that the client will receive
         /// @returns true if the client was removed returns false if it was not found
         bool disconnectClient(ID id, const std::string& reason);
-        /// @returns a pointer to the clients map
-        const std::unordered_set<ClientData*>& getClients() const;
+        /// @returns every client (iterates as ClientData*)
+        /// @warning not thread safe, clients can be added or removed by the receive thread while this is used
+        const ClientPool& getClients() const;
         /// @returns the number of clients
         std::uint32_t getClientsSize() const;
         /// @returns the clientData ptr or nullptr if no client found with given id
         const ClientData* getClientData(ID clientID) const;
+        /// @returns true if the client with the given ID is connected
+        /// @note IDs are never reused while the client is connected and the ID of a disconnected client stays invalid even once
+        ///       its slot is given to a new client (until the slot has been reused 65535 times)
+        bool isClientConnected(ID clientID) const;
+        /// @returns a copy of the round trip times of the client with the given ID or std::nullopt if the client was not found
+        /// @note thread safe unlike getClientData(id)->getRTTHistogram()
+        std::optional<HistogramSnapshot> getClientRTTHistogram(ID clientID) const;
+        /// @returns the traffic of the client with the given ID for each of the last TrafficHistory::CAPACITY seconds (oldest first)
+        ///          or std::nullopt if the client was not found
+        std::optional<std::vector<TrafficSample>> getClientTrafficHistory(ID clientID) const;
+        /// @returns the number of packets waiting for the transport to send to the client or std::nullopt if the client was not found
+        std::optional<std::size_t> getClientSendQueueSize(ID clientID) const;
         /// @brief Sends the given packet to every client currently connected
         /// @param blacklist the list of client IDs NOT to send this packet to
-        void sendToAll(sf::Packet& packet, std::list<ID> blacklist = {});
+        /// @note clients whose send queue is full miss the packet (see setSendQueuePolicy)
+        /// @returns the number of clients the packet was sent or queued to
+        std::size_t sendToAll(sf::Packet& packet, std::list<ID> blacklist = {});
         /// @brief tries to send the given packet to the client with the given ID
-        /// @returns if the packet was sent (false if client was not found)
-        bool sendTo(sf::Packet& packet, ID id);
+        /// @returns what happened to the packet (SendResult::NotConnected if the client was not found)
+        SendResult sendTo(sf::Packet& packet, ID id);
+        /// @brief tries to send every packet to the client with the given ID in as few sends as the transport can
+        /// @note packets of the same size are sent together so a snapshot split into equal sized packets is the fastest to send
+        /// @returns SendResult::Sent if every packet was sent otherwise what happened to the first packet that was not
+        SendResult sendBatchTo(std::span<sf::Packet> packets, ID id);
         /// @brief sets if clients are allowed to connect with or without the password
         /// @note if there is a password the client still needs to enter it (if true)
         /// @note if false the client cannot connect until set true
         void allowClientConnection(bool allowed = true);
         /// @returns true if clients are able to connect
         bool isClientConnectionAllowed();
+        /// @brief sends the given message as a request to the client with the given ID and waits for the response
+        /// @note the client must have a request handler set to respond
+        /// @param message the request data (should not include any packet template)
+        /// @returns the response or std::nullopt if the client was not found, the request timed out, or the connection closed
+        Awaitable<std::optional<Message>> request(ID id, const sf::Packet& message, sf::Time timeout = sf::seconds(5));
+        /// @returns the socket metrics and the metrics for every client
+        /// @note the client rows are built once a second by the update thread so they can be up to a second old,
+        ///       copying them does not take any lock that the network threads use
+        virtual MetricsSnapshot getMetrics() const override;
 
         //* Pure Virtual Definitions
             
@@ -0,0 +1,109 @@
+#ifndef SHARED_MEMORY_CHANNEL_HPP
+#define SHARED_MEMORY_CHANNEL_HPP
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+#include <SFML/Network/Packet.hpp>
+
+namespace udp
+{
+
+/// @brief a shared memory word that a process sleeps on until another process rings it
+/// @note only supported on linux (memfd and futex), create returns nullptr on other platforms
+class SharedMemoryDoorbell
+{
+public:
+    /// @returns a new doorbell or nullptr if shared memory is not supported
+    static std::unique_ptr<SharedMemoryDoorbell> create();
+    /// @brief maps a doorbell that was created by another process
+    /// @returns nullptr if the doorbell could not be opened
+    static std::unique_ptr<SharedMemoryDoorbell> open(std::uint32_t pid, std::int32_t fd);
+    ~SharedMemoryDoorbell();
+
+    SharedMemoryDoorbell(const SharedMemoryDoorbell&) = delete;
+    SharedMemoryDoorbell& operator=(const SharedMemoryDoorbell&) = delete;
+
+    /// @returns the file descriptor that other processes can open the doorbell with (-1 if this was opened from another process)
+    std::int32_t getFD() const;
+    /// @brief wakes up the process waiting on this doorbell
+    /// @note only makes a system call if something is actually waiting
+    void ring();
+    /// @brief marks that the owner is about to wait
+    /// @note anything that should wake the owner must be checked again after this is called
+    /// @returns the value that has to be given to wait
+    std::uint32_t prepareWait();
+    /// @brief sleeps until the doorbell is rung or the timeout is reached
+    void wait(std::uint32_t signal, int timeoutMilliseconds);
+    /// @brief used instead of wait if there turned out to be something to do after prepareWait
+    void cancelWait();
+
+protected:
+    struct Data;
+
+    SharedMemoryDoorbell(std::int32_t fd, Data* data);
+
+private:
+    std::int32_t m_fd = -1;
+    Data* m_data = nullptr;
+};
+
+/// @brief a pair of single producer single consumer rings in shared memory for two processes on the same host
+/// @note only supported on linux, create returns nullptr on other platforms
+/// @note send can be called from any thread (guarded by a local lock), receive must only be called from one thread
+class SharedMemoryChannel
+{
+public:
+    /// @brief the size of each ring in bytes
+    static constexpr std::uint32_t RING_SIZE = 1 << 20;
+
+    /// @returns a new channel or nullptr if shared memory is not supported
+    static std::shared_ptr<SharedMemoryChannel> create();
+    /// @brief maps a channel that was created by another process
+    /// @returns nullptr if the channel could not be opened or is not valid
+    static std::shared_ptr<SharedMemoryChannel> open(std::uint32_t pid, std::int32_t fd);
+    ~SharedMemoryChannel();
+
+    SharedMemoryChannel(const SharedMemoryChannel&) = delete;
+    SharedMemoryChannel& operator=(const SharedMemoryChannel&) = delete;
+
+    /// @returns the file descriptor that the other process can open the channel with (-1 if this was opened from another process)
+    std::int32_t getFD() const;
+    /// @brief sets the doorbell that is rung every time a packet is sent
+    void setRemoteDoorbell(std::unique_ptr<SharedMemoryDoorbell> doorbell);
+    /// @brief copies the packet into the ring going to the other process
+    /// @returns false if the ring is full or the packet is too big (should be sent some other way)
+    bool send(const sf::Packet& packet);
+    /// @brief copies the oldest packet from the ring coming from the other process
+    /// @returns false if there are no packets
+    bool receive(sf::Packet& packet);
+    /// @returns true if there is at least one packet waiting to be received
+    bool hasData() const;
+
+protected:
+    struct Header;
+    struct Ring;
+
+    SharedMemoryChannel(std::int32_t fd, Header* header, bool creator);
+
+private:
+    std::int32_t m_fd = -1;
+    Header* m_header = nullptr;
+    /// @brief the ring this side writes to
+    Ring* m_sendRing = nullptr;
+    std::uint8_t* m_sendData = nullptr;
+    /// @brief the ring this side reads from
+    Ring* m_receiveRing = nullptr;
+    std::uint8_t* m_receiveData = nullptr;
+    std::mutex m_sendMutex;
+    std::unique_ptr<SharedMemoryDoorbell> m_remoteDoorbell = nullptr;
+};
+
+}
+
+#endif
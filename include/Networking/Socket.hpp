@@ -4,10 +4,31 @@
 #pragma once
 
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <shared_mutex>
 
-#include <SFML/Network/UdpSocket.hpp>
 #include <SFML/Network/Packet.hpp>
-
+#include <SFML/System/Time.hpp>
+
+#include "Networking/TickScheduler.hpp"
+#include "Networking/MessageQueue.hpp"
+#include "Networking/Coroutine.hpp"
+#include "Networking/RttEstimator.hpp"
+#include "Networking/NetworkSimulator.hpp"
+#include "Networking/Transport.hpp"
+#include "Networking/SendQueue.hpp"
+#include "Networking/SharedMemoryChannel.hpp"
+#include "Networking/Metrics.hpp"
+#include "Networking/Histogram.hpp"
+#include "Networking/TrafficHistory.hpp"
+#include "Networking/PacketCapture.hpp"
 #include "Utils/funcHelper.hpp"
 #include "Utils/EventHelper.hpp"
 
@@ -40,6 +61,21 @@ typedef std::optional<sf::IpAddress> IpAddress_t;
 typedef std::uint32_t ID;
 typedef unsigned short PORT;
 
+/// @brief a data packet that was received and queued for polling
+struct Message
+{
+    /// @brief the packet data (read position is after the packet header)
+    sf::Packet packet;
+    /// @brief the senders ID (for servers this is the connection ID of the client, for clients the servers IP as an integer)
+    ID sender = 0;
+    /// @brief when the packet was received (nanoseconds on the steady clock)
+    std::uint64_t receiveTime = 0;
+    /// @brief when the packet arrived at the transport before it was received (nanoseconds on the steady clock)
+    /// @note 0 unless kernel timestamps are enabled (see Socket::setKernelTimestampsEnabled),
+    ///       receiveTime - arrivalTime is the time spent in the socket buffer and waiting for the receive thread
+    std::uint64_t arrivalTime = 0;
+};
+
 enum class PacketType : std::int8_t
 {
     Data = 0,
@@ -47,17 +83,54 @@ enum class PacketType : std::int8_t
     ConnectionClose = 2,
     ConnectionConfirm = 3,
     PasswordRequest = 4,
-    Password = 5
+    Password = 5,
+    Request = 6,
+    Response = 7,
+    Ping = 8,
+    Pong = 9,
+    SharedMemoryOffer = 10,
+    SharedMemoryAccept = 11,
+    /// @brief sent by the server to a new address of a client before the client is moved there
+    PathChallenge = 12,
+    /// @brief the answer to a path challenge
+    PathResponse = 13
 };
 
-class Socket : protected sf::UdpSocket
+/// @brief the number of packet types (one more than the largest PacketType)
+constexpr std::size_t PACKET_TYPE_COUNT = 14;
+
+/// @brief every packet starts with its type (int8) followed by the connection ID of the sender (uint32)
+/// @note clients send the ID the server gave them (0 until they have one) and servers always send 0,
+///       the ID is written by the socket when the packet is sent so templates leave it as 0
+/// @note servers find the client by this ID instead of the senders address so clients keep their connection if their address changes,
+///       a packet with a known ID from a new address is only taken once the client answers a path challenge sent to that address
+constexpr std::size_t PACKET_HEADER_SIZE = 5;
+
+/// @brief called when a request is received
+/// @param request the request data (read position is after the request header)
+/// @param sender the ID of the sender
+/// @param response the data to send back (already has the response header, append the response data)
+typedef std::function<void(sf::Packet& request, ID sender, sf::Packet& response)> RequestHandler;
+
+class TrafficReplay;
+
+class Socket
 {
+    /// @brief replays packets through the packet handling without a transport
+    friend TrafficReplay;
+
 protected:
 
     //* Connection Data
     
-        /// @brief comes from the public IP
+        /// @brief for clients this is the connection ID given by the server (0 until assigned)
+        /// @note sent in the header of every packet
         ID m_id = 0;
+        /// @brief for clients this is the ip the server sees this client as (0 until connected)
+        std::uint32_t m_ip = 0;
+        /// @brief if set this is used instead of the shared public IP lookup
+        /// @note the ip is in the low 32 bits and bit 32 is set if there is one so it can be read from any thread
+        std::atomic<std::uint64_t> m_publicIP = 0;
         bool m_needsPassword = false;
         std::string m_password = "";
         unsigned short m_port = 777;
@@ -66,7 +139,15 @@ protected:
         /// @brief time that the connection has been up
         double m_connectionTime = 0.f;
         float m_timeoutTime = 20.f; 
+        /// @brief seconds between pings (0 for no pings)
+        float m_pingInterval = 1.f;
         funcHelper::func<void> m_packetSendFunction = {[](){}};
+        /// @brief what packets are sent and received through
+        std::unique_ptr<Transport> m_transport = std::make_unique<UdpTransport>();
+        /// @brief given to every transport that is set
+        SocketBufferSizes m_bufferSizes;
+        bool m_kernelTimestamps = false;
+        bool m_offloadEnabled = true;
 
     // ----------------
 
@@ -78,12 +159,46 @@ protected:
         std::stop_source* m_sSource = nullptr;
         // receiving thread
         std::jthread* m_receiveThread = nullptr;
+        // set once the receiving thread has left its loop (shared with the thread so it can still notify once this socket is gone)
+        std::shared_ptr<std::atomic<bool>> m_receiveThreadDone = std::make_shared<std::atomic<bool>>(true);
+        // the ID of the last receiving thread started (so it is never made to wait for its self)
+        std::atomic<std::thread::id> m_receiveThreadID;
         // sending/updating thread
         std::jthread* m_updateThread = nullptr;
+        // set once the updating thread has left its loop (shared with the thread so it can still notify once this socket is gone)
+        std::shared_ptr<std::atomic<bool>> m_updateThreadDone = std::make_shared<std::atomic<bool>>(true);
+        // the ID of the last updating thread started (so it is never made to wait for its self)
+        std::atomic<std::thread::id> m_updateThreadID;
+        // guards starting and stopping the threads
+        std::mutex m_threadMutex;
+        // if data packets are queued for polling instead of invoking onDataReceived
+        std::atomic<bool> m_queueMessages = false;
+        // received data waiting to be polled
+        MessageQueue<Message> m_messageQueue{1024};
+        // packet, byte, drop, and connection counters
+        SocketMetrics m_metrics;
+        // per second samples of the socket traffic
+        TrafficHistory m_trafficHistory;
+        // if the latency histograms are being recorded
+        std::atomic<bool> m_histogramsEnabled = true;
+        // time from a packet being received to its data being handed to onDataReceived, a receive, or poll
+        Histogram m_receiveLatencyHistogram;
+        // time from a packet arriving at the transport to it being received (only with kernel timestamps)
+        Histogram m_receiveDelayHistogram;
+        // time spent parsing and handling each packet type (includes onDataReceived and the request handler)
+        std::array<Histogram, PACKET_TYPE_COUNT> m_handlerHistograms;
+        // time spent in each update (not including the wait for the next update)
+        Histogram m_tickHistogram;
+        // every round trip time sample (for a server this is every client combined)
+        Histogram m_rttHistogram;
+        // packets waiting for the transport to be writable, flushed every update and before every send
+        SendQueue m_sendQueue;
+        // every packet sent and received is given to this if it is set
+        std::shared_ptr<PacketCapture> m_capture = nullptr;
         // if we should be sending packets in the thread
         bool m_sendingPackets = true;
-        // in updates/second
-        unsigned int m_socketUpdateRate = 64;
+        // keeps the update thread at the update rate (in updates/second)
+        TickScheduler m_tickScheduler{64};
 
         /// @brief called every update (at the socket update rate)
         /// @note must be thread safe
@@ -94,6 +209,13 @@ protected:
         virtual void m_second_update_function() = 0;
         virtual void m_receive_packets_thread(std::stop_token sToken);
         virtual void m_update_thread(std::stop_token sToken);
+        /// @brief waits for any thread that detached its self to finish
+        /// @note does not wait for the thread this is called from
+        /// @note a thread detaches when it closes the connection its self (i.e. the server closed it or the client timed out) so it can still be using this socket
+        /// @note must be called by derived destructors after stopThreads and before their members are destroyed
+        void m_wait_for_threads();
+        /// @brief waits until done is set unless the given thread is the one calling this
+        static void m_wait_for_thread(const std::shared_ptr<std::atomic<bool>>& done, const std::atomic<std::thread::id>& threadID);
 
     // -------------------------
 
@@ -104,6 +226,54 @@ protected:
     
     // ---------------------
 
+    //* Coroutine Variables and Functions
+
+        struct PendingRequest
+        {
+            std::shared_ptr<AsyncState<std::optional<Message>>> state;
+            /// @brief the ID that the response must come from
+            ID receiver = 0;
+            std::chrono::steady_clock::time_point deadline;
+        };
+
+        // guards the resume queue and if the update thread is resuming coroutines
+        std::mutex m_resumeMutex;
+        // coroutines waiting to be resumed on the update thread
+        std::vector<std::coroutine_handle<>> m_resumeQueue;
+        bool m_resumeOnUpdateThread = false;
+        // guards the receive waiters and pending requests
+        std::mutex m_awaitMutex;
+        std::deque<std::shared_ptr<AsyncState<std::optional<Message>>>> m_receiveWaiters;
+        std::atomic<std::size_t> m_receiveWaiterCount = 0;
+        std::unordered_map<std::uint32_t, PendingRequest> m_pendingRequests;
+        std::atomic<std::uint32_t> m_nextRequestID = 1;
+        RequestHandler m_requestHandler = nullptr;
+
+        /// @brief resumes the given coroutine on the update thread
+        /// @note if the update thread is not running the coroutine is resumed right away
+        void m_schedule_resume(std::coroutine_handle<> handle);
+        /// @brief resumes all the coroutines that are waiting to be resumed
+        /// @note should only be called on the update thread
+        void m_resume_scheduled();
+        /// @brief completes any requests that have passed their deadline
+        void m_expire_requests();
+        /// @brief completes every pending receive and request with std::nullopt
+        virtual void m_cancel_awaiting();
+        /// @brief adds a receive that a coroutine is now waiting on
+        /// @note completes it with std::nullopt right away if the connection is closed
+        void m_add_receive_waiter(const std::shared_ptr<AsyncState<std::optional<Message>>>& state);
+        /// @brief removes a receive whose coroutine was destroyed before it got any data
+        void m_remove_receive_waiter(const std::shared_ptr<AsyncState<std::optional<Message>>>& state);
+        /// @brief sends the given message as a request
+        /// @param receiver the ID that the response has to come from
+        Awaitable<std::optional<Message>> m_send_request(const sf::Packet& message, ID receiver, sf::IpAddress ip, PORT port, sf::Time timeout);
+        /// @brief calls the request handler and sends the response
+        void m_handle_request(sf::Packet& packet, ID sender, sf::IpAddress ip, PORT port);
+        /// @brief completes the pending request that the response is for
+        void m_handle_response(sf::Packet& packet, ID sender);
+
+    // ---------------------------------
+
     //* Packet Parsing
 
         /// @brief Called when a data packet is received
@@ -136,6 +306,46 @@ protected:
         /// @param ip the senders IpAddress
         /// @param port the sender Port
         inline virtual void m_parse_password(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
+        /// @brief Called when a request packet is received
+        /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
+        /// @param ip the senders IpAddress
+        /// @param port the sender Port
+        inline virtual void m_parse_request(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
+        /// @brief Called when a response packet is received
+        /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
+        /// @param ip the senders IpAddress
+        /// @param port the sender Port
+        inline virtual void m_parse_response(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
+        /// @brief Called when a ping packet is received
+        /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
+        /// @param ip the senders IpAddress
+        /// @param port the sender Port
+        inline virtual void m_parse_ping(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
+        /// @brief Called when a pong packet is received
+        /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
+        /// @param ip the senders IpAddress
+        /// @param port the sender Port
+        inline virtual void m_parse_pong(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
+        /// @brief Called when a shared memory offer is received
+        /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
+        /// @param ip the senders IpAddress
+        /// @param port the sender Port
+        inline virtual void m_parse_shared_memory_offer(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
+        /// @brief Called when a shared memory offer was accepted
+        /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
+        /// @param ip the senders IpAddress
+        /// @param port the sender Port
+        inline virtual void m_parse_shared_memory_accept(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
+        /// @brief Called when a path challenge is received
+        /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
+        /// @param ip the senders IpAddress
+        /// @param port the sender Port
+        inline virtual void m_parse_path_challenge(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
+        /// @brief Called when a path response is received
+        /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
+        /// @param ip the senders IpAddress
+        /// @param port the sender Port
+        inline virtual void m_parse_path_response(sf::Packet& packet, sf::IpAddress ip, PORT port) {}
         /// @brief Called when the packet identifier is unknown
         /// @param packet the packet data (Do NOT store this packet, ONLY parse the data)
         /// @param ip the senders IpAddress
@@ -146,14 +356,101 @@ protected:
 
     //* Socket Functions
 
+        /// @brief queues the data packet for polling or invokes onDataReceived if messages are not being queued
+        /// @note the packet will be left empty if it was queued
+        void m_dispatch_data(sf::Packet& packet, ID sender);
+        /// @brief reads the packet header and calls the matching parse function
+        /// @param arrivalTime when the transport says the packet arrived (0 if not known)
+        void m_handle_packet(sf::Packet& packet, sf::IpAddress ip, PORT port, std::uint64_t arrivalTime = 0);
+        /// @returns the connection ID from the header of the packet being handled on this thread
+        /// @note only valid inside of the parse functions
+        static ID m_get_connection_id();
         /// @brief attempts to send a packet to the given ip and port
-        /// @note if the packet fails to send throws runtime error
-        void m_send(sf::Packet& packet, sf::IpAddress ip, PORT port);
+        /// @note if the outgoing network simulator is enabled the packet is given to it instead
+        /// @note if the transport would block or packets are already queued for the destination the packet is added to the send queue
+        /// @note never throws, failures are counted in the metrics and returned
+        /// @note the connection ID in the packet header is set to m_id
+        SendResult m_send(sf::Packet& packet, sf::IpAddress ip, PORT port);
+        /// @brief attempts to send every packet to the given ip and port with as few calls into the kernel as the transport can
+        /// @note packets are queued and counted the same as with m_send
+        /// @note falls back to m_send for each packet when capturing, simulating, or sending through shared memory
+        /// @returns SendResult::Sent if every packet was sent otherwise the result of the first packet that was not
+        SendResult m_send_batch(std::span<sf::Packet> packets, sf::IpAddress ip, PORT port);
+        /// @brief sends as many queued packets as the transport will take without blocking
+        void m_flush_send_queue();
+        /// @brief sends a pong in response to the given ping packet
+        void m_send_pong(sf::Packet& ping, sf::IpAddress ip, PORT port);
+        /// @brief reads the timestamps from the pong packet and adds them to the estimator
+        /// @note the round trip time sample is also recorded in the socket rtt histogram
+        /// @param histogram if not nullptr the sample is recorded here as well
+        /// @returns false if the pong could not be read
+        bool m_read_pong(sf::Packet& pong, RttEstimator& estimator, Histogram* histogram = nullptr);
+        /// @brief adds a sample to the traffic history from the socket metrics
+        /// @note should be called once a second from m_second_update_function
+        /// @param rtt the round trip time in seconds to record with the sample
+        void m_record_traffic_history(float rtt);
+
+    //* Shared Memory Variables and Functions
+
+        /// @brief if same host connections should use shared memory instead of the transport
+        std::atomic<bool> m_sharedMemoryEnabled = false;
+        /// @brief guards the shared memory channels, offers and doorbell
+        mutable std::shared_mutex m_sharedMemoryMutex;
+        /// @brief rung by other processes when they send to this socket
+        std::unique_ptr<SharedMemoryDoorbell> m_sharedMemoryDoorbell = nullptr;
+        /// @brief active channels by peer (see m_shared_memory_key)
+        std::unordered_map<std::uint64_t, std::shared_ptr<SharedMemoryChannel>> m_sharedMemoryChannels;
+        /// @brief channels that have been offered and are waiting to be accepted
+        std::unordered_map<std::uint64_t, std::shared_ptr<SharedMemoryChannel>> m_sharedMemoryOffers;
+        /// @brief so that sending does not have to lock when there are no channels
+        std::atomic<std::size_t> m_sharedMemoryChannelCount = 0;
+        /// @brief changed every time the channels change so the reading thread knows to update its copy
+        std::atomic<std::uint32_t> m_sharedMemoryVersion = 0;
+        /// @brief reads packets from every channel
+        std::jthread* m_sharedMemoryThread = nullptr;
+        /// @brief set once the shared memory thread has left its loop (shared with the thread so it can still notify once this socket is gone)
+        std::shared_ptr<std::atomic<bool>> m_sharedMemoryThreadDone = std::make_shared<std::atomic<bool>>(true);
+        /// @brief the ID of the last shared memory thread started (so it is never made to wait for its self)
+        std::atomic<std::thread::id> m_sharedMemoryThreadID;
+
+        void m_shared_memory_thread(std::stop_token sToken);
+        static std::uint64_t m_shared_memory_key(sf::IpAddress ip, PORT port);
+        /// @returns true if the ip belongs to this host
+        static bool m_is_local_address(sf::IpAddress ip);
+        /// @brief creates the doorbell if it does not exist yet
+        /// @note must be called with m_sharedMemoryMutex locked
+        /// @returns false if shared memory is not supported
+        bool m_create_shared_memory_doorbell();
+        /// @brief creates a channel and offers it to the given peer
+        void m_offer_shared_memory(sf::IpAddress ip, PORT port);
+        /// @brief opens the offered channel and accepts it
+        void m_handle_shared_memory_offer(sf::Packet& packet, sf::IpAddress ip, PORT port);
+        /// @brief starts using the channel that was offered to the given peer
+        void m_handle_shared_memory_accept(sf::Packet& packet, sf::IpAddress ip, PORT port);
+        /// @brief starts using the channel and the shared memory thread if needed
+        void m_add_shared_memory_channel(std::uint64_t key, std::shared_ptr<SharedMemoryChannel> channel);
+        /// @brief stops using shared memory with the given peer
+        void m_close_shared_memory(sf::IpAddress ip, PORT port);
+        void m_close_all_shared_memory();
+        /// @returns false if there is no channel for the peer or the channel is full
+        bool m_send_shared_memory(sf::Packet& packet, sf::IpAddress ip, PORT port);
+
+    // -----------------------------------
+
+        /// @brief applies simulated network conditions to packets before they are sent
+        NetworkSimulator m_outgoingSimulator{[this](sf::Packet& packet, sf::IpAddress ip, unsigned short port)
+            { (void)m_transport->send(packet, ip, port); }}; // a failed send is just another lost packet here
+        /// @brief applies simulated network conditions to packets before they are parsed
+        NetworkSimulator m_incomingSimulator{[this](sf::Packet& packet, sf::IpAddress ip, unsigned short port)
+            { m_handle_packet(packet, ip, port); }, 1};
 
     // -----------------
 
 public:
 
+    /// @brief used to bind to any free port
+    static constexpr PORT AnyPort = 0;
+
     //* Events
         
         /// @brief Invoked when data is received
@@ -202,6 +499,180 @@ public:
 
     // ---------------------
 
+    //* Message Queue Functions
+
+        /// @brief if true received data is queued to be polled instead of invoking onDataReceived
+        /// @note default: false
+        void setMessageQueueEnabled(bool enabled = true);
+        bool isMessageQueueEnabled() const;
+        /// @brief sets the max number of messages that can be waiting to be polled
+        /// @note rounded up to the next power of two
+        /// @note any messages that are received while the queue is full are dropped
+        /// @note does not do anything if the connection is open
+        void setMessageQueueCapacity(std::size_t capacity);
+        std::size_t getMessageQueueCapacity() const;
+        /// @brief moves up to max received messages into the given span (oldest first)
+        /// @note the messages previously in the span are reused for future messages so reusing the same span avoids allocations
+        /// @note must only be called from one thread at a time
+        /// @returns the number of messages that were written to the span
+        std::size_t poll(std::span<Message> messages, std::size_t max = SIZE_MAX);
+        /// @returns the approximate number of messages waiting to be polled
+        std::size_t getQueuedMessageCount() const;
+        /// @returns the number of messages dropped because the queue was full
+        std::uint64_t getDroppedMessageCount() const;
+
+    // ------------------------
+
+    //* Transport Functions
+
+        /// @brief sets what packets are sent and received through (i.e. a MemoryTransport to run without the kernel)
+        /// @note DEFAULT = UdpTransport
+        /// @note does not do anything if the connection is open or packets are being received
+        void setTransport(std::unique_ptr<Transport> transport);
+        Transport& getTransport();
+        /// @brief sets the size of the kernel receive and send buffers (SO_RCVBUF and SO_SNDBUF)
+        /// @note a larger receive buffer lets bursts wait for the receive thread instead of being dropped by the kernel,
+        ///       those drops are counted in the metrics as DropReason::ReceiveOverflow so they can be told apart from network loss
+        /// @note applied right away if the transport is bound and kept when the transport is changed
+        /// @note only supported by the UdpTransport on linux
+        void setBufferSizes(const SocketBufferSizes& sizes);
+        /// @returns the sizes that were set
+        const SocketBufferSizes& getBufferSizes() const;
+        /// @returns the sizes the transport is actually using (linux reports double what was set, 0 if unknown or not bound)
+        SocketBufferSizes getActualBufferSizes() const;
+        /// @brief if the transport should record when each packet arrived (SO_TIMESTAMPNS for the UdpTransport on linux)
+        /// @note the arrival time is given to Message::arrivalTime, getArrivalTime, and getReceiveDelayHistogram,
+        ///       and pongs use it so the round trip time does not include the wait for the receive thread
+        /// @note DEFAULT = false
+        void setKernelTimestampsEnabled(bool enabled = true);
+        bool isKernelTimestampsEnabled() const;
+        /// @brief if the transport can hand batches of equal sized packets to the kernel as one send (UDP_SEGMENT)
+        ///        and take many received packets from the kernel at once (UDP_GRO)
+        /// @note when the kernel or the network device does not support it the transport falls back to one packet per call
+        /// @note DEFAULT = true
+        void setSegmentationOffloadEnabled(bool enabled = true);
+        bool isSegmentationOffloadEnabled() const;
+
+    // ------------------------
+
+    //* Send Queue Functions
+
+        /// @brief sets the max number of packets that can wait for the transport for each destination
+        /// @note packets are only queued when the transport would block (i.e. the send buffer is full during a large broadcast)
+        /// @note DEFAULT = 256
+        void setSendQueueCapacity(std::size_t capacity);
+        std::size_t getSendQueueCapacity() const;
+        /// @brief sets what is dropped when a packet is sent to a destination whose send queue is full
+        /// @note DEFAULT = SendQueuePolicy::DropNewest
+        void setSendQueuePolicy(SendQueuePolicy policy);
+        SendQueuePolicy getSendQueuePolicy() const;
+        /// @returns the number of packets waiting for the transport for every destination combined
+        std::size_t getSendQueueSize() const;
+
+    // ------------------------
+
+    //* Shared Memory Functions
+
+        /// @brief if enabled a client connecting to a server on the same host offers a shared memory channel once connected
+        ///        and the server accepts them, then every packet between the two skips the transport
+        /// @note the client and server both have to enable this
+        /// @note only supported on linux, anything else keeps using the transport
+        /// @note if a channel is full the packet is sent through the transport instead
+        /// @note DEFAULT = false
+        void setSharedMemoryEnabled(bool enabled = true);
+        bool isSharedMemoryEnabled() const;
+        /// @returns the number of peers that packets are sent to through shared memory
+        std::size_t getSharedMemoryChannelCount() const;
+
+    // ------------------------
+
+    //* Metrics Functions
+
+        /// @returns a copy of every counter and gauge for this socket
+        /// @note the counters are read without locking so this can be called from any thread at any rate
+        virtual MetricsSnapshot getMetrics() const;
+        /// @brief sets every counter back to 0
+        /// @note the tick stats and simulated drops are reset with resetTickStats and getIncomingSimulator().resetStats()
+        void resetMetrics();
+
+    // -----------------
+
+    //* Histogram Functions
+
+        /// @brief if the latency histograms should be recorded
+        /// @note recording only adds a few relaxed atomic adds and clock reads per packet
+        /// @note DEFAULT = true
+        void setHistogramsEnabled(bool enabled = true);
+        bool isHistogramsEnabled() const;
+        /// @returns the time from a data packet being received to it being given to onDataReceived, a receive, or poll
+        /// @note with thread safe events this does not include the wait for EventHelper::Event::ThreadSafe::update()
+        HistogramSnapshot getReceiveLatencyHistogram() const;
+        /// @returns the time from each packet arriving at the transport to the receive thread handling it
+        ///          (the wait in the kernel receive buffer and for the receive thread to be scheduled)
+        /// @note only recorded with kernel timestamps enabled, the delay before that is network delay and the delay after is getReceiveLatencyHistogram
+        HistogramSnapshot getReceiveDelayHistogram() const;
+        /// @returns the time spent handling packets of the given type on the receiving thread
+        /// @note data and request times include onDataReceived and the request handler
+        HistogramSnapshot getHandlerHistogram(PacketType type) const;
+        /// @returns the time every handler histogram combined
+        HistogramSnapshot getHandlerHistogram() const;
+        /// @returns the time spent in each update on the update thread
+        HistogramSnapshot getTickHistogram() const;
+        /// @returns every round trip time sample
+        /// @note for a server this is every client combined (see ClientData::getRTTHistogram for one client)
+        HistogramSnapshot getRTTHistogram() const;
+        void resetHistograms();
+
+    // -------------------
+
+    //* Traffic History Functions
+
+        /// @returns the traffic of the socket for each of the last TrafficHistory::CAPACITY seconds (oldest first)
+        /// @note for a server this is every client combined (see Server::getClientTrafficHistory for one client)
+        std::vector<TrafficSample> getTrafficHistory() const;
+        void clearTrafficHistory();
+
+    // -------------------------
+
+    //* Capture Functions
+
+        /// @brief every packet sent and received by this socket is given to the capture (nullptr to stop capturing)
+        /// @note packets are captured while the capture is running so it can be started and stopped at any time
+        /// @note received packets are captured before the incoming simulator and sent packets before the outgoing simulator
+        /// @note does not do anything if the connection is open or packets are being received
+        void setCapture(std::shared_ptr<PacketCapture> capture);
+        std::shared_ptr<PacketCapture> getCapture() const;
+
+    // ------------------------
+
+    //* Network Simulator Functions
+
+        /// @brief the simulator that every packet sent by this socket goes through
+        /// @note disabled until conditions are set (i.e. getOutgoingSimulator().setConditions({.latency = 0.05f, .loss = 0.01f}))
+        /// @note any delayed packets are sent right away when the threads are stopped so close packets are not lost
+        NetworkSimulator& getOutgoingSimulator();
+        /// @brief the simulator that every packet received by this socket goes through before it is parsed
+        /// @note while enabled packets are parsed on the simulators thread instead of the receive thread
+        /// @note disabled until conditions are set
+        NetworkSimulator& getIncomingSimulator();
+
+    // ------------------------
+
+    //* Coroutine Functions
+
+        /// @brief waits for the next data packet
+        /// @note awaiting receives get data before the message queue or onDataReceived
+        /// @note the receive only starts waiting once it is awaited, one that is never awaited does not take any data
+        /// @note the coroutine is resumed on the update thread
+        /// @returns the received message or std::nullopt if the connection is closed
+        Awaitable<std::optional<Message>> receive();
+        /// @brief sets the function that is called to answer requests
+        /// @note called from the receiving thread
+        /// @note if no handler is set requests are ignored and will time out for the sender
+        void setRequestHandler(const RequestHandler& handler);
+
+    // --------------------
+
     //* Connection Functions
 
         //* Pure Virtual Functions
@@ -216,9 +687,15 @@ public:
     //* Getters
 
         /// @returns ID
+        /// @note for clients this is the ID given by the server, 0 if no ID has been assigned
         ID getID() const;
-        /// @returns IP as IPAddress
+        /// @returns the IP that the server sees this client as
+        /// @note std::nullopt if no ID has been assigned
         IpAddress_t getIP() const;
+        /// @returns the public IP if it is known
+        /// @note if it is not known yet this will start resolving it in the background and return std::nullopt
+        /// @note this will never block
+        IpAddress_t getPublicIP() const;
         /// @returns Local IP as IPAddress
         IpAddress_t getLocalIP() const;
         /// @returns the time in seconds
@@ -227,6 +704,8 @@ public:
         double getOpenTime() const;
         /// @returns the update interval in updates per second
         unsigned int getUpdateInterval() const;
+        /// @returns the timing stats for the update thread (jitter, overruns, and missed updates)
+        TickStats getTickStats() const;
         /// @returns this port
         unsigned int getPort() const;
         /// @returns current client timeout time in seconds
@@ -235,6 +714,8 @@ public:
         std::string getPassword() const;
         /// @returns the function that is called when sending a packet
         const funcHelper::func<void>& getPacketSendFunction() const;
+        /// @returns the seconds between pings (0 if pings are disabled)
+        float getPingInterval() const;
 
     // -------
 
@@ -242,9 +723,11 @@ public:
 
         /// @brief sets the update interval in updates/second 
         /// @note DEFAULT = 64 (64 updates/second)
-        /// @note this will only take effect after the socket is restarted
-        /// @note does not do anything if the connection is open
+        /// @note can be changed while the connection is open, takes effect on the next update
+        /// @note onUpdateRateChanged is only invoked if the rate changed
         void setUpdateInterval(unsigned int interval);
+        /// @brief resets the timing stats for the update thread
+        void resetTickStats();
         /// @returns true if packets are being sent at the interval that was set
         /// @note does not do anything if the connection is open
         void sendingPackets(bool sendPackets);
@@ -261,6 +744,14 @@ public:
         void setPacketSendFunction(const funcHelper::func<void>& packetSendFunction = {[](){}});
         /// @note does not do anything if the connection is open
         void setPort(PORT port);
+        /// @brief sets the seconds between pings which are used to measure the round trip time and clock offset
+        /// @note pings also keep the connection from timing out
+        /// @note DEFAULT = 1 second, 0 disables pings
+        void setPingInterval(float interval);
+        /// @brief sets the public IP for this socket so that it never has to be looked up
+        /// @note std::nullopt will go back to using the shared public IP lookup
+        /// @note can be called from any thread
+        void setPublicIP(IpAddress_t publicIP);
 
     // --------
 
@@ -274,6 +765,8 @@ public:
         bool isSendingPackets() const;
         /// @returns if this needs a password
         bool NeedsPassword() const;
+        /// @returns true if the shared public IP lookup is currently running
+        static bool isResolvingPublicIP();
         /// @brief Checks if the given ipAddress is valid
         /// @note if it is invalid program will freeze for a few seconds
         static bool isValidIpAddress(sf::IpAddress ipAddress);
@@ -286,15 +779,58 @@ public:
 
     // ---------------------------
 
+    //* Time Functions
+
+        /// @returns the time used for pings and clock syncing in microseconds
+        /// @note this is a steady clock so it is only meaningful when compared with other times from the same process
+        static std::int64_t getClockTime();
+        /// @returns when the packet being handled on this thread arrived at the transport (nanoseconds on the steady clock, 0 if not known)
+        /// @note only valid on the receive thread while a packet is handled (i.e. in the request handler), see setKernelTimestampsEnabled
+        static std::uint64_t getArrivalTime();
+
+    // -----------------
+
+    //* Public IP Functions
+
+        /// @brief starts resolving the public IP in a background thread
+        /// @note the result is shared between every socket
+        /// @note does nothing if the public IP is already resolved or being resolved
+        /// @param timeout the max time to wait for a response
+        static void resolvePublicIP(sf::Time timeout = sf::seconds(1));
+
+    // -------------------
+
     //* Template Functions
 
         static sf::Packet ConnectionCloseTemplate(std::string reason);
         static sf::Packet ConnectionRequestTemplate();
         static sf::Packet DataPacketTemplate();
-        /// @param id the id that the client should use for identification
-        static sf::Packet ConnectionConfirmPacket(std::uint32_t id);
+        /// @param id the connection id that the client should use for identification
+        /// @param ip the ip that the server sees the client as
+        /// @param token the random token the client answers path challenges with
+        static sf::Packet ConnectionConfirmPacket(std::uint32_t id, sf::IpAddress ip, std::uint64_t token);
         static sf::Packet PasswordRequestPacket();
         static sf::Packet PasswordPacket(const std::string& password);
+        static sf::Packet RequestPacket(std::uint32_t requestID);
+        static sf::Packet ResponsePacket(std::uint32_t requestID);
+        /// @param sendTime the time the ping was sent (from getClockTime)
+        static sf::Packet PingPacket(std::int64_t sendTime);
+        /// @note the send time is set to the current time
+        /// @param pingSendTime the send time from the ping this is responding to
+        /// @param receiveTime the time the ping was received
+        static sf::Packet PongPacket(std::int64_t pingSendTime, std::int64_t receiveTime);
+        /// @param pid the process id of the sender
+        /// @param channelFD the file descriptor of the SharedMemoryChannel in the senders process
+        /// @param doorbellFD the file descriptor of the SharedMemoryDoorbell in the senders process
+        static sf::Packet SharedMemoryOfferPacket(std::uint32_t pid, std::int32_t channelFD, std::int32_t doorbellFD);
+        /// @param pid the process id of the sender
+        /// @param doorbellFD the file descriptor of the SharedMemoryDoorbell in the senders process
+        static sf::Packet SharedMemoryAcceptPacket(std::uint32_t pid, std::int32_t doorbellFD);
+        /// @param nonce the random value the client has to send back
+        static sf::Packet PathChallengePacket(std::uint64_t nonce);
+        /// @param nonce the nonce from the challenge this is answering
+        /// @param token the token from the connection confirmation
+        static sf::Packet PathResponsePacket(std::uint64_t nonce, std::uint64_t token);
 
     // -------------------
 };
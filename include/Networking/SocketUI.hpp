@@ -3,8 +3,12 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <numeric>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "TGUI/Backend/SFML-Graphics.hpp"
 #include "TGUI/Widgets/ChildWindow.hpp"
@@ -15,6 +19,7 @@
 #include "TGUI/Widgets/CheckBox.hpp"
 #include "TGUI/Widgets/ScrollablePanel.hpp"
 #include "TGUI/Widgets/Label.hpp"
+#include "TGUI/Widgets/Group.hpp"
 
 #include "Networking/Client.hpp"
 #include "Networking/Server.hpp"
@@ -60,6 +65,14 @@ public:
     /// @warning dont edit any events
     /// @returns the ptr to the info window (could be null)
     tgui::ChildWindow::Ptr getInfoWindow();
+    /// @brief sets how many times a second the info display is refreshed
+    /// @note 0 or less refreshes every frame
+    void setInfoRefreshRate(float refreshesPerSecond = 4.f);
+    float getInfoRefreshRate() const;
+    /// @brief sets the max number of clients that are shown at once in the info display, the rest are on other pages
+    /// @note 0 shows every client
+    void setInfoClientsPerPage(std::size_t count = 50);
+    std::size_t getInfoClientsPerPage() const;
     /////////////////////////////////
 
     /// @returns true if either the client or server has an open connection
@@ -80,8 +93,14 @@ public:
     Socket* getSocket();
 
 protected:
-    /// @brief updates the info display
+    /// @brief updates the info display from a new snapshot of the socket
+    /// @note only rows whose text changed are written to the widgets
     void m_updateInfo();
+    /// @brief updates the client tree from the given snapshot
+    /// @note only the clients on the current page are in the tree and only expanded clients have their data updated
+    void m_updateClientInfo(const MetricsSnapshot& snapshot);
+    /// @brief removes every client from the client tree
+    void m_clearClientInfo();
     // void m_updateUISize();
     void m_setServer();
     void m_setClient();
@@ -120,8 +139,25 @@ private:
     tgui::ChildWindow::Ptr m_infoParent = nullptr;
     tgui::ListView::Ptr m_list = nullptr;
     tgui::TreeView::Ptr m_clientData = nullptr;
+    tgui::Group::Ptr m_clientPageGroup = nullptr;
+    tgui::Label::Ptr m_clientPageLabel = nullptr;
     std::string m_tFuncID;
 
+    //* Info Display Refresh Variables
+
+        static constexpr std::size_t CLIENT_ROW_COUNT = 10;
+        /// @brief the text currently in each row of m_list
+        std::vector<tgui::String> m_infoRows;
+        /// @brief the text currently in each leaf of every client in the tree
+        std::unordered_map<ID, std::array<tgui::String, CLIENT_ROW_COUNT>> m_clientRows;
+        float m_infoRefreshRate = 4.f;
+        std::chrono::steady_clock::time_point m_lastInfoUpdate;
+        std::size_t m_clientsPerPage = 50;
+        std::size_t m_clientPage = 0;
+        std::size_t m_clientPageCount = 1;
+
+    // -------------------------------
+
     tgui::Container::Ptr m_UIParent = nullptr;
     tgui::ChildWindow::Ptr m_connectionParent = nullptr;
     tgui::CheckBox::Ptr m_serverCheck = nullptr;
@@ -0,0 +1,103 @@
+#ifndef TICK_SCHEDULER_HPP
+#define TICK_SCHEDULER_HPP
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <stop_token>
+
+namespace udp
+{
+
+/// @brief timing stats gathered by a TickScheduler
+/// @note all times are in seconds
+struct TickStats
+{
+    /// @brief the number of ticks that have been run
+    std::uint64_t ticks = 0;
+    /// @brief ticks that were skipped because the scheduler fell more than a full tick behind
+    std::uint64_t missedTicks = 0;
+    /// @brief ticks where the work took longer than the tick interval
+    std::uint64_t overruns = 0;
+    /// @brief average difference between when a tick was scheduled to start and when it did start
+    double averageJitter = 0.0;
+    double maxJitter = 0.0;
+    /// @brief average time spent between the start and end of a tick
+    double averageTickDuration = 0.0;
+    double maxTickDuration = 0.0;
+};
+
+/// @brief runs ticks at a fixed rate on an absolute timeline so that sleeping errors do not build up over time
+/// @note waitForNextTick and endTick must only be called from one thread
+/// @note the tick rate can be changed and the stats can be read from any thread
+class TickScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// @param tickRate ticks per second
+    TickScheduler(unsigned int tickRate = 64);
+
+    /// @brief restarts the timeline from now
+    /// @note should be called right before the first tick
+    void reset();
+    /// @brief sleeps until the next tick is scheduled to start
+    /// @note if more than a full tick behind the missed ticks are skipped instead of being run back to back
+    /// @param sToken if a stop is requested this returns right away
+    /// @returns the time since the last tick started in seconds
+    double waitForNextTick(std::stop_token sToken = {});
+    /// @brief marks the end of the work for the current tick
+    void endTick();
+
+    /// @brief sets the number of ticks per second
+    /// @note takes effect on the next tick (does not require the scheduler to be restarted)
+    /// @note a tick rate of 0 is treated as 1
+    void setTickRate(unsigned int tickRate);
+    /// @returns the number of ticks per second
+    unsigned int getTickRate() const;
+    /// @returns a copy of the current stats
+    TickStats getStats() const;
+    void resetStats();
+
+private:
+    std::atomic<unsigned int> m_tickRate;
+
+    //* Scheduler thread only
+
+        /// @brief the tick rate that the current timeline was started with
+        unsigned int m_timelineRate = 0;
+        Clock::duration m_tickInterval = Clock::duration::zero();
+        Clock::time_point m_timelineStart;
+        /// @brief number of ticks since the timeline started
+        std::uint64_t m_tickIndex = 0;
+        Clock::time_point m_tickStart;
+        /// @brief only used so that sleeping can be interrupted by a stop request
+        std::mutex m_sleepMutex;
+        std::condition_variable_any m_sleepCondition;
+
+    // ---------------------
+
+    //* Stats
+
+        std::atomic<std::uint64_t> m_ticks = 0;
+        std::atomic<std::uint64_t> m_missedTicks = 0;
+        std::atomic<std::uint64_t> m_overruns = 0;
+        /// @brief in nanoseconds
+        std::atomic<std::int64_t> m_totalJitter = 0;
+        /// @brief in nanoseconds
+        std::atomic<std::int64_t> m_maxJitter = 0;
+        /// @brief in nanoseconds
+        std::atomic<std::int64_t> m_totalTickDuration = 0;
+        /// @brief in nanoseconds
+        std::atomic<std::int64_t> m_maxTickDuration = 0;
+
+    // ------
+};
+
+}
+
+#endif
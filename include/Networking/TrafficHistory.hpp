@@ -0,0 +1,89 @@
+#ifndef TRAFFIC_HISTORY_HPP
+#define TRAFFIC_HISTORY_HPP
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+namespace udp
+{
+
+/// @brief the traffic of one connection (or every connection of a socket) over one second
+struct TrafficSample
+{
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    std::uint64_t packetsIn = 0;
+    std::uint64_t packetsOut = 0;
+    /// @brief the smoothed round trip time at the end of the second in seconds (0 if unknown)
+    float rtt = 0.f;
+    /// @brief the part of the pings sent that were not answered (0 to 1)
+    /// @note pongs that arrive in the next second are counted there so this is only an estimate
+    float loss = 0.f;
+};
+
+/// @brief the running totals that a TrafficHistory takes its samples from
+struct TrafficTotals
+{
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    std::uint64_t packetsIn = 0;
+    std::uint64_t packetsOut = 0;
+    std::uint64_t pingsOut = 0;
+    std::uint64_t pongsIn = 0;
+};
+
+/// @brief fixed size ring buffer of the last CAPACITY one second traffic samples
+/// @note not thread safe, see TrafficHistory (the clients of a server share one lock in the ClientPool instead)
+class TrafficRing
+{
+public:
+    static constexpr std::size_t CAPACITY = 120;
+
+    /// @brief adds a sample made from the change in the totals since the last call
+    /// @note the first call after construction or clear only stores the totals
+    /// @param rtt the current round trip time in seconds
+    void record(const TrafficTotals& totals, float rtt);
+    /// @returns every sample from oldest to newest
+    std::vector<TrafficSample> getSamples() const;
+    /// @returns the number of samples stored
+    std::size_t getSize() const;
+    /// @brief removes every sample and forgets the last totals
+    void clear();
+
+private:
+    std::array<TrafficSample, CAPACITY> m_samples;
+    /// @brief where the next sample is written
+    std::size_t m_next = 0;
+    std::size_t m_size = 0;
+    TrafficTotals m_lastTotals;
+    bool m_hasTotals = false;
+};
+
+/// @brief a TrafficRing with its own lock
+/// @note recorded once a second by the sockets update thread, can be read from any thread
+class TrafficHistory
+{
+public:
+    static constexpr std::size_t CAPACITY = TrafficRing::CAPACITY;
+
+    /// @see TrafficRing::record
+    void record(const TrafficTotals& totals, float rtt);
+    /// @returns every sample from oldest to newest
+    std::vector<TrafficSample> getSamples() const;
+    /// @returns the number of samples stored
+    std::size_t getSize() const;
+    /// @brief removes every sample and forgets the last totals
+    void clear();
+
+private:
+    mutable std::mutex m_mutex;
+    TrafficRing m_ring;
+};
+
+}
+
+#endif
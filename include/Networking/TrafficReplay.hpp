@@ -0,0 +1,82 @@
+#ifndef TRAFFIC_REPLAY_HPP
+#define TRAFFIC_REPLAY_HPP
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stop_token>
+
+#include <SFML/Network/IpAddress.hpp>
+
+namespace udp
+{
+
+class Socket;
+
+/// @brief the results of one replay
+struct ReplayStats
+{
+    std::uint64_t packets = 0;
+    std::uint64_t bytes = 0;
+    /// @brief wall time the replay took in seconds
+    double duration = 0.0;
+    /// @brief the furthest behind the original timing a packet was handed to the socket in seconds (0 when replaying flat out)
+    double maxLag = 0.0;
+};
+
+/// @brief replays a log of received packets (written by a PacketCapture using CaptureFormat::Replay) into a socket
+/// @note packets are given straight to the sockets packet handling so no system sockets are used for the replayed traffic,
+///       anything the socket sends back goes through its transport as normal (a MemoryTransport keeps the whole run in process)
+/// @note the whole log is loaded into memory so replaying the same log gives the same packets in the same order every time
+class TrafficReplay
+{
+public:
+    struct Packet
+    {
+        /// @brief nanoseconds since the first packet
+        std::uint64_t time = 0;
+        std::uint32_t ip = 0;
+        unsigned short port = 0;
+        /// @brief where the data starts in the log
+        std::size_t offset = 0;
+        std::size_t size = 0;
+    };
+
+    /// @brief reads every packet from the log
+    /// @returns false if the file could not be read or is not a replay log (a log cut off part way through a record keeps the full records)
+    bool load(const std::string& path);
+    void clear();
+
+    const std::vector<Packet>& getPackets() const;
+    /// @returns the data of the given packet
+    const std::uint8_t* getData(const Packet& packet) const;
+    std::size_t getPacketCount() const;
+    std::uint64_t getByteCount() const;
+    /// @returns the time from the first to the last packet in seconds
+    double getDuration() const;
+    /// @returns the wall clock time the log was started in nanoseconds since the unix epoch
+    std::uint64_t getStartTime() const;
+    /// @returns the wall clock time the packet was captured in nanoseconds since the unix epoch
+    /// @note worked out from the start time and the steady clock time since then so it is not changed by wall clock adjustments during the capture
+    std::uint64_t getCaptureTime(const Packet& packet) const;
+
+    /// @brief hands every packet to the socket as if it was received from the recorded sender
+    /// @note runs on the calling thread
+    /// @param speed 1 replays at the original timing, 2 at twice the speed, and 0 (or less) as fast as possible
+    /// @param sToken stops the replay part way through if a stop is requested
+    ReplayStats replay(Socket& socket, float speed = 0.f, std::stop_token sToken = {}) const;
+
+private:
+    std::vector<std::uint8_t> m_data;
+    std::vector<Packet> m_packets;
+    std::uint64_t m_bytes = 0;
+    std::uint64_t m_startTime = 0;
+    /// @brief nanoseconds from the start of the log to the first packet
+    std::uint64_t m_firstPacketTime = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#pragma once
+
+#include <span>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+#include <SFML/Network/UdpSocket.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/Network/IpAddress.hpp>
+
+namespace udp
+{
+
+/// @brief the sizes of the kernel buffers of a transport in bytes
+struct SocketBufferSizes
+{
+    /// @brief 0 keeps the system default
+    int receive = 0;
+    /// @brief 0 keeps the system default
+    int send = 0;
+    /// @brief if SO_RCVBUFFORCE/SO_SNDBUFFORCE should be used to go past the system max (net.core.rmem_max and wmem_max)
+    /// @note needs CAP_NET_ADMIN, without it the normal options are used which the kernel caps at the system max
+    bool force = false;
+};
+
+/// @brief what a Socket uses to send and receive datagrams
+/// @note send may be called from multiple threads at once, receive is only called from the receive thread
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    /// @param port the port to bind to (0 for any free port)
+    virtual sf::Socket::Status bind(unsigned short port) = 0;
+    virtual void unbind() = 0;
+    /// @returns the port that is bound (0 if not bound)
+    virtual unsigned short getLocalPort() const = 0;
+    /// @brief sends the packet without blocking
+    /// @returns Status::NotReady if the packet could not be sent right now (i.e. the send buffer is full)
+    virtual sf::Socket::Status send(sf::Packet& packet, sf::IpAddress ip, unsigned short port) = 0;
+    /// @brief sends every packet to the same destination in order without blocking
+    /// @param sent set to the number of packets from the front that were sent
+    /// @returns the status of the first packet that was not sent (Status::Done if every packet was sent)
+    /// @note by default this sends one packet at a time
+    virtual sf::Socket::Status sendBatch(std::span<sf::Packet> packets, sf::IpAddress ip, unsigned short port, std::size_t& sent);
+    /// @returns false if a send would return Status::NotReady right now
+    virtual bool isWritable() { return true; }
+    /// @brief makes a waiting receive return Status::NotReady once a send would no longer block so queued packets can be sent right away
+    /// @note lasts until receive returns because of it
+    /// @note by default this does nothing and queued packets wait for the next send or update
+    virtual void notifyWhenWritable() {}
+    /// @brief blocks until a packet is received or interrupt is called
+    /// @returns Status::NotReady if interrupted
+    virtual sf::Socket::Status receive(sf::Packet& packet, std::optional<sf::IpAddress>& senderIP, unsigned short& senderPort) = 0;
+    /// @brief wakes up a blocking receive
+    /// @note if no receive is blocking the next one must return right away instead (i.e. the wake up is not lost)
+    virtual void interrupt() = 0;
+    /// @brief sets the size of the receive and send buffers
+    /// @note applied right away if bound and again every time the transport is bound
+    virtual void setBufferSizes(const SocketBufferSizes& sizes) {}
+    /// @returns the buffer sizes that are actually being used (0 if unknown or not bound)
+    virtual SocketBufferSizes getBufferSizes() const { return {}; }
+    /// @returns the number of packets that were dropped before they could be received because the receive buffer was full
+    /// @note may go back to 0 when the transport is bound again
+    virtual std::uint64_t getReceiveOverflowCount() const { return 0; }
+    /// @brief if the time each packet arrived should be recorded by the kernel (or whatever the transport receives from)
+    /// @note applied right away if bound and again every time the transport is bound
+    virtual void setTimestampsEnabled(bool enabled) {}
+    /// @returns when the last packet returned by receive arrived (nanoseconds on the steady clock) or 0 if it is not known
+    /// @note only called from the receive thread right after receive
+    virtual std::uint64_t getReceiveTimestamp() const { return 0; }
+    /// @brief if batches should be handed to the network as one send and packets received coalesced when supported (i.e. UDP GSO and GRO)
+    /// @note applied right away if bound and again every time the transport is bound
+    virtual void setOffloadEnabled(bool enabled) {}
+};
+
+/// @brief the default transport which uses a real UDP socket
+/// @note on linux packets are received with recvmsg so the kernel can report receive buffer overflows (SO_RXQ_OVFL)
+/// @note on linux runs of equally sized packets in a batch are sent with one sendmsg (UDP_SEGMENT) and coalesced packets
+///       are received with UDP_GRO and split back up, if the kernel or device does not support segmentation it falls back to one send per packet
+class UdpTransport : public Transport, private sf::UdpSocket
+{
+public:
+    /// @brief the most packets in one segmented send
+    static constexpr std::size_t MAX_SEGMENTS = 64;
+
+    /// @param bindAddress the local address to bind to
+    /// @note binding to a specific loopback address (127.0.0.x) lets multiple clients on one host have different addresses
+    UdpTransport(sf::IpAddress bindAddress = sf::IpAddress::Any);
+    virtual ~UdpTransport();
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    virtual sf::Socket::Status bind(unsigned short port) override;
+    virtual void unbind() override;
+    virtual unsigned short getLocalPort() const override;
+    /// @note on linux this sends with MSG_DONTWAIT so a full send buffer returns Status::NotReady while receive still blocks,
+    ///       anywhere else it is a blocking send
+    virtual sf::Socket::Status send(sf::Packet& packet, sf::IpAddress ip, unsigned short port) override;
+    /// @note on linux every run of up to MAX_SEGMENTS packets of the same size (the last one can be smaller) is one sendmsg
+    virtual sf::Socket::Status sendBatch(std::span<sf::Packet> packets, sf::IpAddress ip, unsigned short port, std::size_t& sent) override;
+    /// @note on linux this polls the socket for POLLOUT, anywhere else it is always true
+    virtual bool isWritable() override;
+    /// @note only supported on linux, receive also waits for POLLOUT until the socket is writable
+    virtual void notifyWhenWritable() override;
+    /// @note on linux this waits on the socket and an eventfd together so interrupt can always wake it up
+    virtual sf::Socket::Status receive(sf::Packet& packet, std::optional<sf::IpAddress>& senderIP, unsigned short& senderPort) override;
+    /// @brief on linux signals the eventfd that receive waits on so the wake up is never lost,
+    ///        anywhere else sends an empty packet to its self
+    virtual void interrupt() override;
+    /// @note only supported on linux
+    virtual void setBufferSizes(const SocketBufferSizes& sizes) override;
+    /// @note linux reports double the size that was set since it includes the kernel bookkeeping
+    virtual SocketBufferSizes getBufferSizes() const override;
+    /// @note only supported on linux (from SO_RXQ_OVFL), the kernel only reports the count with the next packet that is received
+    virtual std::uint64_t getReceiveOverflowCount() const override;
+    /// @note only supported on linux (SO_TIMESTAMPNS)
+    virtual void setTimestampsEnabled(bool enabled) override;
+    /// @note the kernel stamps packets with the real time clock so this is moved onto the steady clock when the packet is received,
+    ///       a step in the real time clock between the packet arriving and being received is not accounted for
+    virtual std::uint64_t getReceiveTimestamp() const override;
+    /// @note DEFAULT = true, only supported on linux
+    virtual void setOffloadEnabled(bool enabled) override;
+    /// @returns false if offload is disabled or a segmented send failed because the kernel or device does not support it
+    bool isSegmentationSupported() const;
+
+private:
+    /// @brief sets the buffer sizes, turns on SO_RXQ_OVFL, and turns SO_TIMESTAMPNS and UDP_GRO on or off for the bound socket
+    void m_apply_options();
+
+    sf::IpAddress m_bindAddress;
+    /// @brief the eventfd interrupt signals (-1 if not on linux or it could not be created)
+    int m_wakeFD = -1;
+    /// @brief if receive should also wait for the socket to be writable
+    std::atomic<bool> m_notifyWritable = false;
+    SocketBufferSizes m_bufferSizes;
+    bool m_timestampsEnabled = false;
+    /// @brief when the last packet received arrived on the steady clock (0 if not known)
+    std::uint64_t m_receiveTimestamp = 0;
+    /// @brief the overflow count the kernel last reported (it wraps at 2^32)
+    std::uint32_t m_lastOverflowCount = 0;
+    std::atomic<std::uint64_t> m_overflowCount = 0;
+    /// @brief what recvmsg receives into
+    std::vector<char> m_receiveBuffer;
+
+    //* Offload
+
+        std::atomic<bool> m_offloadEnabled = true;
+        /// @brief set to false the first time the kernel or device reports that segmented sends are not supported
+        /// @note a run that is only rejected as invalid (EINVAL) is sent one packet at a time without clearing this
+        std::atomic<bool> m_segmentationSupported = true;
+        /// @brief the part of the last coalesced receive that has not been returned yet
+        std::size_t m_coalescedOffset = 0;
+        std::size_t m_coalescedEnd = 0;
+        std::size_t m_coalescedSegmentSize = 0;
+        sf::IpAddress m_coalescedSender = sf::IpAddress::Any;
+        unsigned short m_coalescedPort = 0;
+
+    // -------
+};
+
+}
+
+#endif
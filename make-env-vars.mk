@@ -6,7 +6,8 @@
 # PROJECT_DIRECTORY: the directory where the makefile is being run from
 # MOUNT_POINT: the mount point of the filesystem
 # BUILD_RELEASE: the type of release (debug or release)
-# BUILD_TYPE: the type of build (debug or release)
+# BUILD_TYPE: the type of build (executable, library or tool)
+# TOOL: the name of the tool being built (only set when BUILD_TYPE is tool)
 
 #* The following will be evaluated in the order they are listed, if applicable
 #* i.e. executable_config is evaluated after general_config if compiling an executable
@@ -26,6 +27,11 @@ define general_config
 	endif
 	LINKER_FLAGS:=SET_LATER
 	INCLUDE_FLAGS:=
+	# source files (from the project directory) that are not compiled
+	EXCLUDED_SOURCE_FILES:=
+	# source files (from the project directory) that need TGUI and SFML graphics
+	# these are left out of tools and headless libraries and are put in their own library
+	UI_SOURCE_FILES:=/src/Networking/SocketUI.cpp
 	EXECUTABLE_EXTENSION:=SET_LATER
 	LIB_EXTENSION:=SET_LATER
 	
@@ -60,23 +66,39 @@ define executable_config
 	PROJECT_NAME:=main
 endef
 
+# tools are headless programs in /tools/<TOOL> (i.e. benchmarks) that link against everything but the UI
+define tool_config
+	PROJECT_NAME:=$${TOOL}
+	SOURCE_DIRECTORIES:=/src /tools/$${TOOL}
+	NON_RECURSIVE_SOURCE_DIRECTORIES:=
+	EXCLUDED_SOURCE_FILES:=$${UI_SOURCE_FILES}
+endef
+
+# libraries are split into the core (lib<PROJECT_NAME>) and the UI add-on (lib<UI_PROJECT_NAME>)
+# the core only needs SFML network and system so it can be linked by headless servers
 define lib_config
 	PROJECT_NAME:=networking
+	UI_PROJECT_NAME:=networking-ui
 	PROJECT_OUT_DIRECTORY:=/lib/$${COMPILE_OS}
 	NON_RECURSIVE_SOURCE_DIRECTORIES:=
+	ifeq ($${LIBRARY_UI},false)
+	EXCLUDED_SOURCE_FILES:=$${UI_SOURCE_FILES}
+	endif
 endef
 
 define debug_config
 	ifeq ($${BUILD_TYPE},library)
 	PROJECT_NAME:=$${PROJECT_NAME}-d
+	UI_PROJECT_NAME:=$${UI_PROJECT_NAME}-d
 	endif
 
 	C_CPP_COMPILER_FLAGS:=${C_CPP_COMPILER_FLAGS} -g -DDEBUG
 	OBJECT_OUT_DIRECTORY:=${OBJECT_OUT_DIRECTORY}/debug
 endef
 
+# link time optimization is used for every release build (the linux shared libraries are linked with it as well)
 define release_config
-	C_CPP_COMPILER_FLAGS:=${C_CPP_COMPILER_FLAGS} -O3
+	C_CPP_COMPILER_FLAGS:=${C_CPP_COMPILER_FLAGS} -O3 -flto=auto
 	OBJECT_OUT_DIRECTORY:=${OBJECT_OUT_DIRECTORY}/release
 endef
 
@@ -86,7 +108,17 @@ define windows_config
 	CREATE_LIB:=ar rcs
 
 	C_CPP_COMPILER_FLAGS:=${C_CPP_COMPILER_FLAGS} -static
+	# static libraries keep normal object code next to the LTO data so they can be linked without -flto
+	ifeq ($${BUILD_RELEASE},release)
+	C_CPP_COMPILER_FLAGS:=$${C_CPP_COMPILER_FLAGS} -ffat-lto-objects
+	endif
 	INCLUDE_FLAGS:=-D SFML_STATIC
+	ifeq ($${BUILD_TYPE},tool)
+	LINKER_FLAGS:=-lutils \
+				  -lsfml-network-s -lsfml-system-s -lws2_32 \
+				  -lsfml-system-s -lwinmm \
+				  -lstdc++
+	else
 	LINKER_FLAGS:=-lutils -ltgui-s \
 				  -lsfml-graphics-s -lsfml-window-s -lsfml-system-s -lopengl32 -lfreetype \
 				  -lsfml-window-s -lsfml-system-s -lopengl32 -lwinmm -lgdi32 \
@@ -94,6 +126,7 @@ define windows_config
 				  -lsfml-network-s -lsfml-system-s -lws2_32 \
 				  -lsfml-system-s -lwinmm \
 				  -lstdc++
+	endif
 endef
 
 # First windows_config is evaluated, then windows_via_linux_config
@@ -114,6 +147,12 @@ define linux_config
 	# LIB_DIRECTORIES is added here for simple testing
 	LIBS_SEARCH_PATHS:=./ ./lib \
 						$${LIB_DIRECTORIES}
+	ifeq ($${BUILD_TYPE},tool)
+	LINKER_FLAGS:=-lutils \
+				  -lsfml-network \
+				  -lsfml-system \
+				  -lstdc++ -lpthread $$(patsubst %,-Wl$${COMMA}-rpath$${COMMA}%,$${LIBS_SEARCH_PATHS})
+	else
 	LINKER_FLAGS:=-lutils -ltgui \
 				  -lsfml-graphics -lsfml-window -lsfml-system \
 				  -lsfml-window -lsfml-system \
@@ -121,6 +160,7 @@ define linux_config
 				  -lsfml-network \
 				  -lsfml-system \
 				  -lstdc++ $$(patsubst %,-Wl$${COMMA}-rpath$${COMMA}%,$${LIBS_SEARCH_PATHS})
+	endif
 
 	C_CPP_COMPILER_FLAGS:=$${C_CPP_COMPILER_FLAGS} -fPIC
 endef
\ No newline at end of file
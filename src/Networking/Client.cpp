@@ -17,6 +17,9 @@ Client::Client(PORT serverPort)
 Client::~Client()
 {
     closeConnection();
+    // the threads are still running if the connection never opened (i.e. a connect that timed out)
+    stopThreads();
+    m_wait_for_threads();
 }
 
 // ------------------------------
@@ -28,11 +31,33 @@ void Client::m_update_function(float deltaTime)
     if (this->isConnectionOpen()) 
     {
         m_timeSinceLastPacket += deltaTime;
+
+        if (m_pingInterval > 0.f)
+        {
+            m_timeSincePing += deltaTime;
+            if (m_timeSincePing >= m_pingInterval)
+            {
+                m_timeSincePing = 0.f;
+                sf::Packet ping = this->PingPacket(getClockTime());
+                SocketMetrics::increment(m_metrics.pingsOut);
+                m_send(ping, getServerIP().value(), getServerPort());
+            }
+        }
     }
     if (m_timeSinceLastPacket >= m_timeoutTime) 
     { 
+        if (this->isConnectionOpen())
+            SocketMetrics::increment(m_metrics.timeouts);
         this->closeConnection(); 
     }
+
+    bool connectTimedOut;
+    {
+        std::lock_guard lock(m_awaitMutex);
+        connectTimedOut = !m_connectWaiters.empty() && std::chrono::steady_clock::now() >= m_connectDeadline;
+    }
+    if (connectTimedOut)
+        m_complete_connect(false);
 }
 
 // -----------------
@@ -44,6 +69,48 @@ void Client::m_reset_connection_data()
     Socket::m_reset_connection_data(); // reseting the default socket data
     m_wrongPassword = false;
     m_timeSinceLastPacket = 0.f;
+    m_timeSincePing = 0.f;
+    m_rtt.reset();
+    // a new connection gets a new ID so packets from before it are not taken as this client
+    m_id = 0;
+    m_ip = 0;
+    m_token = 0;
+}
+
+bool Client::m_open_socket()
+{
+    if (!getServerIP().has_value())
+        return false;
+
+    if (!this->isReceivingPackets())
+    {
+        if (m_transport->bind(Socket::AnyPort) != sf::Socket::Status::Done)
+            return false;
+        setPort(m_transport->getLocalPort());
+        startThreads(); //! needs to be called AFTER port binding
+    }
+
+    return true;
+}
+
+void Client::m_complete_connect(bool connected)
+{
+    std::vector<std::shared_ptr<AsyncState<bool>>> waiters;
+    {
+        std::lock_guard lock(m_awaitMutex);
+        std::swap(waiters, m_connectWaiters);
+    }
+    for (auto& waiter: waiters)
+    {
+        if (auto handle = waiter->complete(connected))
+            m_schedule_resume(handle);
+    }
+}
+
+void Client::m_cancel_awaiting()
+{
+    Socket::m_cancel_awaiting();
+    m_complete_connect(false);
 }
 
 // ---------------------
@@ -53,7 +120,7 @@ void Client::m_reset_connection_data()
 void Client::m_parse_data(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
 {
     m_timeSinceLastPacket = 0.f;
-    this->onDataReceived.invoke(packet, (ID)senderIP.toInteger(), m_threadSafeEvents, m_overrideEvents);
+    m_dispatch_data(packet, (ID)senderIP.toInteger());
 }
 
 void Client::m_parse_connection_close(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
@@ -64,25 +131,112 @@ void Client::m_parse_connection_close(sf::Packet& packet, sf::IpAddress senderIP
     else
         packet >> reason;
 
+    // the server closed the connection before it was confirmed
+    if (!this->isConnectionOpen())
+        m_complete_connect(false);
     closeConnection();
 }
 
 void Client::m_parse_connection_confirm(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
 {
+    SocketMetrics::increment(m_metrics.connectionsOpened);
     m_connectionOpen = true;
     m_connectionTime = 0.f;
-    packet >> m_id; // getting the ip from the packet (the id that the server assigned)
+    packet >> m_id >> m_ip >> m_token; // getting the connection id that the server assigned, the ip the server sees us as, and the path token
     this->onConnectionOpen.invoke(m_threadSafeEvents, m_overrideEvents);
+    m_complete_connect(true);
+    // switching to shared memory if the server is on this host (does nothing if not enabled)
+    m_offer_shared_memory(senderIP, senderPort);
 }
 
 void Client::m_parse_password_request(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
 {
     if (m_needsPassword)
+    {
         m_wrongPassword = true;
+        SocketMetrics::increment(m_metrics.passwordFailures);
+    }
     else
         m_wrongPassword = false;
     m_needsPassword = true;
     this->onPasswordRequest.invoke(m_threadSafeEvents, m_overrideEvents);
+    m_complete_connect(false);
+}
+
+void Client::m_parse_request(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    // only answering requests from the server
+    if (senderIP != getServerIP() || senderPort != getServerPort())
+    {
+        m_metrics.addDrop(DropReason::NotConnected);
+        return;
+    }
+
+    m_timeSinceLastPacket = 0.f;
+    m_handle_request(packet, (ID)senderIP.toInteger(), senderIP, senderPort);
+}
+
+void Client::m_parse_response(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    m_timeSinceLastPacket = 0.f;
+    m_handle_response(packet, (ID)senderIP.toInteger());
+}
+
+void Client::m_parse_ping(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    // only responding to the server
+    if (senderIP != getServerIP() || senderPort != getServerPort())
+    {
+        m_metrics.addDrop(DropReason::NotConnected);
+        return;
+    }
+
+    m_timeSinceLastPacket = 0.f;
+    m_send_pong(packet, senderIP, senderPort);
+}
+
+void Client::m_parse_pong(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    if (senderIP != getServerIP() || senderPort != getServerPort())
+    {
+        m_metrics.addDrop(DropReason::NotConnected);
+        return;
+    }
+
+    m_timeSinceLastPacket = 0.f;
+    m_read_pong(packet, m_rtt);
+}
+
+void Client::m_parse_shared_memory_accept(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    if (senderIP != getServerIP() || senderPort != getServerPort())
+    {
+        m_metrics.addDrop(DropReason::NotConnected);
+        return;
+    }
+
+    m_timeSinceLastPacket = 0.f;
+    m_handle_shared_memory_accept(packet, senderIP, senderPort);
+}
+
+void Client::m_parse_path_challenge(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    // only answering the server while connected (the token is only known once confirmed)
+    if (!this->isConnectionOpen() || senderIP != getServerIP() || senderPort != getServerPort())
+    {
+        m_metrics.addDrop(DropReason::NotConnected);
+        return;
+    }
+
+    std::uint64_t nonce;
+    if (!(packet >> nonce))
+    {
+        SocketMetrics::increment(m_metrics.parseErrors);
+        return;
+    }
+    m_timeSinceLastPacket = 0.f;
+    sf::Packet response = this->PathResponsePacket(nonce, m_token);
+    m_send(response, senderIP, senderPort);
 }
 
 // -------------------------
@@ -139,12 +293,20 @@ bool Client::setServerData(PORT port)
     return true;
 }
 
-void Client::sendToServer(sf::Packet& packet)
+SendResult Client::sendToServer(sf::Packet& packet)
+{
+    if (!m_connectionOpen) return SendResult::NotConnected;
+    m_wrongPassword = false;
+    assert(getServerIP().has_value() && "Must not send data to server with an invalid serverIP");
+    return m_send(packet, getServerIP().value(), getServerPort());
+}
+
+SendResult Client::sendBatchToServer(std::span<sf::Packet> packets)
 {
-    if (!m_connectionOpen) return;
+    if (!m_connectionOpen) return SendResult::NotConnected;
     m_wrongPassword = false;
     assert(getServerIP().has_value() && "Must not send data to server with an invalid serverIP");
-    m_send(packet, getServerIP().value(), getServerPort());
+    return m_send_batch(packets, getServerIP().value(), getServerPort());
 }
 
 float Client::getTimeSinceLastPacket() const
@@ -156,6 +318,50 @@ IpAddress_t Client::getServerIP() const
 unsigned int Client::getServerPort() const
 { return m_serverPort; }
 
+double Client::getRTT() const
+{ return m_rtt.getRTT(); }
+
+double Client::getRTTVariance() const
+{ return m_rtt.getRTTVariance(); }
+
+double Client::getServerClockOffset() const
+{ return m_rtt.getClockOffset(); }
+
+std::int64_t Client::getServerTime() const
+{ return getClockTime() + (std::int64_t)(m_rtt.getClockOffset() * 1000000.0); }
+
+Awaitable<bool> Client::connect()
+{
+    if (this->isConnectionOpen())
+        return Awaitable<bool>::ready(true);
+
+    m_wrongPassword = false;
+    if (!m_open_socket())
+        return Awaitable<bool>::ready(false);
+
+    auto state = std::make_shared<AsyncState<bool>>();
+    {
+        std::lock_guard lock(m_awaitMutex);
+        m_connectWaiters.push_back(state);
+        m_connectDeadline = std::chrono::steady_clock::now() + std::chrono::microseconds((std::int64_t)(m_timeoutTime * 1000000));
+    }
+
+    sf::Packet connectionPacket = m_needsPassword ? this->PasswordPacket(m_password) : this->ConnectionRequestTemplate();
+    SocketMetrics::increment(m_metrics.connectionRequests);
+    if (!isAccepted(m_send(connectionPacket, getServerIP().value(), getServerPort())))
+        m_complete_connect(false);
+
+    return Awaitable<bool>(std::move(state));
+}
+
+Awaitable<std::optional<Message>> Client::request(const sf::Packet& message, sf::Time timeout)
+{
+    if (!this->isConnectionOpen())
+        return Awaitable<std::optional<Message>>::ready(std::nullopt);
+
+    return m_send_request(message, (ID)getServerIP().value().toInteger(), getServerIP().value(), getServerPort(), timeout);
+}
+
 // * Pure Virtual Definitions
 
 bool Client::tryOpenConnection()
@@ -164,34 +370,16 @@ bool Client::tryOpenConnection()
 
     sf::Packet connectionRequest = this->ConnectionRequestTemplate();
 
-    if (getServerIP().has_value())
-    {
-        if (!this->isReceivingPackets())
-        {
-            if (this->bind(Socket::AnyPort) != sf::Socket::Status::Done)
-                return false;
-            setPort(Socket::getLocalPort());
-            startThreads(); //! needs to be called AFTER port binding
-        }
-    }
-    else
-    {
+    if (!m_open_socket())
         return false;
-    }
 
-    // checking if connecting to localhost as ID will be different in that case
-    if (getServerIP() == sf::IpAddress::LocalHost) m_id = sf::IpAddress::LocalHost.toInteger();
-
-    try
-    {
-        // if this fails socket did not open
-        m_send(connectionRequest, getServerIP().value(), getServerPort());
-    }
-    catch(const std::exception& e)
+    SocketMetrics::increment(m_metrics.connectionRequests);
+    // if this fails socket did not open
+    if (!isAccepted(m_send(connectionRequest, getServerIP().value(), getServerPort())))
     {
-        // since socket did not open stop threads and close sf::Socket
+        // since socket did not open stop threads and unbind the transport
         stopThreads();
-        sf::Socket::close();
+        m_transport->unbind();
         return false; 
     }
 
@@ -205,10 +393,11 @@ void Client::closeConnection(const std::string& reason)
 
     sf::Packet close = this->ConnectionCloseTemplate(reason);
     this->sendToServer(close);
+    SocketMetrics::increment(m_metrics.disconnects);
  
     m_reset_connection_data();
     stopThreads();
-    sf::Socket::close();
+    m_transport->unbind();
 
     this->onConnectionClose.invoke(reason, m_threadSafeEvents, m_overrideEvents);
 }
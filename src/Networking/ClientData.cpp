@@ -1,22 +1,63 @@
 #include "Networking/ClientData.hpp"
+#include "Networking/ClientPool.hpp"
 
 using namespace udp;
 
-ClientData::ClientData(unsigned short port, ID id) : port(port), id(id)
+ClientData::ClientData(const ClientPool& pool, ClientStats& stats, ID id, sf::IpAddress ip, unsigned short port) 
+    : id(id), m_pool(pool), m_stats(&stats), m_ip(ip.toInteger()), m_port(port)
 {}
 
+sf::IpAddress ClientData::getIP() const
+{
+    return sf::IpAddress(m_ip);
+}
+
+unsigned short ClientData::getPort() const
+{
+    return m_port;
+}
+
 unsigned int ClientData::getPacketsPerSecond() const
 {
-    return m_packetsPerSecond;
+    return m_pool.getPacketsPerSecond(this);
 }
 
 double ClientData::getConnectionTime() const
 {
-    return m_connectionTime;
+    return m_pool.getConnectionTime(this);
 }
 
 float ClientData::getTimeSinceLastPacket() const
 {
-    return m_timeSinceLastPacket;
+    return m_pool.getTimeSinceLastPacket(this);
+}
+
+double ClientData::getRTT() const
+{
+    return m_stats->rtt.getRTT();
+}
+
+double ClientData::getRTTVariance() const
+{
+    return m_stats->rtt.getRTTVariance();
 }
 
+double ClientData::getClockOffset() const
+{
+    return m_stats->rtt.getClockOffset();
+}
+
+const ClientMetrics& ClientData::getMetrics() const
+{
+    return m_stats->metrics;
+}
+
+HistogramSnapshot ClientData::getRTTHistogram() const
+{
+    return m_stats->rttHistogram.snapshot();
+}
+
+std::vector<TrafficSample> ClientData::getTrafficHistory() const
+{
+    return m_pool.getTrafficHistory(this);
+}
@@ -0,0 +1,333 @@
+#include "Networking/ClientPool.hpp"
+#include <new>
+#include <bit>
+#include <algorithm>
+
+using namespace udp;
+
+namespace
+{
+
+constexpr std::uint32_t SLOT_MASK = ClientPool::MAX_CLIENTS - 1;
+
+inline std::uint64_t getEndpointKey(std::uint32_t ip, unsigned short port)
+{
+    return ((std::uint64_t)ip << 16) | port;
+}
+
+}
+
+ClientPool::~ClientPool()
+{
+    clear();
+}
+
+ClientData* ClientPool::add(sf::IpAddress ip, unsigned short port)
+{
+    std::uint32_t slot;
+    if (m_freeCount != 0)
+    {
+        slot = m_freeSlots[m_freeHead];
+        m_freeHead = (m_freeHead + 1) % m_freeSlots.size();
+        m_freeCount--;
+    }
+    else
+    {
+        if (m_slotCount == getCapacity())
+        {
+            if (m_slotCount == MAX_CLIENTS)
+                return nullptr;
+            m_grow();
+        }
+        slot = m_slotCount++;
+        // the generation is never 0 so no ID is 0
+        m_generations[slot] = (std::uint16_t)std::uniform_int_distribution<std::uint32_t>(1, 0xFFFF)(m_generator);
+    }
+
+    ID id = ((ID)m_generations[slot] << SLOT_BITS) | slot;
+    ClientStats* stats = new (&m_statsChunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE]) ClientStats;
+    ClientData* client = new (&m_chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE]) ClientData(*this, *stats, id, ip, port);
+    client->m_token = makeToken();
+    m_used[slot] = 1;
+    double now = m_time.load(std::memory_order_relaxed);
+    m_lastPacketTime[slot] = now;
+    m_lastPingTime[slot] = now;
+    m_connectTime[slot] = now;
+    m_packetsSent[slot] = 0;
+    m_packetsPerSecond[slot] = 0;
+    m_size++;
+    m_insert_endpoint(getEndpointKey(client->m_ip, client->m_port), slot);
+    return client;
+}
+
+void ClientPool::remove(ClientData* client)
+{
+    std::uint32_t slot = getSlot(client->id);
+    m_erase_endpoint(getEndpointKey(client->m_ip, client->m_port), slot);
+    client->m_stats->~ClientStats();
+    client->~ClientData();
+    m_used[slot] = 0;
+    m_size--;
+
+    // a new generation so the old ID is no longer valid
+    m_generations[slot]++;
+    if (m_generations[slot] == 0)
+        m_generations[slot] = 1;
+    m_freeSlots[(m_freeHead + m_freeCount) % m_freeSlots.size()] = slot;
+    m_freeCount++;
+}
+
+void ClientPool::clear()
+{
+    for (ClientData* client: *this)
+        remove(client);
+}
+
+void ClientPool::move(ClientData* client, sf::IpAddress ip, unsigned short port)
+{
+    std::uint32_t slot = getSlot(client->id);
+    m_erase_endpoint(getEndpointKey(client->m_ip, client->m_port), slot);
+    client->m_ip = ip.toInteger();
+    client->m_port = port;
+    m_insert_endpoint(getEndpointKey(client->m_ip, client->m_port), slot);
+}
+
+ClientData* ClientPool::get(ID id) const
+{
+    std::uint32_t slot = getSlot(id);
+    if (slot >= m_slotCount || !m_used[slot] || m_generations[slot] != (id >> SLOT_BITS))
+        return nullptr;
+    return m_get(slot);
+}
+
+ClientData* ClientPool::find(sf::IpAddress ip, unsigned short port) const
+{
+    if (m_endpoints.empty())
+        return nullptr;
+
+    std::uint64_t key = getEndpointKey(ip.toInteger(), port);
+    std::size_t mask = m_endpoints.size() - 1;
+    for (std::size_t i = m_get_home(key); m_endpoints[i].slot != Endpoint::EMPTY; i = (i + 1) & mask)
+    {
+        if (m_endpoints[i].key == key)
+            return m_get(m_endpoints[i].slot);
+    }
+    return nullptr;
+}
+
+std::size_t ClientPool::size() const
+{
+    return m_size;
+}
+
+bool ClientPool::empty() const
+{
+    return m_size == 0;
+}
+
+std::size_t ClientPool::getCapacity() const
+{
+    return m_chunks.size() * CHUNK_SIZE;
+}
+
+ClientPool::Iterator ClientPool::begin() const
+{
+    return Iterator(this, 0);
+}
+
+ClientPool::Iterator ClientPool::end() const
+{
+    return Iterator(this, m_slotCount);
+}
+
+std::uint32_t ClientPool::getSlot(ID id)
+{
+    return id & SLOT_MASK;
+}
+
+std::uint64_t ClientPool::makeToken()
+{
+    // only used when clients connect or change address so going to the system every time is fine
+    thread_local std::random_device source;
+    std::uint64_t token;
+    do
+        token = ((std::uint64_t)source() << 32) | source();
+    while (token == 0);
+    return token;
+}
+
+//* Hot State
+
+// the sweeps go through the arrays in slot order, free slots are reset when they are used again
+// anything a receiving thread can write while the pool is shared locked is only accessed through relaxed atomics
+
+void ClientPool::addTime(float deltaTime)
+{
+    m_time.store(m_time.load(std::memory_order_relaxed) + deltaTime, std::memory_order_relaxed);
+}
+
+void ClientPool::getTimedOut(float timeout, std::vector<ID>& timedOut) const
+{
+    // a client is timed out once its last packet is from before this
+    const double cutoff = m_time.load(std::memory_order_relaxed) - timeout;
+    const std::uint32_t count = m_slotCount;
+    for (std::uint32_t i = 0; i < count; i++)
+    {
+        if (m_used[i] && m_load(m_lastPacketTime[i]) <= cutoff)
+            timedOut.push_back(((ID)m_generations[i] << SLOT_BITS) | i);
+    }
+}
+
+void ClientPool::getPingsDue(float interval, std::vector<ClientData*>& due)
+{
+    const double now = m_time.load(std::memory_order_relaxed);
+    const double cutoff = now - interval;
+    const std::uint32_t count = m_slotCount;
+    for (std::uint32_t i = 0; i < count; i++)
+    {
+        if (m_used[i] && m_lastPingTime[i] <= cutoff)
+        {
+            m_lastPingTime[i] = now;
+            due.push_back(m_get(i));
+        }
+    }
+}
+
+void ClientPool::updatePacketsPerSecond()
+{
+    const std::uint32_t count = m_slotCount;
+    for (std::uint32_t i = 0; i < count; i++)
+    {
+        // exchanged so a packet counted between reading and clearing the count is not lost
+        std::uint32_t packets = std::atomic_ref(m_packetsSent[i]).exchange(0, std::memory_order_relaxed);
+        std::atomic_ref(m_packetsPerSecond[i]).store(packets, std::memory_order_relaxed);
+    }
+}
+
+float ClientPool::getTimeSinceLastPacket(const ClientData* client) const
+{
+    double lastPacketTime = m_load(m_lastPacketTime[getSlot(client->id)]);
+    return (float)std::max(m_time.load(std::memory_order_relaxed) - lastPacketTime, 0.0);
+}
+
+double ClientPool::getConnectionTime(const ClientData* client) const
+{
+    return m_time.load(std::memory_order_relaxed) - m_connectTime[getSlot(client->id)];
+}
+
+unsigned int ClientPool::getPacketsPerSecond(const ClientData* client) const
+{
+    return m_load(m_packetsPerSecond[getSlot(client->id)]);
+}
+
+// -----------
+
+//* Traffic History
+
+void ClientPool::recordTraffic()
+{
+    std::lock_guard lock(m_trafficMutex);
+    const std::uint32_t count = m_slotCount;
+    for (std::uint32_t i = 0; i < count; i++)
+    {
+        if (!m_used[i])
+            continue;
+        ClientStats& stats = *m_get_stats(i);
+        const ClientMetrics& metrics = stats.metrics;
+        stats.traffic.record({metrics.bytesIn.load(std::memory_order_relaxed), metrics.bytesOut.load(std::memory_order_relaxed),
+                              metrics.packetsIn.load(std::memory_order_relaxed), metrics.packetsOut.load(std::memory_order_relaxed),
+                              metrics.pingsOut.load(std::memory_order_relaxed), metrics.pongsIn.load(std::memory_order_relaxed)}, (float)stats.rtt.getRTT());
+    }
+}
+
+std::vector<TrafficSample> ClientPool::getTrafficHistory(const ClientData* client) const
+{
+    std::lock_guard lock(m_trafficMutex);
+    return client->m_stats->traffic.getSamples();
+}
+
+// ---------------
+
+ClientData* ClientPool::m_get(std::uint32_t slot) const
+{
+    return std::launder(reinterpret_cast<ClientData*>(&m_chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE]));
+}
+
+ClientStats* ClientPool::m_get_stats(std::uint32_t slot) const
+{
+    return std::launder(reinterpret_cast<ClientStats*>(&m_statsChunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE]));
+}
+
+void ClientPool::m_grow()
+{
+    m_chunks.emplace_back(new Storage[CHUNK_SIZE]);
+    m_statsChunks.emplace_back(new StatsStorage[CHUNK_SIZE]);
+    std::size_t capacity = getCapacity();
+    m_generations.resize(capacity);
+    m_used.resize(capacity);
+    m_lastPacketTime.resize(capacity);
+    m_lastPingTime.resize(capacity);
+    m_connectTime.resize(capacity);
+    m_packetsSent.resize(capacity);
+    m_packetsPerSecond.resize(capacity);
+    // only grown when there are no free slots so the ring can start over
+    m_freeSlots.resize(capacity);
+    m_freeHead = 0;
+
+    if (m_endpoints.size() >= capacity * 2)
+        return;
+    std::vector<Endpoint> old;
+    old.swap(m_endpoints);
+    m_endpoints.resize(std::bit_ceil(capacity * 2));
+    for (auto& endpoint: old)
+    {
+        if (endpoint.slot != Endpoint::EMPTY)
+            m_insert_endpoint(endpoint.key, endpoint.slot);
+    }
+}
+
+std::size_t ClientPool::m_get_home(std::uint64_t key) const
+{
+    return (std::size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (m_endpoints.size() - 1);
+}
+
+void ClientPool::m_insert_endpoint(std::uint64_t key, std::uint32_t slot)
+{
+    // the table is at least twice the number of clients so there is always an empty entry
+    std::size_t mask = m_endpoints.size() - 1;
+    std::size_t i = m_get_home(key);
+    while (m_endpoints[i].slot != Endpoint::EMPTY && m_endpoints[i].key != key)
+        i = (i + 1) & mask;
+    m_endpoints[i].key = key;
+    m_endpoints[i].slot = slot;
+}
+
+void ClientPool::m_erase_endpoint(std::uint64_t key, std::uint32_t slot)
+{
+    std::size_t mask = m_endpoints.size() - 1;
+    std::size_t i = m_get_home(key);
+    while (m_endpoints[i].key != key)
+    {
+        if (m_endpoints[i].slot == Endpoint::EMPTY)
+            return;
+        i = (i + 1) & mask;
+    }
+    if (m_endpoints[i].slot == Endpoint::EMPTY)
+        return;
+    // another client took the address since this one moved away from it
+    if (m_endpoints[i].slot != slot)
+        return;
+
+    // moving later entries back so no lookup stops early at the gap
+    for (std::size_t j = (i + 1) & mask; m_endpoints[j].slot != Endpoint::EMPTY; j = (j + 1) & mask)
+    {
+        std::size_t home = m_get_home(m_endpoints[j].key);
+        bool canMove = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+        if (canMove)
+        {
+            m_endpoints[i] = m_endpoints[j];
+            i = j;
+        }
+    }
+    m_endpoints[i] = Endpoint{};
+}
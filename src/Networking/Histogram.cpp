@@ -0,0 +1,125 @@
+#include "Networking/Histogram.hpp"
+
+using namespace udp;
+
+//* Layout
+
+std::uint64_t HistogramLayout::getLowerBound(std::size_t index)
+{
+    if (index < SUB_BUCKETS)
+        return index;
+    std::uint32_t shift = (std::uint32_t)(index / SUB_BUCKETS) - 1;
+    return (std::uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+}
+
+std::uint64_t HistogramLayout::getUpperBound(std::size_t index)
+{
+    if (index < SUB_BUCKETS)
+        return index;
+    std::uint32_t shift = (std::uint32_t)(index / SUB_BUCKETS) - 1;
+    return getLowerBound(index) + (std::uint64_t(1) << shift) - 1;
+}
+
+// ------
+
+//* Snapshot
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other)
+{
+    for (std::size_t i = 0; i < buckets.size(); i++)
+        buckets[i] += other.buckets[i];
+    count += other.count;
+    sum += other.sum;
+}
+
+double HistogramSnapshot::getPercentile(double percentile) const
+{
+    // the count is summed from the buckets since it could be off by a few if values were recorded while copying
+    std::uint64_t total = 0;
+    for (auto bucket: buckets)
+        total += bucket;
+    if (total == 0)
+        return 0.0;
+
+    percentile = percentile < 0.0 ? 0.0 : (percentile > 100.0 ? 100.0 : percentile);
+    std::uint64_t target = (std::uint64_t)(percentile / 100.0 * (double)total + 0.5);
+    if (target == 0)
+        target = 1;
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); i++)
+    {
+        seen += buckets[i];
+        if (seen >= target)
+            return (double)HistogramLayout::getUpperBound(i) / 1000000000.0;
+    }
+    return (double)HistogramLayout::MAX_VALUE / 1000000000.0;
+}
+
+double HistogramSnapshot::getMin() const
+{
+    for (std::size_t i = 0; i < buckets.size(); i++)
+    {
+        if (buckets[i] != 0)
+            return (double)HistogramLayout::getLowerBound(i) / 1000000000.0;
+    }
+    return 0.0;
+}
+
+double HistogramSnapshot::getMax() const
+{
+    for (std::size_t i = buckets.size(); i > 0; i--)
+    {
+        if (buckets[i - 1] != 0)
+            return (double)HistogramLayout::getUpperBound(i - 1) / 1000000000.0;
+    }
+    return 0.0;
+}
+
+double HistogramSnapshot::getMean() const
+{
+    if (count == 0)
+        return 0.0;
+    return (double)sum / (double)count / 1000000000.0;
+}
+
+// ---------
+
+//* Histogram
+
+void Histogram::recordSeconds(double seconds)
+{
+    record(seconds <= 0.0 ? 0 : (std::uint64_t)(seconds * 1000000000.0));
+}
+
+void Histogram::merge(const Histogram& other)
+{
+    for (std::size_t i = 0; i < m_buckets.size(); i++)
+    {
+        std::uint64_t count = other.m_buckets[i].load(std::memory_order_relaxed);
+        if (count != 0)
+            m_buckets[i].fetch_add(count, std::memory_order_relaxed);
+    }
+    m_count.fetch_add(other.m_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::snapshot() const
+{
+    HistogramSnapshot snapshot;
+    for (std::size_t i = 0; i < m_buckets.size(); i++)
+        snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    snapshot.count = m_count.load(std::memory_order_relaxed);
+    snapshot.sum = m_sum.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void Histogram::reset()
+{
+    for (auto& bucket: m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    m_count = 0;
+    m_sum = 0;
+}
+
+// ---------
@@ -0,0 +1,210 @@
+#include "Networking/MemoryTransport.hpp"
+#include <mutex>
+#include <chrono>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace udp;
+
+namespace
+{
+
+/// @brief every bound memory transport in the process
+struct MemoryNetwork
+{
+    std::shared_mutex mutex;
+    std::unordered_map<std::uint64_t, std::shared_ptr<MemoryTransport::Endpoint>> endpoints;
+    std::atomic<std::uint32_t> nextAddress = 1;
+};
+
+MemoryNetwork& getMemoryNetwork()
+{
+    static MemoryNetwork network;
+    return network;
+}
+
+std::uint64_t getEndpointKey(std::uint32_t address, unsigned short port)
+{
+    return ((std::uint64_t)address << 16) | port;
+}
+
+constexpr unsigned short FIRST_EPHEMERAL_PORT = 49152;
+
+}
+
+//* initializer and deconstructor
+
+MemoryTransport::MemoryTransport(std::optional<sf::IpAddress> address, std::size_t queueCapacity) : 
+    m_address(address.value_or(sf::IpAddress((10u << 24) | getMemoryNetwork().nextAddress.fetch_add(1)))), m_queueCapacity(queueCapacity) {}
+
+MemoryTransport::~MemoryTransport()
+{
+    unbind();
+}
+
+// ------------------------------
+
+//* Transport Functions
+
+sf::Socket::Status MemoryTransport::bind(unsigned short port)
+{
+    unbind();
+
+    MemoryNetwork& network = getMemoryNetwork();
+    std::lock_guard lock(network.mutex);
+
+    if (port == 0)
+    {
+        for (unsigned int i = FIRST_EPHEMERAL_PORT; i <= 65535; i++)
+        {
+            if (!network.endpoints.contains(getEndpointKey(m_address.toInteger(), (unsigned short)i)))
+            {
+                port = (unsigned short)i;
+                break;
+            }
+        }
+        if (port == 0)
+            return sf::Socket::Status::Error;
+    }
+    else if (network.endpoints.contains(getEndpointKey(m_address.toInteger(), port)))
+        return sf::Socket::Status::Error;
+
+    m_endpoint = std::make_shared<Endpoint>(m_queueCapacity);
+    m_endpoint->timestamps = m_timestampsEnabled;
+    network.endpoints.emplace(getEndpointKey(m_address.toInteger(), port), m_endpoint);
+    m_port = port;
+    return sf::Socket::Status::Done;
+}
+
+void MemoryTransport::unbind()
+{
+    if (m_endpoint == nullptr)
+        return;
+
+    MemoryNetwork& network = getMemoryNetwork();
+    {
+        std::lock_guard lock(network.mutex);
+        network.endpoints.erase(getEndpointKey(m_address.toInteger(), m_port));
+    }
+    m_endpoint = nullptr;
+    m_port = 0;
+}
+
+unsigned short MemoryTransport::getLocalPort() const
+{
+    return m_port;
+}
+
+sf::Socket::Status MemoryTransport::send(sf::Packet& packet, sf::IpAddress ip, unsigned short port)
+{
+    if (packet.getDataSize() > sf::UdpSocket::MaxDatagramSize)
+        return sf::Socket::Status::Error;
+
+    std::shared_ptr<Endpoint> endpoint;
+    {
+        MemoryNetwork& network = getMemoryNetwork();
+        std::shared_lock lock(network.mutex);
+        auto iter = network.endpoints.find(getEndpointKey(ip.toInteger(), port));
+        // nothing is listening so the packet is lost
+        if (iter == network.endpoints.end())
+            return sf::Socket::Status::Done;
+        endpoint = iter->second;
+    }
+
+    Datagram datagram;
+    datagram.packet.append(packet.getData(), packet.getDataSize());
+    datagram.senderIP = m_address.toInteger();
+    datagram.senderPort = m_port;
+    if (endpoint->timestamps.load(std::memory_order_relaxed))
+        datagram.arrivalTime = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (!endpoint->queue.push(datagram))
+    {
+        endpoint->dropped.fetch_add(1, std::memory_order_relaxed);
+        return sf::Socket::Status::Done;
+    }
+
+    endpoint->signal.fetch_add(1);
+    // only making the system call if the receiver is actually sleeping
+    if (endpoint->waiting.load())
+        endpoint->signal.notify_one();
+    return sf::Socket::Status::Done;
+}
+
+sf::Socket::Status MemoryTransport::receive(sf::Packet& packet, std::optional<sf::IpAddress>& senderIP, unsigned short& senderPort)
+{
+    if (m_endpoint == nullptr)
+        return sf::Socket::Status::Error;
+
+    Endpoint& endpoint = *m_endpoint;
+    Datagram datagram;
+    while (!endpoint.queue.pop(datagram))
+    {
+        if (endpoint.interrupted.exchange(false))
+            return sf::Socket::Status::NotReady;
+
+        std::uint32_t signal = endpoint.signal.load();
+        endpoint.waiting = true;
+        // checking again now that senders know to wake us up
+        if (endpoint.queue.pop(datagram))
+        {
+            endpoint.waiting = false;
+            break;
+        }
+        if (endpoint.interrupted.exchange(false))
+        {
+            endpoint.waiting = false;
+            return sf::Socket::Status::NotReady;
+        }
+        endpoint.signal.wait(signal);
+        endpoint.waiting = false;
+    }
+
+    std::swap(packet, datagram.packet);
+    senderIP = sf::IpAddress(datagram.senderIP);
+    senderPort = datagram.senderPort;
+    m_receiveTimestamp = datagram.arrivalTime;
+    return sf::Socket::Status::Done;
+}
+
+void MemoryTransport::interrupt()
+{
+    if (m_endpoint == nullptr)
+        return;
+
+    m_endpoint->interrupted = true;
+    m_endpoint->signal.fetch_add(1);
+    m_endpoint->signal.notify_all();
+}
+
+// ------------------------
+
+//* Getters
+
+sf::IpAddress MemoryTransport::getAddress() const
+{
+    return m_address;
+}
+
+std::uint64_t MemoryTransport::getDroppedCount() const
+{
+    if (m_endpoint == nullptr)
+        return 0;
+    return m_endpoint->dropped;
+}
+
+std::uint64_t MemoryTransport::getReceiveOverflowCount() const
+{
+    return getDroppedCount();
+}
+
+void MemoryTransport::setTimestampsEnabled(bool enabled)
+{
+    m_timestampsEnabled = enabled;
+    if (m_endpoint != nullptr)
+        m_endpoint->timestamps = enabled;
+}
+
+std::uint64_t MemoryTransport::getReceiveTimestamp() const
+{
+    return m_receiveTimestamp;
+}
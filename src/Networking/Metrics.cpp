@@ -0,0 +1,64 @@
+#include "Networking/Metrics.hpp"
+
+using namespace udp;
+
+const char* udp::toString(DropReason reason)
+{
+    switch (reason)
+    {
+    case DropReason::QueueFull:
+        return "queue_full";
+    case DropReason::NotConnected:
+        return "not_connected";
+    case DropReason::Simulated:
+        return "simulated";
+    case DropReason::ReceiveOverflow:
+        return "receive_overflow";
+    default:
+        return "unknown";
+    }
+}
+
+void SocketMetrics::reset()
+{
+    packetsIn = 0;
+    bytesIn = 0;
+    packetsOut = 0;
+    bytesOut = 0;
+    parseErrors = 0;
+    sendFailures = 0;
+    sendWouldBlock = 0;
+    sendQueueDrops = 0;
+    for (auto& drop: drops)
+        drop = 0;
+    connectionRequests = 0;
+    connectionsOpened = 0;
+    passwordFailures = 0;
+    disconnects = 0;
+    timeouts = 0;
+    addressChanges = 0;
+    pingsOut = 0;
+    pongsIn = 0;
+}
+
+void MetricsSnapshot::copyCounters(const SocketMetrics& metrics)
+{
+    packetsIn = metrics.packetsIn.load(std::memory_order_relaxed);
+    bytesIn = metrics.bytesIn.load(std::memory_order_relaxed);
+    packetsOut = metrics.packetsOut.load(std::memory_order_relaxed);
+    bytesOut = metrics.bytesOut.load(std::memory_order_relaxed);
+    parseErrors = metrics.parseErrors.load(std::memory_order_relaxed);
+    sendFailures = metrics.sendFailures.load(std::memory_order_relaxed);
+    sendWouldBlock = metrics.sendWouldBlock.load(std::memory_order_relaxed);
+    sendQueueDrops = metrics.sendQueueDrops.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < drops.size(); i++)
+        drops[i] = metrics.drops[i].load(std::memory_order_relaxed);
+    connectionRequests = metrics.connectionRequests.load(std::memory_order_relaxed);
+    connectionsOpened = metrics.connectionsOpened.load(std::memory_order_relaxed);
+    passwordFailures = metrics.passwordFailures.load(std::memory_order_relaxed);
+    disconnects = metrics.disconnects.load(std::memory_order_relaxed);
+    timeouts = metrics.timeouts.load(std::memory_order_relaxed);
+    addressChanges = metrics.addressChanges.load(std::memory_order_relaxed);
+    pingsOut = metrics.pingsOut.load(std::memory_order_relaxed);
+    pongsIn = metrics.pongsIn.load(std::memory_order_relaxed);
+}
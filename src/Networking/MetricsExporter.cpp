@@ -0,0 +1,306 @@
+#include "Networking/MetricsExporter.hpp"
+#include "Networking/Socket.hpp"
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <functional>
+
+#include <SFML/Network/IpAddress.hpp>
+
+using namespace udp;
+
+namespace
+{
+
+using Snapshots = std::vector<std::pair<std::string, MetricsSnapshot>>;
+
+/// @returns the string with quotes, backslashes and new lines escaped (same rules for prometheus labels and json)
+std::string escape(const std::string& str)
+{
+    std::string rtn;
+    rtn.reserve(str.size());
+    for (char c: str)
+    {
+        if (c == '\\' || c == '"')
+        {
+            rtn += '\\';
+            rtn += c;
+        }
+        else if (c == '\n')
+            rtn += "\\n";
+        else
+            rtn += c;
+    }
+    return rtn;
+}
+
+std::string clientLabels(const std::string& socket, const ClientMetricsSnapshot& client)
+{
+    return "socket=\"" + escape(socket) + "\",client=\"" + std::to_string(client.id) + "\",ip=\"" + sf::IpAddress(client.ip).toString() + "\",port=\"" + std::to_string(client.port) + "\"";
+}
+
+/// @brief writes the help and type lines followed by one sample per socket
+void writeMetric(std::ostream& out, const Snapshots& snapshots, const char* name, const char* type, const char* help,
+                 const std::function<double(const MetricsSnapshot&)>& value)
+{
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+    for (auto& [socket, snapshot]: snapshots)
+        out << name << "{socket=\"" << escape(socket) << "\"} " << value(snapshot) << '\n';
+}
+
+/// @brief writes the help and type lines followed by one sample per client of every socket
+void writeClientMetric(std::ostream& out, const Snapshots& snapshots, const char* name, const char* type, const char* help,
+                       const std::function<double(const ClientMetricsSnapshot&)>& value)
+{
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+    for (auto& [socket, snapshot]: snapshots)
+        for (auto& client: snapshot.clients)
+            out << name << '{' << clientLabels(socket, client) << "} " << value(client) << '\n';
+}
+
+}
+
+//* initializer and deconstructor
+
+MetricsExporter::MetricsExporter(const std::string& path, Format format, float interval) : m_path(path), m_format(format), m_interval(interval) {}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+// ------------------------------
+
+//* Protected Functions
+
+void MetricsExporter::m_thread_function(std::stop_token sToken)
+{
+    while (!sToken.stop_requested())
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            auto wait = std::chrono::duration<float>(std::max(m_interval, 0.01f));
+            m_condition.wait_for(lock, sToken, wait, [](){ return false; });
+        }
+        writeNow();
+    }
+}
+
+// ------------------------
+
+//* Public Functions
+
+void MetricsExporter::add(const std::string& name, const Socket& socket)
+{
+    std::lock_guard lock(m_mutex);
+    for (auto& pair: m_sockets)
+    {
+        if (pair.first == name)
+        {
+            pair.second = &socket;
+            return;
+        }
+    }
+    m_sockets.emplace_back(name, &socket);
+}
+
+void MetricsExporter::remove(const std::string& name)
+{
+    std::lock_guard lock(m_mutex);
+    std::erase_if(m_sockets, [&name](const auto& pair){ return pair.first == name; });
+}
+
+void MetricsExporter::start()
+{
+    std::lock_guard lock(m_mutex);
+    if (m_thread != nullptr)
+        return;
+    m_thread = new std::jthread([this](std::stop_token sToken){ m_thread_function(sToken); });
+}
+
+void MetricsExporter::stop()
+{
+    std::jthread* thread;
+    {
+        std::lock_guard lock(m_mutex);
+        thread = m_thread;
+        m_thread = nullptr;
+    }
+    if (thread == nullptr)
+        return;
+
+    // request_stop wakes the thread which then writes one last time before exiting
+    thread->request_stop();
+    thread->join();
+    delete(thread);
+}
+
+bool MetricsExporter::isRunning() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_thread != nullptr;
+}
+
+bool MetricsExporter::writeNow()
+{
+    Snapshots snapshots;
+    Format format;
+    {
+        // holding the lock while taking snapshots so a socket can not be removed part way through
+        std::lock_guard lock(m_mutex);
+        snapshots.reserve(m_sockets.size());
+        for (auto& [name, socket]: m_sockets)
+            snapshots.emplace_back(name, socket->getMetrics());
+        format = m_format;
+    }
+
+    std::string data = format == Format::Prometheus ? toPrometheus(snapshots) : toJson(snapshots);
+
+    std::lock_guard lock(m_writeMutex);
+    std::string tempPath = m_path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file << data;
+        if (!file.flush())
+            return false;
+    }
+    return std::rename(tempPath.c_str(), m_path.c_str()) == 0;
+}
+
+void MetricsExporter::setInterval(float interval)
+{
+    std::lock_guard lock(m_mutex);
+    m_interval = interval;
+}
+
+float MetricsExporter::getInterval() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_interval;
+}
+
+void MetricsExporter::setFormat(Format format)
+{
+    std::lock_guard lock(m_mutex);
+    m_format = format;
+}
+
+MetricsExporter::Format MetricsExporter::getFormat() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_format;
+}
+
+// ------------------------
+
+//* Formatting Functions
+
+std::string MetricsExporter::toPrometheus(const Snapshots& snapshots)
+{
+    std::ostringstream out;
+
+    writeMetric(out, snapshots, "udp_packets_in_total", "counter", "Packets received.", [](auto& s){ return (double)s.packetsIn; });
+    writeMetric(out, snapshots, "udp_bytes_in_total", "counter", "Bytes received.", [](auto& s){ return (double)s.bytesIn; });
+    writeMetric(out, snapshots, "udp_packets_out_total", "counter", "Packets sent.", [](auto& s){ return (double)s.packetsOut; });
+    writeMetric(out, snapshots, "udp_bytes_out_total", "counter", "Bytes sent.", [](auto& s){ return (double)s.bytesOut; });
+    writeMetric(out, snapshots, "udp_parse_errors_total", "counter", "Packets with a missing or unknown type.", [](auto& s){ return (double)s.parseErrors; });
+    writeMetric(out, snapshots, "udp_send_failures_total", "counter", "Sends that failed in the transport.", [](auto& s){ return (double)s.sendFailures; });
+    writeMetric(out, snapshots, "udp_send_would_block_total", "counter", "Sends that the transport would have blocked on.", [](auto& s){ return (double)s.sendWouldBlock; });
+    writeMetric(out, snapshots, "udp_send_queue_drops_total", "counter", "Packets dropped because the send queue of their destination was full.", [](auto& s){ return (double)s.sendQueueDrops; });
+
+    out << "# HELP udp_drops_total Received packets that were thrown away.\n";
+    out << "# TYPE udp_drops_total counter\n";
+    for (auto& [socket, snapshot]: snapshots)
+        for (std::size_t i = 0; i < snapshot.drops.size(); i++)
+            out << "udp_drops_total{socket=\"" << escape(socket) << "\",reason=\"" << toString((DropReason)i) << "\"} " << snapshot.drops[i] << '\n';
+
+    writeMetric(out, snapshots, "udp_connection_requests_total", "counter", "Connection requests sent or received.", [](auto& s){ return (double)s.connectionRequests; });
+    writeMetric(out, snapshots, "udp_connections_opened_total", "counter", "Connections that were confirmed.", [](auto& s){ return (double)s.connectionsOpened; });
+    writeMetric(out, snapshots, "udp_password_failures_total", "counter", "Wrong passwords.", [](auto& s){ return (double)s.passwordFailures; });
+    writeMetric(out, snapshots, "udp_disconnects_total", "counter", "Connections that were closed.", [](auto& s){ return (double)s.disconnects; });
+    writeMetric(out, snapshots, "udp_timeouts_total", "counter", "Connections that timed out.", [](auto& s){ return (double)s.timeouts; });
+    writeMetric(out, snapshots, "udp_address_changes_total", "counter", "Clients that kept their connection when their address changed.", [](auto& s){ return (double)s.addressChanges; });
+    writeMetric(out, snapshots, "udp_pings_out_total", "counter", "Pings sent.", [](auto& s){ return (double)s.pingsOut; });
+    writeMetric(out, snapshots, "udp_pongs_in_total", "counter", "Pongs received for sent pings.", [](auto& s){ return (double)s.pongsIn; });
+
+    writeMetric(out, snapshots, "udp_connection_open", "gauge", "1 if the connection is open.", [](auto& s){ return s.connectionOpen ? 1.0 : 0.0; });
+    writeMetric(out, snapshots, "udp_message_queue_depth", "gauge", "Messages waiting to be polled.", [](auto& s){ return (double)s.messageQueueDepth; });
+    writeMetric(out, snapshots, "udp_message_queue_capacity", "gauge", "Message queue capacity.", [](auto& s){ return (double)s.messageQueueCapacity; });
+    writeMetric(out, snapshots, "udp_send_queue_depth", "gauge", "Packets waiting for the transport to be writable.", [](auto& s){ return (double)s.sendQueueDepth; });
+    writeMetric(out, snapshots, "udp_send_queue_capacity", "gauge", "Send queue capacity for each destination.", [](auto& s){ return (double)s.sendQueueCapacity; });
+    writeMetric(out, snapshots, "udp_simulator_incoming_pending", "gauge", "Packets held by the incoming network simulator.", [](auto& s){ return (double)s.simulatorIncomingPending; });
+    writeMetric(out, snapshots, "udp_simulator_outgoing_pending", "gauge", "Packets held by the outgoing network simulator.", [](auto& s){ return (double)s.simulatorOutgoingPending; });
+    writeMetric(out, snapshots, "udp_shared_memory_channels", "gauge", "Open shared memory channels.", [](auto& s){ return (double)s.sharedMemoryChannels; });
+    writeMetric(out, snapshots, "udp_clients", "gauge", "Connected clients.", [](auto& s){ return (double)s.clients.size(); });
+
+    writeMetric(out, snapshots, "udp_ticks_total", "counter", "Update ticks run.", [](auto& s){ return (double)s.ticks.ticks; });
+    writeMetric(out, snapshots, "udp_ticks_missed_total", "counter", "Update ticks skipped.", [](auto& s){ return (double)s.ticks.missedTicks; });
+    writeMetric(out, snapshots, "udp_tick_overruns_total", "counter", "Update ticks that took longer than the interval.", [](auto& s){ return (double)s.ticks.overruns; });
+    writeMetric(out, snapshots, "udp_tick_duration_average_seconds", "gauge", "Average update tick duration.", [](auto& s){ return s.ticks.averageTickDuration; });
+    writeMetric(out, snapshots, "udp_tick_duration_max_seconds", "gauge", "Longest update tick duration.", [](auto& s){ return s.ticks.maxTickDuration; });
+
+    writeClientMetric(out, snapshots, "udp_client_packets_in_total", "counter", "Packets received from the client.", [](auto& c){ return (double)c.packetsIn; });
+    writeClientMetric(out, snapshots, "udp_client_bytes_in_total", "counter", "Bytes received from the client.", [](auto& c){ return (double)c.bytesIn; });
+    writeClientMetric(out, snapshots, "udp_client_packets_out_total", "counter", "Packets sent to the client.", [](auto& c){ return (double)c.packetsOut; });
+    writeClientMetric(out, snapshots, "udp_client_bytes_out_total", "counter", "Bytes sent to the client.", [](auto& c){ return (double)c.bytesOut; });
+    writeClientMetric(out, snapshots, "udp_client_packets_per_second", "gauge", "Packets received from the client in the last second.", [](auto& c){ return (double)c.packetsPerSecond; });
+    writeClientMetric(out, snapshots, "udp_client_rtt_seconds", "gauge", "Smoothed round trip time.", [](auto& c){ return c.rtt; });
+    writeClientMetric(out, snapshots, "udp_client_connection_seconds", "gauge", "Time the client has been connected.", [](auto& c){ return c.connectionTime; });
+    writeClientMetric(out, snapshots, "udp_client_send_queue_depth", "gauge", "Packets waiting to be sent to the client.", [](auto& c){ return (double)c.sendQueueDepth; });
+
+    return out.str();
+}
+
+std::string MetricsExporter::toJson(const Snapshots& snapshots)
+{
+    std::ostringstream out;
+    out << "{";
+    for (std::size_t i = 0; i < snapshots.size(); i++)
+    {
+        auto& [socket, s] = snapshots[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "  \"" << escape(socket) << "\": {\n";
+        out << "    \"time\": " << s.time << ",\n";
+        out << "    \"packetsIn\": " << s.packetsIn << ", \"bytesIn\": " << s.bytesIn << ",\n";
+        out << "    \"packetsOut\": " << s.packetsOut << ", \"bytesOut\": " << s.bytesOut << ",\n";
+        out << "    \"parseErrors\": " << s.parseErrors << ", \"sendFailures\": " << s.sendFailures
+            << ", \"sendWouldBlock\": " << s.sendWouldBlock << ", \"sendQueueDrops\": " << s.sendQueueDrops << ",\n";
+        out << "    \"drops\": {";
+        for (std::size_t r = 0; r < s.drops.size(); r++)
+            out << (r == 0 ? "" : ", ") << '"' << toString((DropReason)r) << "\": " << s.drops[r];
+        out << "},\n";
+        out << "    \"connectionRequests\": " << s.connectionRequests << ", \"connectionsOpened\": " << s.connectionsOpened
+            << ", \"passwordFailures\": " << s.passwordFailures << ", \"disconnects\": " << s.disconnects << ", \"timeouts\": " << s.timeouts << ", \"addressChanges\": " << s.addressChanges << ",\n";
+        out << "    \"pingsOut\": " << s.pingsOut << ", \"pongsIn\": " << s.pongsIn << ",\n";
+        out << "    \"connectionOpen\": " << (s.connectionOpen ? "true" : "false") << ",\n";
+        out << "    \"messageQueueDepth\": " << s.messageQueueDepth << ", \"messageQueueCapacity\": " << s.messageQueueCapacity << ",\n";
+        out << "    \"sendQueueDepth\": " << s.sendQueueDepth << ", \"sendQueueCapacity\": " << s.sendQueueCapacity << ",\n";
+        out << "    \"simulatorIncomingPending\": " << s.simulatorIncomingPending << ", \"simulatorOutgoingPending\": " << s.simulatorOutgoingPending << ",\n";
+        out << "    \"sharedMemoryChannels\": " << s.sharedMemoryChannels << ",\n";
+        out << "    \"ticks\": {\"ticks\": " << s.ticks.ticks << ", \"missed\": " << s.ticks.missedTicks << ", \"overruns\": " << s.ticks.overruns
+            << ", \"averageDuration\": " << s.ticks.averageTickDuration << ", \"maxDuration\": " << s.ticks.maxTickDuration
+            << ", \"averageJitter\": " << s.ticks.averageJitter << ", \"maxJitter\": " << s.ticks.maxJitter << "},\n";
+        out << "    \"clients\": [";
+        for (std::size_t c = 0; c < s.clients.size(); c++)
+        {
+            auto& client = s.clients[c];
+            out << (c == 0 ? "\n" : ",\n");
+            out << "      {\"id\": " << client.id << ", \"ip\": \"" << sf::IpAddress(client.ip).toString() << "\", \"port\": " << client.port
+                << ", \"packetsIn\": " << client.packetsIn << ", \"bytesIn\": " << client.bytesIn
+                << ", \"packetsOut\": " << client.packetsOut << ", \"bytesOut\": " << client.bytesOut
+                << ", \"packetsPerSecond\": " << client.packetsPerSecond << ", \"rtt\": " << client.rtt
+                << ", \"connectionTime\": " << client.connectionTime << ", \"sendQueueDepth\": " << client.sendQueueDepth << "}";
+        }
+        out << (s.clients.empty() ? "]\n" : "\n    ]\n");
+        out << "  }";
+    }
+    out << (snapshots.empty() ? "}\n" : "\n}\n");
+    return out.str();
+}
+
+// ------------------------
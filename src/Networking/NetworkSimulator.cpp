@@ -0,0 +1,216 @@
+#include "Networking/NetworkSimulator.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace udp;
+
+bool NetworkConditions::isPerfect() const
+{
+    return latency <= 0.f && jitter <= 0.f && loss <= 0.f && duplication <= 0.f && reordering <= 0.f && bandwidth == 0;
+}
+
+//* initializer and deconstructor
+
+NetworkSimulator::NetworkSimulator(const DeliverFunction& deliver, std::uint64_t seed) : m_deliver(deliver), m_random(seed) {}
+
+NetworkSimulator::~NetworkSimulator()
+{
+    stop(false);
+}
+
+// ------------------------------
+
+//* Protected Functions
+
+void NetworkSimulator::m_thread_function(std::stop_token sToken)
+{
+    std::unique_lock lock(m_mutex);
+    while (!sToken.stop_requested())
+    {
+        if (m_pending.empty())
+        {
+            m_condition.wait(lock, sToken, [this](){ return !m_pending.empty(); });
+            continue;
+        }
+
+        Clock::time_point time = m_pending.top().time;
+        if (Clock::now() < time)
+        {
+            // waking early if a packet is scheduled before the one we are waiting on
+            m_condition.wait_until(lock, sToken, time, [this, time](){ return !m_pending.empty() && m_pending.top().time < time; });
+            continue;
+        }
+
+        Pending pending = std::move(const_cast<Pending&>(m_pending.top()));
+        m_pending.pop();
+
+        // delivering outside of the lock so that packets can be pushed while this is sending or parsing
+        lock.unlock();
+        m_deliver(pending.packet, pending.ip, pending.port);
+        m_delivered.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+}
+
+void NetworkSimulator::m_schedule(const sf::Packet& packet, sf::IpAddress ip, unsigned short port, Clock::time_point time)
+{
+    m_pending.push(Pending{time, m_nextSequence++, packet, ip, port});
+}
+
+NetworkSimulator::Clock::duration NetworkSimulator::m_seconds(float seconds) const
+{
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(std::max(seconds, 0.f)));
+}
+
+// ------------------------
+
+//* Public Functions
+
+void NetworkSimulator::push(sf::Packet& packet, sf::IpAddress ip, unsigned short port)
+{
+    m_packets.fetch_add(1, std::memory_order_relaxed);
+
+    if (!m_enabled.load(std::memory_order_relaxed))
+    {
+        m_deliver(packet, ip, port);
+        m_delivered.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        Clock::time_point now = Clock::now();
+
+        if (m_conditions.loss > 0.f && m_chance(m_random) < m_conditions.loss)
+        {
+            m_lost.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // the packet can not start sending until the link is done with the packets before it
+        Clock::time_point sent = now;
+        if (m_conditions.bandwidth != 0)
+        {
+            Clock::time_point start = std::max(now, m_linkFreeTime);
+            if (start - now > m_seconds(m_conditions.maxQueueDelay))
+            {
+                m_queueDropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            m_linkFreeTime = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>((double)packet.getDataSize() / (double)m_conditions.bandwidth));
+            sent = m_linkFreeTime;
+        }
+
+        int copies = 1;
+        if (m_conditions.duplication > 0.f && m_chance(m_random) < m_conditions.duplication)
+        {
+            m_duplicated.fetch_add(1, std::memory_order_relaxed);
+            copies = 2;
+        }
+
+        for (int i = 0; i < copies; i++)
+        {
+            float delay = m_conditions.latency;
+            if (m_conditions.jitter > 0.f)
+                delay += m_conditions.jitter * (m_chance(m_random) * 2.f - 1.f);
+            if (m_conditions.reordering > 0.f && m_chance(m_random) < m_conditions.reordering)
+            {
+                m_reordered.fetch_add(1, std::memory_order_relaxed);
+                delay += m_conditions.reorderDelay;
+            }
+            m_schedule(packet, ip, port, sent + m_seconds(delay));
+        }
+
+        if (m_thread == nullptr)
+            m_thread = new std::jthread([this](std::stop_token sToken){ m_thread_function(sToken); });
+    }
+    m_condition.notify_one();
+}
+
+void NetworkSimulator::stop(bool deliverPending)
+{
+    std::jthread* thread;
+    std::vector<Pending> pending;
+    {
+        std::lock_guard lock(m_mutex);
+        thread = m_thread;
+        m_thread = nullptr;
+        while (!m_pending.empty())
+        {
+            if (deliverPending)
+                pending.push_back(std::move(const_cast<Pending&>(m_pending.top())));
+            m_pending.pop();
+        }
+        m_linkFreeTime = Clock::time_point();
+    }
+
+    if (thread != nullptr)
+    {
+        thread->request_stop();
+        if (thread->get_id() == std::this_thread::get_id())
+            thread->detach();
+        else
+            thread->join();
+        delete(thread);
+    }
+
+    for (auto& packet: pending)
+    {
+        m_deliver(packet.packet, packet.ip, packet.port);
+        m_delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void NetworkSimulator::setConditions(const NetworkConditions& conditions)
+{
+    std::lock_guard lock(m_mutex);
+    m_conditions = conditions;
+    m_enabled = !conditions.isPerfect();
+}
+
+NetworkConditions NetworkSimulator::getConditions() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_conditions;
+}
+
+bool NetworkSimulator::isEnabled() const
+{
+    return m_enabled;
+}
+
+void NetworkSimulator::setSeed(std::uint64_t seed)
+{
+    std::lock_guard lock(m_mutex);
+    m_random.seed(seed);
+    m_chance.reset();
+}
+
+std::size_t NetworkSimulator::getPendingCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_pending.size();
+}
+
+NetworkSimulatorStats NetworkSimulator::getStats() const
+{
+    NetworkSimulatorStats stats;
+    stats.packets = m_packets;
+    stats.delivered = m_delivered;
+    stats.lost = m_lost;
+    stats.queueDropped = m_queueDropped;
+    stats.duplicated = m_duplicated;
+    stats.reordered = m_reordered;
+    return stats;
+}
+
+void NetworkSimulator::resetStats()
+{
+    m_packets = 0;
+    m_delivered = 0;
+    m_lost = 0;
+    m_queueDropped = 0;
+    m_duplicated = 0;
+    m_reordered = 0;
+}
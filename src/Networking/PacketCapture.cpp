@@ -0,0 +1,398 @@
+#include "Networking/PacketCapture.hpp"
+#include <cstring>
+#include <algorithm>
+
+using namespace udp;
+
+namespace
+{
+
+/// @brief microsecond timestamps
+constexpr std::uint32_t PCAP_MAGIC = 0xA1B2C3D4;
+/// @brief packets start with the IPv4 header (no link layer header)
+constexpr std::uint32_t LINKTYPE_RAW = 101;
+constexpr std::size_t IP_HEADER_SIZE = 20;
+constexpr std::size_t UDP_HEADER_SIZE = 8;
+constexpr std::size_t RECORD_HEADER_SIZE = 16;
+
+/// @brief the buffer each thread swaps into the queue so buffers are reused instead of allocating for every packet
+thread_local std::vector<std::uint8_t> t_captureBuffer;
+
+inline void writeBigEndian16(std::uint8_t* out, std::uint16_t value)
+{
+    out[0] = (std::uint8_t)(value >> 8);
+    out[1] = (std::uint8_t)value;
+}
+
+inline void writeBigEndian32(std::uint8_t* out, std::uint32_t value)
+{
+    out[0] = (std::uint8_t)(value >> 24);
+    out[1] = (std::uint8_t)(value >> 16);
+    out[2] = (std::uint8_t)(value >> 8);
+    out[3] = (std::uint8_t)value;
+}
+
+/// @brief pcap headers are written in the byte order of the machine (readers use the magic number to tell)
+template <typename T>
+inline void writeNative(std::uint8_t* out, T value)
+{
+    std::memcpy(out, &value, sizeof(T));
+}
+
+std::uint16_t ipChecksum(const std::uint8_t* header)
+{
+    std::uint32_t sum = 0;
+    for (std::size_t i = 0; i < IP_HEADER_SIZE; i += 2)
+        sum += ((std::uint32_t)header[i] << 8) | header[i + 1];
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return (std::uint16_t)~sum;
+}
+
+std::int64_t getWallClockNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::int64_t getSteadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// @brief writes the value 7 bits at a time (high bit set on every byte except the last)
+inline void writeVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((std::uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((std::uint8_t)value);
+}
+
+template <typename T>
+inline void appendLittleEndian(std::vector<std::uint8_t>& out, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); i++)
+        out.push_back((std::uint8_t)((std::uint64_t)value >> (i * 8)));
+}
+
+}
+
+//* initializer and deconstructor
+
+PacketCapture::PacketCapture(const CaptureOptions& options) : m_options(options), m_queue(options.queueCapacity) {}
+
+PacketCapture::~PacketCapture()
+{
+    stop();
+}
+
+// ------------------------------
+
+//* Protected Functions
+
+void PacketCapture::m_thread_function(std::stop_token sToken)
+{
+    Record record;
+    while (true)
+    {
+        bool wrote = false;
+        while (m_queue.pop(record))
+        {
+            m_write_record(record);
+            wrote = true;
+        }
+        // the queue is only empty for sure once a stop was requested before it was drained
+        if (sToken.stop_requested())
+        {
+            while (m_queue.pop(record))
+                m_write_record(record);
+            break;
+        }
+        if (wrote && m_file != nullptr)
+            std::fflush(m_file);
+
+        // capturing does not wake this thread so that the hot path never touches the lock
+        std::unique_lock lock(m_mutex);
+        m_condition.wait_for(lock, sToken, std::chrono::milliseconds(10), [](){ return false; });
+    }
+    m_close_file();
+}
+
+bool PacketCapture::m_open_file()
+{
+    m_close_file();
+
+    std::string path = m_file_path(m_fileIndex);
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        m_writeErrors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_fileIndex++;
+
+    m_writeBuffer.clear();
+    if (m_options.format == CaptureFormat::Replay)
+    {
+        // the wall clock is only used to say when the file was started, every record is timed with the steady clock
+        m_lastRecordTime = getSteadyNanoseconds();
+        appendLittleEndian<std::uint32_t>(m_writeBuffer, ReplayLogFormat::MAGIC);
+        appendLittleEndian<std::uint32_t>(m_writeBuffer, ReplayLogFormat::VERSION);
+        appendLittleEndian<std::uint64_t>(m_writeBuffer, (std::uint64_t)getWallClockNanoseconds());
+    }
+    else
+    {
+        m_writeBuffer.resize(24);
+        std::uint8_t* header = m_writeBuffer.data();
+        writeNative<std::uint32_t>(header, PCAP_MAGIC);
+        writeNative<std::uint16_t>(header + 4, 2);
+        writeNative<std::uint16_t>(header + 6, 4);
+        writeNative<std::int32_t>(header + 8, 0);
+        writeNative<std::uint32_t>(header + 12, 0);
+        writeNative<std::uint32_t>(header + 16, m_options.snapLength + (std::uint32_t)(IP_HEADER_SIZE + UDP_HEADER_SIZE));
+        writeNative<std::uint32_t>(header + 20, LINKTYPE_RAW);
+    }
+    if (std::fwrite(m_writeBuffer.data(), m_writeBuffer.size(), 1, file) != 1)
+        m_writeErrors.fetch_add(1, std::memory_order_relaxed);
+
+    m_file = file;
+    m_fileSize = m_writeBuffer.size();
+    m_fileOpenTime = std::chrono::steady_clock::now();
+    m_bytesWritten.fetch_add(m_writeBuffer.size(), std::memory_order_relaxed);
+    m_files.fetch_add(1, std::memory_order_relaxed);
+
+    m_filePaths.push_back(path);
+    if (m_options.maxFiles != 0)
+    {
+        while (m_filePaths.size() > m_options.maxFiles)
+        {
+            std::remove(m_filePaths.front().c_str());
+            m_filePaths.erase(m_filePaths.begin());
+        }
+    }
+    return true;
+}
+
+void PacketCapture::m_close_file()
+{
+    if (m_file == nullptr)
+        return;
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void PacketCapture::m_write_record(const Record& record)
+{
+    // the pcap size is used for both formats when deciding to rotate (a replay record is always smaller)
+    std::size_t recordSize = RECORD_HEADER_SIZE + IP_HEADER_SIZE + UDP_HEADER_SIZE + record.data.size();
+    std::size_t headerSize = m_options.format == CaptureFormat::Replay ? ReplayLogFormat::HEADER_SIZE : 24;
+
+    bool rotate = m_file == nullptr;
+    if (m_options.maxFileSize != 0 && m_fileSize + recordSize > m_options.maxFileSize && m_fileSize > headerSize)
+        rotate = true;
+    if (m_options.maxFileTime > 0.f && std::chrono::steady_clock::now() - m_fileOpenTime >= std::chrono::duration<float>(m_options.maxFileTime))
+        rotate = true;
+    if (rotate && !m_open_file())
+        return;
+
+    if (m_options.format == CaptureFormat::Replay)
+        m_encode_replay(record);
+    else
+        m_encode_pcap(record);
+
+    if (std::fwrite(m_writeBuffer.data(), m_writeBuffer.size(), 1, m_file) != 1)
+    {
+        m_writeErrors.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_fileSize += m_writeBuffer.size();
+    m_bytesWritten.fetch_add(m_writeBuffer.size(), std::memory_order_relaxed);
+    m_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PacketCapture::m_encode_pcap(const Record& record)
+{
+    std::size_t dataSize = record.data.size();
+    std::size_t packetSize = IP_HEADER_SIZE + UDP_HEADER_SIZE + dataSize;
+    m_writeBuffer.resize(RECORD_HEADER_SIZE + packetSize);
+    std::uint8_t* out = m_writeBuffer.data();
+
+    std::uint32_t originalPacketSize = (std::uint32_t)(IP_HEADER_SIZE + UDP_HEADER_SIZE) + record.originalSize;
+    writeNative<std::uint32_t>(out, (std::uint32_t)(record.time / 1000000000));
+    writeNative<std::uint32_t>(out + 4, (std::uint32_t)(record.time % 1000000000 / 1000));
+    writeNative<std::uint32_t>(out + 8, (std::uint32_t)packetSize);
+    writeNative<std::uint32_t>(out + 12, originalPacketSize);
+    out += RECORD_HEADER_SIZE;
+
+    // IPv4 header
+    out[0] = 0x45; // version 4, 5 words long
+    out[1] = 0;
+    writeBigEndian16(out + 2, (std::uint16_t)std::min<std::uint32_t>(originalPacketSize, 0xFFFF));
+    writeBigEndian16(out + 4, m_nextIPID++);
+    writeBigEndian16(out + 6, 0x4000); // don't fragment
+    out[8] = 64; // ttl
+    out[9] = 17; // udp
+    writeBigEndian16(out + 10, 0);
+    writeBigEndian32(out + 12, record.sourceIP);
+    writeBigEndian32(out + 16, record.destinationIP);
+    writeBigEndian16(out + 10, ipChecksum(out));
+    out += IP_HEADER_SIZE;
+
+    // UDP header (a checksum of 0 means there is no checksum)
+    writeBigEndian16(out, record.sourcePort);
+    writeBigEndian16(out + 2, record.destinationPort);
+    writeBigEndian16(out + 4, (std::uint16_t)std::min<std::uint32_t>((std::uint32_t)UDP_HEADER_SIZE + record.originalSize, 0xFFFF));
+    writeBigEndian16(out + 6, 0);
+    out += UDP_HEADER_SIZE;
+
+    if (dataSize != 0)
+        std::memcpy(out, record.data.data(), dataSize);
+}
+
+void PacketCapture::m_encode_replay(const Record& record)
+{
+    m_writeBuffer.clear();
+    // records can be queued slightly out of order by different threads so the delta is never negative
+    writeVarint(m_writeBuffer, (std::uint64_t)std::max<std::int64_t>(record.time - m_lastRecordTime, 0));
+    m_lastRecordTime = std::max(record.time, m_lastRecordTime);
+    appendLittleEndian<std::uint32_t>(m_writeBuffer, record.sourceIP);
+    appendLittleEndian<std::uint16_t>(m_writeBuffer, record.sourcePort);
+    writeVarint(m_writeBuffer, record.data.size());
+    m_writeBuffer.insert(m_writeBuffer.end(), record.data.begin(), record.data.end());
+}
+
+std::string PacketCapture::m_file_path(std::uint64_t index) const
+{
+    if (m_options.maxFileSize == 0 && m_options.maxFileTime <= 0.f)
+        return m_options.path;
+
+    std::size_t slash = m_options.path.find_last_of("/\\");
+    std::size_t dot = m_options.path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return m_options.path + "." + std::to_string(index);
+    return m_options.path.substr(0, dot) + "." + std::to_string(index) + m_options.path.substr(dot);
+}
+
+void PacketCapture::m_capture(const void* data, std::size_t size, bool outgoing, sf::IpAddress peerIP, unsigned short peerPort, unsigned short localPort)
+{
+    if (outgoing && m_options.format == CaptureFormat::Replay)
+        return;
+    if (m_options.sampleRate > 1 && m_sampleCounter.fetch_add(1, std::memory_order_relaxed) % m_options.sampleRate != 0)
+    {
+        m_sampledOut.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record record;
+    record.time = m_options.format == CaptureFormat::Replay ? getSteadyNanoseconds() : getWallClockNanoseconds();
+    std::uint32_t peer = peerIP.toInteger();
+    // loopback peers are answered from loopback so the made up local address has to be as well
+    std::uint32_t local = (peer >> 24) == 127 ? sf::IpAddress::LocalHost.toInteger() : m_localIP;
+    record.sourceIP = outgoing ? local : peer;
+    record.destinationIP = outgoing ? peer : local;
+    record.sourcePort = outgoing ? localPort : peerPort;
+    record.destinationPort = outgoing ? peerPort : localPort;
+    record.originalSize = (std::uint32_t)size;
+
+    std::size_t captured = m_options.format == CaptureFormat::Replay ? size : std::min<std::size_t>(size, m_options.snapLength);
+    std::swap(record.data, t_captureBuffer);
+    record.data.resize(captured);
+    if (captured != 0)
+        std::memcpy(record.data.data(), data, captured);
+
+    if (!m_queue.push(record))
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    // whatever buffer came back out of the queue is kept for the next capture on this thread
+    std::swap(record.data, t_captureBuffer);
+}
+
+// ------------------------
+
+//* Public Functions
+
+bool PacketCapture::start()
+{
+    std::lock_guard lock(m_mutex);
+    if (m_thread != nullptr)
+        return true;
+
+    m_queue.reset(m_options.queueCapacity);
+    m_fileIndex = 0;
+    m_filePaths.clear();
+    std::optional<sf::IpAddress> local = sf::IpAddress::getLocalAddress();
+    m_localIP = local.has_value() ? local->toInteger() : sf::IpAddress::LocalHost.toInteger();
+    // opening the first file here so that a bad path is reported right away
+    if (!m_open_file())
+        return false;
+
+    m_running = true;
+    m_thread = new std::jthread([this](std::stop_token sToken){ m_thread_function(sToken); });
+    return true;
+}
+
+void PacketCapture::stop()
+{
+    std::jthread* thread;
+    {
+        std::lock_guard lock(m_mutex);
+        thread = m_thread;
+        m_thread = nullptr;
+        m_running = false;
+    }
+    if (thread == nullptr)
+        return;
+
+    // nothing can be pushed after the final drain (or while start resets the queue) once every capture that saw it running is done
+    while (m_inFlight.load() != 0)
+        std::this_thread::yield();
+
+    thread->request_stop();
+    thread->join();
+    delete(thread);
+}
+
+void PacketCapture::capture(const void* data, std::size_t size, bool outgoing, sf::IpAddress peerIP, unsigned short peerPort, unsigned short localPort)
+{
+    // counted before checking if running so that stop always sees this capture or it sees the capture stopped
+    m_inFlight.fetch_add(1);
+    if (m_running.load())
+        m_capture(data, size, outgoing, peerIP, peerPort, localPort);
+    m_inFlight.fetch_sub(1, std::memory_order_release);
+}
+
+void PacketCapture::setOptions(const CaptureOptions& options)
+{
+    std::lock_guard lock(m_mutex);
+    if (m_thread != nullptr)
+        return;
+    m_options = options;
+}
+
+CaptureOptions PacketCapture::getOptions() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_options;
+}
+
+CaptureStats PacketCapture::getStats() const
+{
+    CaptureStats stats;
+    stats.written = m_written.load(std::memory_order_relaxed);
+    stats.sampledOut = m_sampledOut.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+    stats.files = m_files.load(std::memory_order_relaxed);
+    stats.writeErrors = m_writeErrors.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::string PacketCapture::getCurrentPath() const
+{
+    std::lock_guard lock(m_mutex);
+    std::uint64_t index = m_fileIndex.load();
+    return m_thread == nullptr || index == 0 ? "" : m_file_path(index - 1);
+}
+
+// ------------------------
@@ -0,0 +1,73 @@
+#include "Networking/RttEstimator.hpp"
+#include <cmath>
+#include <algorithm>
+
+using namespace udp;
+
+void RttEstimator::addSample(std::int64_t originTime, std::int64_t receiveTime, std::int64_t transmitTime, std::int64_t arrivalTime)
+{
+    // the time spent on the remote side is not part of the round trip
+    double rtt = std::max((double)((arrivalTime - originTime) - (transmitTime - receiveTime)), 0.0) / 1000000.0;
+    double offset = (double)((receiveTime - originTime) + (transmitTime - arrivalTime)) / 2.0 / 1000000.0;
+
+    // smoothing the same way TCP does (RFC 6298)
+    if (!m_hasSample)
+    {
+        m_rtt = rtt;
+        m_rttVariance = rtt / 2.0;
+    }
+    else
+    {
+        m_rttVariance = 0.75 * m_rttVariance + 0.25 * std::abs(m_rtt - rtt);
+        m_rtt = 0.875 * m_rtt + 0.125 * rtt;
+    }
+    m_lastRTT = rtt;
+
+    // the offset from the sample with the lowest rtt is the least effected by queuing delays
+    m_samples[m_sampleCount % m_samples.size()] = {rtt, offset};
+    m_sampleCount++;
+    std::size_t count = std::min(m_sampleCount, m_samples.size());
+    const Sample* best = &m_samples[0];
+    for (std::size_t i = 1; i < count; i++)
+    {
+        if (m_samples[i].rtt < best->rtt)
+            best = &m_samples[i];
+    }
+    m_clockOffset = best->offset;
+    m_hasSample = true;
+}
+
+void RttEstimator::reset()
+{
+    m_sampleCount = 0;
+    m_hasSample = false;
+    m_rtt = 0.0;
+    m_rttVariance = 0.0;
+    m_lastRTT = 0.0;
+    m_clockOffset = 0.0;
+}
+
+bool RttEstimator::hasSample() const
+{
+    return m_hasSample;
+}
+
+double RttEstimator::getRTT() const
+{
+    return m_rtt;
+}
+
+double RttEstimator::getRTTVariance() const
+{
+    return m_rttVariance;
+}
+
+double RttEstimator::getLastRTT() const
+{
+    return m_lastRTT;
+}
+
+double RttEstimator::getClockOffset() const
+{
+    return m_clockOffset;
+}
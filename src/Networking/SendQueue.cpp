@@ -0,0 +1,190 @@
+#include "Networking/SendQueue.hpp"
+
+using namespace udp;
+
+namespace
+{
+
+inline std::uint64_t getDestinationKey(sf::IpAddress ip, unsigned short port)
+{
+    return ((std::uint64_t)ip.toInteger() << 16) | port;
+}
+
+}
+
+SendQueue::SendQueue(std::size_t capacity, SendQueuePolicy policy) : m_capacity(capacity == 0 ? 1 : capacity), m_policy(policy) {}
+
+void SendQueue::setCapacity(std::size_t capacity)
+{
+    std::lock_guard lock(m_mutex);
+    m_capacity = capacity == 0 ? 1 : capacity;
+}
+
+std::size_t SendQueue::getCapacity() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_capacity;
+}
+
+void SendQueue::setPolicy(SendQueuePolicy policy)
+{
+    std::lock_guard lock(m_mutex);
+    m_policy = policy;
+}
+
+SendQueuePolicy SendQueue::getPolicy() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_policy;
+}
+
+SendResult SendQueue::push(const sf::Packet& packet, sf::IpAddress ip, unsigned short port, bool& dropped)
+{
+    std::lock_guard lock(m_mutex);
+    return m_push(packet, getDestinationKey(ip, port), dropped);
+}
+
+SendResult SendQueue::send(Transport& transport, sf::Packet& packet, sf::IpAddress ip, unsigned short port, bool& dropped)
+{
+    dropped = false;
+    std::uint64_t key = getDestinationKey(ip, port);
+    // when nothing is queued nothing can be waiting for this destination so the lock is only needed if the transport would block
+    std::unique_lock lock(m_mutex, std::defer_lock);
+    if (!empty())
+    {
+        lock.lock();
+        if (m_queues.contains(key))
+            return m_push(packet, key, dropped);
+    }
+
+    sf::Socket::Status status = transport.send(packet, ip, port);
+    if (status == sf::Socket::Status::Done)
+        return SendResult::Sent;
+    if (status != sf::Socket::Status::NotReady && status != sf::Socket::Status::Partial)
+        return SendResult::Failed;
+
+    if (!lock.owns_lock())
+        lock.lock();
+    return m_push(packet, key, dropped);
+}
+
+SendResult SendQueue::sendBatch(Transport& transport, std::span<sf::Packet> packets, sf::IpAddress ip, unsigned short port, std::size_t& sent, std::size_t& dropped)
+{
+    sent = 0;
+    dropped = 0;
+    std::uint64_t key = getDestinationKey(ip, port);
+    // same as send, the lock is only needed once something is queued
+    std::unique_lock lock(m_mutex, std::defer_lock);
+    if (!empty())
+    {
+        lock.lock();
+        if (m_queues.contains(key))
+            return m_push_all(packets, key, dropped);
+    }
+
+    sf::Socket::Status status = transport.sendBatch(packets, ip, port, sent);
+    if (status == sf::Socket::Status::Done)
+        return SendResult::Sent;
+    if (status != sf::Socket::Status::NotReady && status != sf::Socket::Status::Partial)
+        return SendResult::Failed;
+
+    if (!lock.owns_lock())
+        lock.lock();
+    return m_push_all(packets.subspan(sent), key, dropped);
+}
+
+SendResult SendQueue::m_push_all(std::span<sf::Packet> packets, std::uint64_t key, std::size_t& dropped)
+{
+    SendResult result = SendResult::Queued;
+    for (std::size_t i = 0; i < packets.size(); i++)
+    {
+        bool packetDropped;
+        SendResult packetResult = m_push(packets[i], key, packetDropped);
+        dropped += packetDropped ? 1 : 0;
+        if (i == 0)
+            result = packetResult;
+    }
+    return result;
+}
+
+SendResult SendQueue::m_push(const sf::Packet& packet, std::uint64_t key, bool& dropped)
+{
+    std::deque<sf::Packet>& queue = m_queues[key];
+    dropped = queue.size() >= m_capacity;
+    if (dropped)
+    {
+        if (m_policy == SendQueuePolicy::DropNewest)
+            return SendResult::Dropped;
+        queue.pop_front();
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+    }
+    queue.push_back(packet);
+    m_size.fetch_add(1, std::memory_order_relaxed);
+    return SendResult::Queued;
+}
+
+SendQueueFlush SendQueue::flush(Transport& transport)
+{
+    SendQueueFlush flush;
+    std::lock_guard lock(m_mutex);
+    if (m_queues.empty() || !transport.isWritable())
+    {
+        flush.wouldBlock = !m_queues.empty();
+        return flush;
+    }
+
+    while (!m_queues.empty())
+    {
+        for (auto iter = m_queues.begin(); iter != m_queues.end();)
+        {
+            std::uint64_t key = iter->first;
+            std::deque<sf::Packet>& queue = iter->second;
+            sf::Socket::Status status = transport.send(queue.front(), sf::IpAddress((std::uint32_t)(key >> 16)), (unsigned short)key);
+            if (status == sf::Socket::Status::NotReady || status == sf::Socket::Status::Partial)
+            {
+                flush.wouldBlock = true;
+                return flush;
+            }
+
+            if (status == sf::Socket::Status::Done)
+            {
+                flush.packets++;
+                flush.bytes += queue.front().getDataSize();
+            }
+            else
+                flush.failures++;
+            queue.pop_front();
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+
+            if (queue.empty())
+                iter = m_queues.erase(iter);
+            else
+                ++iter;
+        }
+    }
+    return flush;
+}
+
+void SendQueue::clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_queues.clear();
+    m_size.store(0, std::memory_order_relaxed);
+}
+
+bool SendQueue::empty() const
+{
+    return m_size.load(std::memory_order_relaxed) == 0;
+}
+
+std::size_t SendQueue::size() const
+{
+    return m_size.load(std::memory_order_relaxed);
+}
+
+std::size_t SendQueue::size(sf::IpAddress ip, unsigned short port) const
+{
+    std::lock_guard lock(m_mutex);
+    auto iter = m_queues.find(getDestinationKey(ip, port));
+    return iter == m_queues.end() ? 0 : iter->second.size();
+}
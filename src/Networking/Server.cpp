@@ -1,5 +1,6 @@
 #include "Networking/Server.hpp"
 #include <algorithm>
+#include <vector>
 
 using namespace udp;
 
@@ -13,6 +14,9 @@ Server::Server(unsigned short port, bool passwordRequired)
 Server::~Server()
 {
     closeConnection();
+    // the threads are still running if the connection never opened (i.e. a connect that timed out)
+    stopThreads();
+    m_wait_for_threads();
 }
 
 // ------------------------------
@@ -22,42 +26,186 @@ Server::~Server()
 void Server::m_reset_connection_data()
 {
     Socket::m_reset_connection_data(); // reseting the default data
-    m_clientData.clear(); // reseting server specific data
+    // reseting server specific data
+    std::unique_lock lock(m_clientMutex);
+    m_clients.clear();
+    std::lock_guard metricsLock(m_clientMetricsMutex);
+    m_clientMetrics.clear();
 }
 
 // ---------------------
 
 //* Server Functions
 
-ClientData* Server::m_getClientData(ID clientID)
+ClientData* Server::m_getClientData(ID clientID) const
 {
-    ClientData temp = ClientData{0, clientID}; // port does not matter only id
-    auto iter = m_clientData.find(&temp);
-    if (iter == m_clientData.end())
-        return nullptr;
-    return *iter;
+    return m_clients.get(clientID);
 }
 
-void Server::m_update_function(float deltaTime) 
+ClientData* Server::m_get_sender(sf::IpAddress ip, PORT port, std::shared_lock<std::shared_mutex>& lock)
 {
-    for (auto& clientData: m_clientData)
+    ClientData* client = m_getClientData(m_get_connection_id());
+    if (client == nullptr)
+    {
+        // the sender has not been given an ID yet (or the packet is from before it was given one)
+        return m_clients.find(ip, port);
+    }
+    if (client->m_ip == ip.toInteger() && client->m_port == port)
+        return client;
+
+    // anyone can put a known ID in a packet so nothing from the new address is taken until it answers a challenge
+    m_challenge_path(client->id, ip, port, lock);
+    return nullptr;
+}
+
+void Server::m_challenge_path(ID id, sf::IpAddress ip, PORT port, std::shared_lock<std::shared_mutex>& lock)
+{
+    auto now = std::chrono::steady_clock::now();
+    ClientData* client = m_getClientData(id);
+    // the client keeps sending from the new address so the challenge is only sent again if it could have been lost
+    if (client->m_challengeNonce != 0 && client->m_challengeIP == ip.toInteger() && client->m_challengePort == port && 
+        now - client->m_challengeTime < PATH_CHALLENGE_INTERVAL)
+        return;
+
+    std::uint64_t nonce = 0;
+    lock.unlock();
     {
-        clientData->m_timeSinceLastPacket += deltaTime;
-        if (clientData->m_timeSinceLastPacket >= m_timeoutTime)
+        std::unique_lock uniqueLock(m_clientMutex);
+        client = m_getClientData(id);
+        if (client != nullptr && (client->m_challengeNonce == 0 || client->m_challengeIP != ip.toInteger() || client->m_challengePort != port ||
+                                  now - client->m_challengeTime >= PATH_CHALLENGE_INTERVAL))
         {
-            this->disconnectClient(clientData->id, "Timedout");
+            // a new address replaces any challenge that was waiting so only the latest address the client was seen at can be taken
+            nonce = ClientPool::makeToken();
+            client->m_challengeNonce = nonce;
+            client->m_challengeIP = ip.toInteger();
+            client->m_challengePort = port;
+            client->m_challengeTime = now;
         }
-        clientData->m_connectionTime += deltaTime;
     }
+    if (nonce != 0)
+    {
+        sf::Packet challenge = this->PathChallengePacket(nonce);
+        m_send(challenge, ip, port);
+    }
+    lock.lock();
+}
+
+ID Server::m_add_client(sf::IpAddress ip, PORT port, bool& added, std::uint64_t& token)
+{
+    added = false;
+    std::unique_lock lock(m_clientMutex);
+    ClientData* client = m_clients.find(ip, port);
+    if (client != nullptr)
+    {
+        token = client->m_token;
+        return client->id;
+    }
+
+    client = m_clients.add(ip, port);
+    if (client == nullptr)
+        return 0;
+    SocketMetrics::increment(m_metrics.connectionsOpened);
+    added = true;
+    token = client->m_token;
+    return client->id;
+}
+
+void Server::m_confirm_client(sf::IpAddress ip, PORT port)
+{
+    bool added;
+    std::uint64_t token = 0;
+    ID id = m_add_client(ip, port, added, token);
+    if (id == 0)
+    {
+        sf::Packet full = this->ConnectionCloseTemplate("Server Full");
+        m_send(full, ip, port);
+        return;
+    }
+
+    // the confirmation is sent even if the client was already added as the last one may have been lost
+    sf::Packet confirmation = this->ConnectionConfirmPacket(id, ip, token);
+    m_send(confirmation, ip, port);
+    if (added)
+        this->onClientConnected.invoke(id, m_threadSafeEvents, m_overrideEvents);
+}
+
+void Server::m_update_function(float deltaTime) 
+{
+    // clients can not be removed while iterating so they are disconnected after
+    m_timedOut.clear();
+    m_pingsDue.clear();
+
+    std::shared_lock lock(m_clientMutex);
+    // the timers are swept over the arrays in the pool and only the clients that need something are visited after
+    m_clients.addTime(deltaTime);
+    m_clients.getTimedOut(m_timeoutTime, m_timedOut);
+    if (m_pingInterval > 0.f)
+        m_clients.getPingsDue(m_pingInterval, m_pingsDue);
+
+    for (auto* clientData: m_pingsDue)
+    {
+        // it is about to be disconnected
+        if (clientData->getTimeSinceLastPacket() >= m_timeoutTime)
+            continue;
+        sf::Packet ping = this->PingPacket(getClockTime());
+        SocketMetrics::increment(clientData->m_stats->metrics.pingsOut);
+        SocketMetrics::increment(m_metrics.pingsOut);
+        if (isAccepted(m_send(ping, sf::IpAddress(clientData->m_ip), clientData->m_port)))
+            clientData->m_stats->metrics.addOut(ping.getDataSize());
+    }
+    lock.unlock();
+
+    m_metrics.timeouts.fetch_add(m_timedOut.size(), std::memory_order_relaxed);
+    for (ID id: m_timedOut)
+        this->disconnectClient(id, "Timedout");
 }
 
 void Server::m_second_update_function() 
 {
-    for (auto& clientData: m_clientData)
+    double rttTotal = 0.0;
+    std::size_t rttCount = 0;
+
+    // the rows published last time are rebuilt in place so this does not allocate once the client count is steady
+    std::vector<ClientMetricsSnapshot>& rows = m_clientMetricsBack;
+    rows.clear();
+
+    std::shared_lock lock(m_clientMutex);
+    m_clients.updatePacketsPerSecond();
+    m_clients.recordTraffic();
+    rows.reserve(m_clients.size());
+    for (auto* clientData: m_clients)
+    {
+        const ClientMetrics& metrics = clientData->m_stats->metrics;
+        double rtt = clientData->m_stats->rtt.getRTT();
+        ClientMetricsSnapshot& row = rows.emplace_back();
+        row.id = clientData->id;
+        row.ip = clientData->m_ip;
+        row.port = clientData->m_port;
+        row.packetsIn = metrics.packetsIn.load(std::memory_order_relaxed);
+        row.bytesIn = metrics.bytesIn.load(std::memory_order_relaxed);
+        row.packetsOut = metrics.packetsOut.load(std::memory_order_relaxed);
+        row.bytesOut = metrics.bytesOut.load(std::memory_order_relaxed);
+        row.packetsPerSecond = clientData->getPacketsPerSecond();
+        row.rtt = rtt;
+        row.connectionTime = clientData->getConnectionTime();
+        row.timeSinceLastPacket = clientData->getTimeSinceLastPacket();
+        row.sendQueueDepth = m_sendQueue.empty() ? 0 : m_sendQueue.size(sf::IpAddress(clientData->m_ip), clientData->m_port);
+        if (clientData->m_stats->rtt.hasSample())
+        {
+            rttTotal += rtt;
+            rttCount++;
+        }
+    }
+    // published under the client lock so a disconnect clearing the rows can not be overwritten by rows that still have its clients
     {
-        clientData->m_packetsPerSecond = clientData->m_packetsSent;
-        clientData->m_packetsSent = 0;
+        std::lock_guard metricsLock(m_clientMetricsMutex);
+        m_clientMetrics.swap(rows);
     }
+    lock.unlock();
+
+    // the server history uses the average rtt of every client
+    m_record_traffic_history(rttCount == 0 ? 0.f : (float)(rttTotal / (double)rttCount));
 }
 
 // -----------------
@@ -66,29 +214,36 @@ void Server::m_second_update_function()
 
 void Server::m_parse_data(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
 {
-    ID id = senderIP.toInteger();
+    ID id = 0;
+    bool isClient = false;
+    {
+        std::shared_lock lock(m_clientMutex);
+        ClientData* client = m_get_sender(senderIP, senderPort, lock);
+        if (client != nullptr)
+        {
+            id = client->id;
+            m_clients.onReceive(client);
+            client->m_stats->metrics.addIn(packet.getDataSize());
+            isClient = true;
+        }
+    }
 
-    ClientData* client = m_getClientData(id);
     // checking if the sender is a current client
-    if (client != nullptr) 
+    if (isClient) 
     {
-        client->m_timeSinceLastPacket = 0.0;
-        client->m_packetsSent++;
-        this->onDataReceived.invoke(packet, id, m_threadSafeEvents, m_overrideEvents);
+        m_dispatch_data(packet, id);
     }
     // if the sender is not a current client add them if possible
     else
     {   
         if (m_allowClientConnection) // no connection should happen
+        {
+            m_metrics.addDrop(DropReason::NotConnected);
             return;
+        }
         if (!m_needsPassword) // send password request if needed
         {
-            m_clientData.insert(new ClientData{senderPort, id});
-
-            sf::Packet Confirmation = this->ConnectionConfirmPacket(id);
-            m_send(Confirmation, senderIP, senderPort);
-
-            this->onClientConnected.invoke(id, m_threadSafeEvents, m_overrideEvents);
+            m_confirm_client(senderIP, senderPort);
         }
         else
         {
@@ -101,71 +256,190 @@ void Server::m_parse_data(sf::Packet& packet, sf::IpAddress senderIP, PORT sende
 void Server::m_parse_connection_request(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
 {
     if (!m_allowClientConnection) return;
-    ID id = senderIP.toInteger();
+    SocketMetrics::increment(m_metrics.connectionRequests);
     if (this->m_needsPassword)
     {
         sf::Packet needPassword = this->PasswordRequestPacket();
         m_send(needPassword, senderIP, senderPort);
         return; // dont want to confirm a connection if need password
     }
-    else
-    {
-        // checking if the client is not already connected
-        if (m_getClientData(id) == nullptr)
-        {
-            m_clientData.insert(new ClientData{senderPort, id});
-        }
-        // we still want to send a confirmation as the confirmation packet may have been lost
-    }
 
-    sf::Packet Confirmation = this->ConnectionConfirmPacket(senderIP.toInteger());
-    m_send(Confirmation, senderIP, senderPort);
-    this->onClientConnected.invoke(id, m_threadSafeEvents, m_overrideEvents);
+    // only added if the client is not already connected
+    m_confirm_client(senderIP, senderPort);
 }
 
 void Server::m_parse_connection_close(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
 {
+    // m_get_sender only finds the client at the address it was confirmed or validated at so a spoofed ID can not close the connection
     std::string reason;
     if (packet.endOfPacket())
         reason = "Unknown";
     else
         packet >> reason;
-    disconnectClient(senderIP.toInteger(), reason);
-    this->onClientDisconnected.invoke((ID)senderIP.toInteger(), reason, m_threadSafeEvents, m_overrideEvents);
+
+    ID id;
+    {
+        std::shared_lock lock(m_clientMutex);
+        ClientData* client = m_get_sender(senderIP, senderPort, lock);
+        if (client == nullptr)
+            return;
+        id = client->id;
+    }
+    // invokes onClientDisconnected
+    disconnectClient(id, reason);
 }
 
 void Server::m_parse_password(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
 {
     std::string sentPassword;
     packet >> sentPassword;
-    ID id = senderIP.toInteger();
 
-    ClientData* client = m_getClientData(id);
-    if (client != nullptr) // if client is already connected
+    bool isClient;
     {
-        // make sure the client knows they are connected by sending another connection confirmation
-        sf::Packet Confirmation = this->ConnectionConfirmPacket(senderIP.toInteger());
-        m_send(Confirmation, senderIP, senderPort);
-        return;
+        std::shared_lock lock(m_clientMutex);
+        isClient = m_get_sender(senderIP, senderPort, lock) != nullptr;
     }
-    
-    if (m_password == sentPassword) // if password is correct
+    // if the client is already connected make sure the client knows they are connected by sending another connection confirmation
+    // otherwise send confirmation if the password is correct
+    if (isClient || m_password == sentPassword)
     {
-        m_clientData.insert(new ClientData{senderPort, id});
-       
-        // send confirmation as password was correct
-        sf::Packet Confirmation = this->ConnectionConfirmPacket(senderIP.toInteger());
-        m_send(Confirmation, senderIP, senderPort);
-        this->onClientConnected.invoke(id, m_threadSafeEvents, m_overrideEvents);
+        m_confirm_client(senderIP, senderPort);
     }
     else
     {
+        SocketMetrics::increment(m_metrics.passwordFailures);
         sf::Packet passwordRequest;
         passwordRequest = this->PasswordRequestPacket();
         m_send(passwordRequest, senderIP, senderPort);
     }
 }
 
+void Server::m_parse_request(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    ID id;
+    {
+        std::shared_lock lock(m_clientMutex);
+        ClientData* client = m_get_sender(senderIP, senderPort, lock);
+        // only answering requests from current clients
+        if (client == nullptr)
+        {
+            m_metrics.addDrop(DropReason::NotConnected);
+            return;
+        }
+
+        id = client->id;
+        m_clients.onReceive(client);
+        client->m_stats->metrics.addIn(packet.getDataSize());
+    }
+    m_handle_request(packet, id, senderIP, senderPort);
+}
+
+void Server::m_parse_response(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    ID id;
+    {
+        std::shared_lock lock(m_clientMutex);
+        ClientData* client = m_get_sender(senderIP, senderPort, lock);
+        if (client == nullptr)
+        {
+            m_metrics.addDrop(DropReason::NotConnected);
+            return;
+        }
+
+        id = client->id;
+        m_clients.onReceive(client);
+        client->m_stats->metrics.addIn(packet.getDataSize());
+    }
+    m_handle_response(packet, id);
+}
+
+void Server::m_parse_ping(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    std::shared_lock lock(m_clientMutex);
+    ClientData* client = m_get_sender(senderIP, senderPort, lock);
+    // only responding to current clients
+    if (client == nullptr)
+    {
+        m_metrics.addDrop(DropReason::NotConnected);
+        return;
+    }
+
+    m_clients.onReceive(client, false);
+    client->m_stats->metrics.addIn(packet.getDataSize());
+    m_send_pong(packet, senderIP, senderPort);
+}
+
+void Server::m_parse_pong(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    std::shared_lock lock(m_clientMutex);
+    ClientData* client = m_get_sender(senderIP, senderPort, lock);
+    if (client == nullptr)
+    {
+        m_metrics.addDrop(DropReason::NotConnected);
+        return;
+    }
+
+    m_clients.onReceive(client, false);
+    client->m_stats->metrics.addIn(packet.getDataSize());
+    if (m_read_pong(packet, client->m_stats->rtt, &client->m_stats->rttHistogram))
+        SocketMetrics::increment(client->m_stats->metrics.pongsIn);
+}
+
+void Server::m_parse_shared_memory_offer(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    {
+        std::shared_lock lock(m_clientMutex);
+        ClientData* client = m_get_sender(senderIP, senderPort, lock);
+        // only current clients can use shared memory
+        if (client == nullptr)
+        {
+            m_metrics.addDrop(DropReason::NotConnected);
+            return;
+        }
+
+        m_clients.onReceive(client, false);
+    }
+    m_handle_shared_memory_offer(packet, senderIP, senderPort);
+}
+
+void Server::m_parse_path_response(sf::Packet& packet, sf::IpAddress senderIP, PORT senderPort)
+{
+    std::uint64_t nonce, token;
+    if (!(packet >> nonce >> token))
+    {
+        SocketMetrics::increment(m_metrics.parseErrors);
+        return;
+    }
+
+    bool moved = false;
+    std::uint32_t oldIP = 0;
+    PORT oldPort = 0;
+    {
+        std::unique_lock lock(m_clientMutex);
+        ClientData* client = m_getClientData(m_get_connection_id());
+        // the nonce shows the client got the challenge at this address and the token that it is the client that was confirmed
+        if (client != nullptr && client->m_challengeNonce != 0 && client->m_challengeNonce == nonce && client->m_token == token &&
+            client->m_challengeIP == senderIP.toInteger() && client->m_challengePort == senderPort)
+        {
+            oldIP = client->m_ip;
+            oldPort = client->m_port;
+            client->m_challengeNonce = 0;
+            m_clients.move(client, senderIP, senderPort);
+            m_clients.onReceive(client, false);
+            client->m_stats->metrics.addIn(packet.getDataSize());
+            SocketMetrics::increment(m_metrics.addressChanges);
+            moved = true;
+        }
+    }
+    if (!moved)
+    {
+        m_metrics.addDrop(DropReason::NotConnected);
+        return;
+    }
+    // any shared memory channel was set up for the old address
+    m_close_shared_memory(sf::IpAddress(oldIP), oldPort);
+}
+
 // --------------------------
 
 //* Connection Functions
@@ -194,69 +468,151 @@ bool Server::isPasswordRequired() const
     return m_needsPassword;
 }
 
-void Server::sendToAll(sf::Packet& packet, std::list<ID> blacklist)
+std::size_t Server::sendToAll(sf::Packet& packet, std::list<ID> blacklist)
 {
-    for (auto& client: m_clientData)
+    std::size_t accepted = 0;
+    std::shared_lock lock(m_clientMutex);
+    for (auto* client: m_clients)
     {
         if (std::find(blacklist.begin(), blacklist.end(), client->id) == blacklist.end()) // if we did not find the client then it is NOT in the black list
-            m_send(packet, sf::IpAddress(client->id), client->port);
+        {
+            if (isAccepted(m_send(packet, sf::IpAddress(client->m_ip), client->m_port)))
+            {
+                client->m_stats->metrics.addOut(packet.getDataSize());
+                accepted++;
+            }
+        }
     }
+    return accepted;
 }
 
-bool Server::sendTo(sf::Packet& packet, ID id)
+SendResult Server::sendTo(sf::Packet& packet, ID id)
 {
     if (id != 0) 
     {
+        // held through the send (like sendToAll) so the client is still there to count the packet once it is accepted
+        std::shared_lock lock(m_clientMutex);
         ClientData* client = m_getClientData(id);
 
         // if the client was not found
-        if (client == nullptr) return false;
+        if (client == nullptr) return SendResult::NotConnected;
 
-        m_send(packet, sf::IpAddress(id), client->port);
-        return true;
+        SendResult result = m_send(packet, sf::IpAddress(client->m_ip), client->m_port);
+        if (isAccepted(result))
+            client->m_stats->metrics.addOut(packet.getDataSize());
+        return result;
     }
-    return false;
+    return SendResult::NotConnected;
 }
 
-bool Server::disconnectClient(ID id, const std::string& reason)
+SendResult Server::sendBatchTo(std::span<sf::Packet> packets, ID id)
 {
-    ClientData temp = ClientData{0, id}; // port does not matter only id
-    auto iter = m_clientData.find(&temp);
-    if (iter != m_clientData.end())
+    if (id == 0) return SendResult::NotConnected;
+
+    // held through the send (like sendTo) so the client is still there to count the packets once they are accepted
+    std::shared_lock lock(m_clientMutex);
+    ClientData* client = m_getClientData(id);
+
+    // if the client was not found
+    if (client == nullptr) return SendResult::NotConnected;
+
+    SendResult result = m_send_batch(packets, sf::IpAddress(client->m_ip), client->m_port);
+    if (isAccepted(result))
     {
-        sf::Packet removePacket = this->ConnectionCloseTemplate(reason);
-        sendTo(removePacket, id);
-        ClientData* clientPtr = *iter;
-        m_clientData.erase(iter);
-        delete(clientPtr); // freeing the memory as we store client data as a pointer
-        this->onClientDisconnected.invoke(id, reason, m_threadSafeEvents, m_overrideEvents);
-        return true;
+        for (const sf::Packet& packet: packets)
+            client->m_stats->metrics.addOut(packet.getDataSize());
     }
-    else return false;
+    return result;
 }
 
-void Server::disconnectAllClients(const std::string& reason)
+bool Server::disconnectClient(ID id, const std::string& reason)
 {
+    std::uint32_t ip;
+    PORT port;
+    {
+        std::unique_lock lock(m_clientMutex);
+        ClientData* client = m_getClientData(id);
+        if (client == nullptr)
+            return false;
+        ip = client->m_ip;
+        port = client->m_port;
+        m_clients.remove(client);
+    }
+    SocketMetrics::increment(m_metrics.disconnects);
+
     sf::Packet removePacket = this->ConnectionCloseTemplate(reason);
+    m_send(removePacket, sf::IpAddress(ip), port);
+    m_close_shared_memory(sf::IpAddress(ip), port);
+    this->onClientDisconnected.invoke(id, reason, m_threadSafeEvents, m_overrideEvents);
+    return true;
+}
 
-    this->sendToAll(removePacket);
+void Server::disconnectAllClients(const std::string& reason)
+{
+    // the addresses are copied so the packets can be sent without holding the lock
+    std::vector<std::pair<std::uint32_t, PORT>> addresses;
+    {
+        std::unique_lock lock(m_clientMutex);
+        addresses.reserve(m_clients.size());
+        for (auto* clientData: m_clients)
+            addresses.emplace_back(clientData->m_ip, clientData->m_port);
+        m_clients.clear();
+        std::lock_guard metricsLock(m_clientMetricsMutex);
+        m_clientMetrics.clear();
+    }
+    m_metrics.disconnects.fetch_add(addresses.size(), std::memory_order_relaxed);
 
-    m_clientData.clear();
+    sf::Packet removePacket = this->ConnectionCloseTemplate(reason);
+    for (auto& [ip, port]: addresses)
+        m_send(removePacket, sf::IpAddress(ip), port);
 }
 
-const std::unordered_set<ClientData*>& Server::getClients() const
-{ return m_clientData;}
+const ClientPool& Server::getClients() const
+{ return m_clients;}
 
 std::uint32_t Server::getClientsSize() const
-{ return (std::uint32_t)m_clientData.size();}
+{
+    std::shared_lock lock(m_clientMutex);
+    return (std::uint32_t)m_clients.size();
+}
 
 const ClientData* Server::getClientData(ID clientID) const
 {
-    ClientData temp = ClientData{0, clientID}; // port does not matter only id
-    auto iter = m_clientData.find(&temp);
-    if (iter == m_clientData.end())
-        return nullptr;
-    return *iter;
+    std::shared_lock lock(m_clientMutex);
+    return m_getClientData(clientID);
+}
+
+bool Server::isClientConnected(ID clientID) const
+{
+    std::shared_lock lock(m_clientMutex);
+    return m_getClientData(clientID) != nullptr;
+}
+
+std::optional<HistogramSnapshot> Server::getClientRTTHistogram(ID clientID) const
+{
+    std::shared_lock lock(m_clientMutex);
+    ClientData* clientData = m_getClientData(clientID);
+    if (clientData == nullptr)
+        return std::nullopt;
+    return clientData->getRTTHistogram();
+}
+
+std::optional<std::vector<TrafficSample>> Server::getClientTrafficHistory(ID clientID) const
+{
+    std::shared_lock lock(m_clientMutex);
+    ClientData* clientData = m_getClientData(clientID);
+    if (clientData == nullptr)
+        return std::nullopt;
+    return clientData->getTrafficHistory();
+}
+
+std::optional<std::size_t> Server::getClientSendQueueSize(ID clientID) const
+{
+    std::shared_lock lock(m_clientMutex);
+    ClientData* clientData = m_getClientData(clientID);
+    if (clientData == nullptr)
+        return std::nullopt;
+    return m_sendQueue.size(sf::IpAddress(clientData->m_ip), clientData->m_port);
 }
 
 void Server::allowClientConnection(bool allowed)
@@ -269,11 +625,37 @@ bool Server::isClientConnectionAllowed()
     return m_allowClientConnection;
 }
 
+Awaitable<std::optional<Message>> Server::request(ID id, const sf::Packet& message, sf::Time timeout)
+{
+    std::uint32_t ip;
+    PORT port;
+    {
+        std::shared_lock lock(m_clientMutex);
+        ClientData* client = m_getClientData(id);
+        if (client == nullptr)
+            return Awaitable<std::optional<Message>>::ready(std::nullopt);
+        ip = client->m_ip;
+        port = client->m_port;
+    }
+
+    return m_send_request(message, id, sf::IpAddress(ip), port, timeout);
+}
+
+MetricsSnapshot Server::getMetrics() const
+{
+    MetricsSnapshot snapshot = Socket::getMetrics();
+
+    // the rows lock is only ever held for a copy or a swap so this never waits on the network threads
+    std::lock_guard lock(m_clientMetricsMutex);
+    snapshot.clients = m_clientMetrics;
+    return snapshot;
+}
+
 //* Pure Virtual Definitions
 
 bool Server::tryOpenConnection()
 {
-    if (this->bind(getPort()) != sf::Socket::Status::Done)
+    if (m_transport->bind(getPort()) != sf::Socket::Status::Done)
         return false;
 
     m_connectionOpen = true;
@@ -290,7 +672,7 @@ void Server::closeConnection(const std::string& reason)
 
     m_reset_connection_data();
     stopThreads();
-    close();
+    m_transport->unbind();
 
     onConnectionClose.invoke(reason, m_threadSafeEvents, m_overrideEvents);
 }
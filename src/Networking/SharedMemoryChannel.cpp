@@ -0,0 +1,356 @@
+#include "Networking/SharedMemoryChannel.hpp"
+#include <cstring>
+#include <string>
+#include <new>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+using namespace udp;
+
+namespace
+{
+
+constexpr std::uint32_t DOORBELL_MAGIC = 0x55445042; // "UDPB"
+constexpr std::uint32_t CHANNEL_MAGIC = 0x55445052; // "UDPR"
+constexpr std::uint32_t CHANNEL_VERSION = 1;
+/// @brief record size that marks the rest of the ring as unused so the writer can wrap around
+constexpr std::uint32_t WRAP_MARKER = 0xFFFFFFFF;
+/// @brief the channel header gets its own page and the rings come after it
+constexpr std::size_t CHANNEL_HEADER_SIZE = 4096;
+
+constexpr std::size_t channelSize()
+{
+    return CHANNEL_HEADER_SIZE + 2 * (std::size_t)SharedMemoryChannel::RING_SIZE;
+}
+
+inline std::uint32_t recordSize(std::uint32_t dataSize)
+{
+    // size prefix + data rounded up to 8 bytes so every record starts aligned
+    return (std::uint32_t)((sizeof(std::uint32_t) + dataSize + 7) & ~(std::size_t)7);
+}
+
+#ifdef __linux__
+
+/// @returns a mapping of the whole file or nullptr on failure
+void* mapFile(int fd, std::size_t size)
+{
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return data == MAP_FAILED ? nullptr : data;
+}
+
+/// @returns a new memfd of the given size or -1 on failure
+int createFile(const char* name, std::size_t size)
+{
+    int fd = memfd_create(name, MFD_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// @brief opens a file descriptor from another process through proc
+/// @returns -1 on failure or if the file is not the expected size
+int openRemoteFile(std::uint32_t pid, std::int32_t fd, std::size_t size)
+{
+    std::string path = "/proc/" + std::to_string(pid) + "/fd/" + std::to_string(fd);
+    int localFD = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (localFD < 0)
+        return -1;
+
+    struct stat info;
+    if (fstat(localFD, &info) != 0 || (std::size_t)info.st_size != size)
+    {
+        ::close(localFD);
+        return -1;
+    }
+    return localFD;
+}
+
+#endif
+
+}
+
+//* Doorbell
+
+struct SharedMemoryDoorbell::Data
+{
+    std::uint32_t magic;
+    alignas(64) std::atomic<std::uint32_t> signal;
+    std::atomic<std::uint32_t> waiting;
+};
+
+SharedMemoryDoorbell::SharedMemoryDoorbell(std::int32_t fd, Data* data) : m_fd(fd), m_data(data) {}
+
+std::unique_ptr<SharedMemoryDoorbell> SharedMemoryDoorbell::create()
+{
+#ifdef __linux__
+    int fd = createFile("udp-doorbell", sizeof(Data));
+    if (fd < 0)
+        return nullptr;
+
+    Data* data = (Data*)mapFile(fd, sizeof(Data));
+    if (data == nullptr)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    new (data) Data{DOORBELL_MAGIC, {0}, {0}};
+    return std::unique_ptr<SharedMemoryDoorbell>(new SharedMemoryDoorbell(fd, data));
+#else
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<SharedMemoryDoorbell> SharedMemoryDoorbell::open(std::uint32_t pid, std::int32_t fd)
+{
+#ifdef __linux__
+    int localFD = openRemoteFile(pid, fd, sizeof(Data));
+    if (localFD < 0)
+        return nullptr;
+
+    Data* data = (Data*)mapFile(localFD, sizeof(Data));
+    // the mapping keeps the memory alive so the file is not needed anymore
+    ::close(localFD);
+    if (data == nullptr)
+        return nullptr;
+    if (data->magic != DOORBELL_MAGIC)
+    {
+        munmap(data, sizeof(Data));
+        return nullptr;
+    }
+    return std::unique_ptr<SharedMemoryDoorbell>(new SharedMemoryDoorbell(-1, data));
+#else
+    return nullptr;
+#endif
+}
+
+SharedMemoryDoorbell::~SharedMemoryDoorbell()
+{
+#ifdef __linux__
+    if (m_data != nullptr)
+        munmap(m_data, sizeof(Data));
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+}
+
+std::int32_t SharedMemoryDoorbell::getFD() const
+{
+    return m_fd;
+}
+
+void SharedMemoryDoorbell::ring()
+{
+    m_data->signal.fetch_add(1);
+#ifdef __linux__
+    if (m_data->waiting.load() != 0)
+        syscall(SYS_futex, (std::uint32_t*)&m_data->signal, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+std::uint32_t SharedMemoryDoorbell::prepareWait()
+{
+    std::uint32_t signal = m_data->signal.load();
+    m_data->waiting.store(1);
+    return signal;
+}
+
+void SharedMemoryDoorbell::wait(std::uint32_t signal, int timeoutMilliseconds)
+{
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMilliseconds / 1000;
+    timeout.tv_nsec = (long)(timeoutMilliseconds % 1000) * 1000000;
+    // returns right away if the doorbell was rung since prepareWait
+    syscall(SYS_futex, (std::uint32_t*)&m_data->signal, FUTEX_WAIT, signal, &timeout, nullptr, 0);
+#endif
+    m_data->waiting.store(0);
+}
+
+void SharedMemoryDoorbell::cancelWait()
+{
+    m_data->waiting.store(0);
+}
+
+// ------------------------------
+
+//* Channel
+
+struct SharedMemoryChannel::Ring
+{
+    /// @brief total bytes written (only changed by the writer)
+    alignas(64) std::atomic<std::uint64_t> head;
+    /// @brief total bytes read (only changed by the reader)
+    alignas(64) std::atomic<std::uint64_t> tail;
+};
+
+struct SharedMemoryChannel::Header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t ringSize;
+    /// @brief [0] is written by the creator, [1] is written by the process that opened the channel
+    Ring rings[2];
+};
+
+SharedMemoryChannel::SharedMemoryChannel(std::int32_t fd, Header* header, bool creator) : m_fd(fd), m_header(header)
+{
+    std::uint8_t* ringData = (std::uint8_t*)header + CHANNEL_HEADER_SIZE;
+    int sendIndex = creator ? 0 : 1;
+    m_sendRing = &header->rings[sendIndex];
+    m_sendData = ringData + sendIndex * RING_SIZE;
+    m_receiveRing = &header->rings[1 - sendIndex];
+    m_receiveData = ringData + (1 - sendIndex) * RING_SIZE;
+}
+
+std::shared_ptr<SharedMemoryChannel> SharedMemoryChannel::create()
+{
+#ifdef __linux__
+    static_assert(sizeof(Header) <= CHANNEL_HEADER_SIZE, "the channel header must fit in the first page");
+
+    int fd = createFile("udp-channel", channelSize());
+    if (fd < 0)
+        return nullptr;
+
+    Header* header = (Header*)mapFile(fd, channelSize());
+    if (header == nullptr)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    new (header) Header{CHANNEL_MAGIC, CHANNEL_VERSION, RING_SIZE, {}};
+    return std::shared_ptr<SharedMemoryChannel>(new SharedMemoryChannel(fd, header, true));
+#else
+    return nullptr;
+#endif
+}
+
+std::shared_ptr<SharedMemoryChannel> SharedMemoryChannel::open(std::uint32_t pid, std::int32_t fd)
+{
+#ifdef __linux__
+    int localFD = openRemoteFile(pid, fd, channelSize());
+    if (localFD < 0)
+        return nullptr;
+
+    Header* header = (Header*)mapFile(localFD, channelSize());
+    ::close(localFD);
+    if (header == nullptr)
+        return nullptr;
+    if (header->magic != CHANNEL_MAGIC || header->version != CHANNEL_VERSION || header->ringSize != RING_SIZE)
+    {
+        munmap(header, channelSize());
+        return nullptr;
+    }
+    return std::shared_ptr<SharedMemoryChannel>(new SharedMemoryChannel(-1, header, false));
+#else
+    return nullptr;
+#endif
+}
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+#ifdef __linux__
+    if (m_header != nullptr)
+        munmap(m_header, channelSize());
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+}
+
+std::int32_t SharedMemoryChannel::getFD() const
+{
+    return m_fd;
+}
+
+void SharedMemoryChannel::setRemoteDoorbell(std::unique_ptr<SharedMemoryDoorbell> doorbell)
+{
+    std::lock_guard lock(m_sendMutex);
+    m_remoteDoorbell = std::move(doorbell);
+}
+
+bool SharedMemoryChannel::send(const sf::Packet& packet)
+{
+    std::uint32_t size = (std::uint32_t)packet.getDataSize();
+    std::uint32_t needed = recordSize(size);
+    // leaving room so one huge packet can not take the whole ring
+    if (packet.getDataSize() > RING_SIZE / 4)
+        return false;
+
+    std::lock_guard lock(m_sendMutex);
+    if (m_remoteDoorbell == nullptr)
+        return false;
+
+    std::uint64_t head = m_sendRing->head.load(std::memory_order_relaxed);
+    std::uint64_t tail = m_sendRing->tail.load(std::memory_order_acquire);
+    std::uint32_t offset = (std::uint32_t)(head % RING_SIZE);
+    std::uint32_t contiguous = RING_SIZE - offset;
+
+    if (contiguous < needed)
+    {
+        // the record does not fit before the end so the rest is skipped and it is written at the start
+        if (head + contiguous + needed - tail > RING_SIZE)
+            return false;
+        std::memcpy(m_sendData + offset, &WRAP_MARKER, sizeof(WRAP_MARKER));
+        head += contiguous;
+        offset = 0;
+    }
+    else if (head + needed - tail > RING_SIZE)
+        return false;
+
+    std::memcpy(m_sendData + offset, &size, sizeof(size));
+    std::memcpy(m_sendData + offset + sizeof(size), packet.getData(), size);
+    m_sendRing->head.store(head + needed, std::memory_order_release);
+
+    m_remoteDoorbell->ring();
+    return true;
+}
+
+bool SharedMemoryChannel::receive(sf::Packet& packet)
+{
+    std::uint64_t tail = m_receiveRing->tail.load(std::memory_order_relaxed);
+    std::uint64_t head = m_receiveRing->head.load(std::memory_order_acquire);
+
+    while (tail != head)
+    {
+        std::uint32_t offset = (std::uint32_t)(tail % RING_SIZE);
+        std::uint32_t size;
+        std::memcpy(&size, m_receiveData + offset, sizeof(size));
+
+        if (size == WRAP_MARKER)
+        {
+            tail += RING_SIZE - offset;
+            continue;
+        }
+        // the other process wrote something invalid so everything that is left is skipped
+        if (size > RING_SIZE / 4 || recordSize(size) > RING_SIZE - offset || head - tail > RING_SIZE)
+        {
+            m_receiveRing->tail.store(head, std::memory_order_release);
+            return false;
+        }
+
+        packet.clear();
+        packet.append(m_receiveData + offset + sizeof(size), size);
+        m_receiveRing->tail.store(tail + recordSize(size), std::memory_order_release);
+        return true;
+    }
+
+    m_receiveRing->tail.store(tail, std::memory_order_release);
+    return false;
+}
+
+bool SharedMemoryChannel::hasData() const
+{
+    return m_receiveRing->tail.load(std::memory_order_relaxed) != m_receiveRing->head.load(std::memory_order_acquire);
+}
@@ -1,199 +1,1327 @@
 #include "Networking/Socket.hpp"
-#include "Utils/UpdateLimiter.hpp"
 #include <stdexcept>
-#include <SFML/System/Clock.hpp>
+#include <algorithm>
 #include <SFML/Network/Dns.hpp>
 
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
 using namespace udp;
 
-//* initializer and deconstructor
+namespace
+{
+
+enum class PublicIPState : std::uint8_t
+{
+    NotStarted = 0,
+    Resolving = 1,
+    Resolved = 2,
+    Failed = 3
+};
+
+/// @brief the public IP lookup that is shared between every socket
+struct PublicIPLookup
+{
+    std::atomic<PublicIPState> state = PublicIPState::NotStarted;
+    std::atomic<std::uint32_t> address = 0;
+};
+
+PublicIPLookup& getPublicIPLookup()
+{
+    // never deleted so the detached lookup thread can still write to it while the process exits
+    static PublicIPLookup* lookup = new PublicIPLookup;
+    return *lookup;
+}
+
+/// @brief set in Socket::m_publicIP when a public IP has been set, the low 32 bits are the ip
+constexpr std::uint64_t PUBLIC_IP_SET = 1ull << 32;
+
+/// @returns the steady clock time in nanoseconds
+inline std::uint64_t getNanoseconds()
+{
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// @brief when the packet that is being handled on this thread was received
+/// @note handling is always done on the thread that calls m_handle_packet so this does not have to be passed through every parse function
+thread_local std::uint64_t t_receiveTime = 0;
+/// @brief when the transport says the packet that is being handled on this thread arrived (0 if not known)
+thread_local std::uint64_t t_arrivalTime = 0;
+/// @brief the connection ID from the header of the packet that is being handled on this thread
+thread_local ID t_connectionID = 0;
+
+/// @returns a packet with only the header for the given type (the connection ID is written when the packet is sent)
+sf::Packet makePacket(PacketType type)
+{
+    sf::Packet out;
+    out << (std::int8_t)type << (std::uint32_t)0;
+    return out;
+}
+
+std::uint32_t getProcessID()
+{
+#ifdef __linux__
+    return (std::uint32_t)getpid();
+#else
+    return 0;
+#endif
+}
+
+}
+
+//* initializer and deconstructor
+
+Socket::Socket()
+{
+    setPort(m_transport->getLocalPort());
+}
+
+Socket::~Socket()
+{   
+    stopThreads();
+    m_wait_for_threads();
+    m_transport->unbind();
+}
+
+// ------------------------------
+
+//* Protected Thread Functions
+
+void Socket::m_receive_packets_thread(std::stop_token sToken)
+{
+    sf::Packet packet;
+    IpAddress_t senderIP(sf::IpAddress::LocalHost);
+    unsigned short senderPort;
+    std::uint64_t overflowCount = m_transport->getReceiveOverflowCount();
+
+    while (!sToken.stop_requested()) {
+        sf::Socket::Status receiveStatus = m_transport->receive(packet, senderIP, senderPort);
+        if (sToken.stop_requested()) return;
+
+        // the packets the transport had to drop before this one
+        std::uint64_t newOverflowCount = m_transport->getReceiveOverflowCount();
+        if (newOverflowCount != overflowCount)
+        {
+            m_metrics.drops[(std::size_t)DropReason::ReceiveOverflow].fetch_add(newOverflowCount >= overflowCount ? newOverflowCount - overflowCount : newOverflowCount, 
+                                                                                 std::memory_order_relaxed);
+            overflowCount = newOverflowCount;
+        }
+
+        switch (receiveStatus)
+        {
+        case sf::Socket::Status::Error:
+            throw std::runtime_error("Error Receiving Packet (Code: " + std::to_string((int)receiveStatus) + ")");
+            break;
+        
+        case sf::Socket::Status::Done:
+            break;
+
+        // interrupted, the transport is writable again, or nothing useful was received
+        default:
+            if (!m_sendQueue.empty())
+                m_flush_send_queue();
+            continue;
+        }
+
+        if (!senderIP.has_value())
+            continue;
+
+        m_metrics.addIn(packet.getDataSize());
+        if (m_capture != nullptr)
+            m_capture->capture(packet.getData(), packet.getDataSize(), false, senderIP.value(), senderPort, m_port);
+        if (m_incomingSimulator.isEnabled())
+            m_incomingSimulator.push(packet, senderIP.value(), senderPort);
+        else
+            m_handle_packet(packet, senderIP.value(), senderPort, m_transport->getReceiveTimestamp());
+
+        packet.clear();
+    }
+}
+
+void Socket::m_wait_for_threads()
+{
+    m_wait_for_thread(m_updateThreadDone, m_updateThreadID);
+    m_wait_for_thread(m_sharedMemoryThreadDone, m_sharedMemoryThreadID);
+    m_wait_for_thread(m_receiveThreadDone, m_receiveThreadID);
+}
+
+void Socket::m_wait_for_thread(const std::shared_ptr<std::atomic<bool>>& done, const std::atomic<std::thread::id>& threadID)
+{
+    // a thread can not wait for its self (i.e. a socket destroyed from one of its own handlers)
+    if (threadID.load() == std::this_thread::get_id())
+        return;
+    done->wait(false);
+}
+
+void Socket::m_update_thread(std::stop_token sToken)
+{
+    {
+        std::lock_guard lock(m_resumeMutex);
+        m_resumeOnUpdateThread = true;
+    }
+    m_tickScheduler.reset();
+
+    float deltaTime;
+    float secondTime = 0.f;
+    
+    while (!sToken.stop_requested())
+    {
+        deltaTime = (float)m_tickScheduler.waitForNextTick(sToken);
+        if (sToken.stop_requested()) break;
+        std::uint64_t tickStart = getNanoseconds();
+        m_resume_scheduled();
+        m_expire_requests();
+        if (!m_sendQueue.empty())
+            m_flush_send_queue();
+        secondTime += deltaTime;
+        m_connectionTime += deltaTime;
+        
+        // checking if second update should be called
+        if (secondTime >= 1.f)
+        {
+            m_second_update_function();
+            secondTime -= 1.f;
+        }
+
+        // calling the fixed update function
+        m_update_function(deltaTime);
+        
+        // if we are sending packets call the sending function
+        if (m_sendingPackets) 
+            m_packetSendFunction.invoke();
+        
+        if (m_histogramsEnabled.load(std::memory_order_relaxed))
+            m_tickHistogram.record(getNanoseconds() - tickStart);
+        m_tickScheduler.endTick();
+    }
+
+    // any coroutines that were scheduled after the last update are resumed here so none are lost
+    {
+        std::lock_guard lock(m_resumeMutex);
+        m_resumeOnUpdateThread = false;
+    }
+    m_resume_scheduled();
+}
+
+void Socket::m_shared_memory_thread(std::stop_token sToken)
+{
+    // a copy of the channels so that the lock is not held while parsing
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<SharedMemoryChannel>>> channels;
+    std::uint32_t version = m_sharedMemoryVersion.load() - 1;
+    sf::Packet packet;
+
+    while (!sToken.stop_requested())
+    {
+        if (version != m_sharedMemoryVersion.load())
+        {
+            std::shared_lock lock(m_sharedMemoryMutex);
+            version = m_sharedMemoryVersion.load();
+            channels.assign(m_sharedMemoryChannels.begin(), m_sharedMemoryChannels.end());
+        }
+
+        bool received = false;
+        for (auto& [key, channel]: channels)
+        {
+            // limiting how many are read at once so one peer can not starve the others
+            for (int i = 0; i < 64 && channel->receive(packet); i++)
+            {
+                received = true;
+                m_metrics.addIn(packet.getDataSize());
+                if (m_capture != nullptr)
+                    m_capture->capture(packet.getData(), packet.getDataSize(), false, sf::IpAddress((std::uint32_t)(key >> 16)), (PORT)(key & 0xFFFF), m_port);
+                m_handle_packet(packet, sf::IpAddress((std::uint32_t)(key >> 16)), (PORT)(key & 0xFFFF));
+                if (sToken.stop_requested()) return;
+            }
+        }
+        if (received)
+            continue;
+
+        std::uint32_t signal = m_sharedMemoryDoorbell->prepareWait();
+        // checking again now that senders know to wake us up
+        bool hasData = version != m_sharedMemoryVersion.load() || sToken.stop_requested();
+        for (auto& channel: channels)
+            hasData = hasData || channel.second->hasData();
+        if (hasData)
+            m_sharedMemoryDoorbell->cancelWait();
+        else // the timeout is only a safety net in case a wake up is ever lost
+            m_sharedMemoryDoorbell->wait(signal, 100);
+    }
+}
+
+// ---------------------------
+
+//* Protected Connection Functions
+
+void Socket::m_reset_connection_data()
+{
+    m_needsPassword = false;
+    setPassword("");
+    m_connectionOpen = false;
+    m_connectionTime = 0.f;
+    m_cancel_awaiting();
+    m_close_all_shared_memory();
+    // one last try for anything still waiting (i.e. the close packets) before it is thrown away
+    m_flush_send_queue();
+    m_sendQueue.clear();
+}
+
+// -------------------------------
+
+//* Coroutine Functions
+
+void Socket::m_schedule_resume(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard lock(m_resumeMutex);
+        if (m_resumeOnUpdateThread)
+        {
+            m_resumeQueue.push_back(handle);
+            return;
+        }
+    }
+    handle.resume();
+}
+
+void Socket::m_resume_scheduled()
+{
+    std::vector<std::coroutine_handle<>> toResume;
+    {
+        std::lock_guard lock(m_resumeMutex);
+        if (m_resumeQueue.empty())
+            return;
+        std::swap(toResume, m_resumeQueue);
+    }
+    // resumed outside of the lock as the coroutines may schedule more resumes
+    for (auto handle: toResume)
+        handle.resume();
+}
+
+void Socket::m_expire_requests()
+{
+    std::vector<std::shared_ptr<AsyncState<std::optional<Message>>>> expired;
+    {
+        std::lock_guard lock(m_awaitMutex);
+        if (m_pendingRequests.empty())
+            return;
+
+        auto now = std::chrono::steady_clock::now();
+        for (auto iter = m_pendingRequests.begin(); iter != m_pendingRequests.end();)
+        {
+            if (iter->second.deadline <= now)
+            {
+                expired.push_back(std::move(iter->second.state));
+                iter = m_pendingRequests.erase(iter);
+            }
+            else
+                iter++;
+        }
+    }
+    for (auto& state: expired)
+    {
+        if (auto handle = state->complete(std::nullopt))
+            m_schedule_resume(handle);
+    }
+}
+
+void Socket::m_add_receive_waiter(const std::shared_ptr<AsyncState<std::optional<Message>>>& state)
+{
+    {
+        std::lock_guard lock(m_awaitMutex);
+        // checked under the lock so the receive is either cancelled by m_cancel_awaiting or here
+        if (this->isConnectionOpen())
+        {
+            m_receiveWaiters.push_back(state);
+            m_receiveWaiterCount++;
+            return;
+        }
+    }
+    // nothing is suspended on the state yet so there is nothing to resume
+    state->complete(std::nullopt);
+}
+
+void Socket::m_remove_receive_waiter(const std::shared_ptr<AsyncState<std::optional<Message>>>& state)
+{
+    std::lock_guard lock(m_awaitMutex);
+    auto iter = std::find(m_receiveWaiters.begin(), m_receiveWaiters.end(), state);
+    if (iter == m_receiveWaiters.end())
+        return;
+    m_receiveWaiters.erase(iter);
+    m_receiveWaiterCount--;
+}
+
+void Socket::m_cancel_awaiting()
+{
+    std::vector<std::shared_ptr<AsyncState<std::optional<Message>>>> cancelled;
+    {
+        std::lock_guard lock(m_awaitMutex);
+        for (auto& waiter: m_receiveWaiters)
+            cancelled.push_back(std::move(waiter));
+        m_receiveWaiters.clear();
+        m_receiveWaiterCount = 0;
+        for (auto& request: m_pendingRequests)
+            cancelled.push_back(std::move(request.second.state));
+        m_pendingRequests.clear();
+    }
+    for (auto& state: cancelled)
+    {
+        if (auto handle = state->complete(std::nullopt))
+            m_schedule_resume(handle);
+    }
+}
+
+Awaitable<std::optional<Message>> Socket::m_send_request(const sf::Packet& message, ID receiver, sf::IpAddress ip, PORT port, sf::Time timeout)
+{
+    auto state = std::make_shared<AsyncState<std::optional<Message>>>();
+
+    std::uint32_t requestID = m_nextRequestID++;
+    if (requestID == 0) // 0 is never used so that it can not be confused with an unset ID
+        requestID = m_nextRequestID++;
+
+    {
+        std::lock_guard lock(m_awaitMutex);
+        m_pendingRequests.emplace(requestID, PendingRequest{state, receiver, 
+            std::chrono::steady_clock::now() + std::chrono::microseconds(timeout.asMicroseconds())});
+    }
+
+    sf::Packet request = RequestPacket(requestID);
+    request.append(message.getData(), message.getDataSize());
+    m_send(request, ip, port);
+
+    return Awaitable<std::optional<Message>>(std::move(state));
+}
+
+void Socket::m_handle_request(sf::Packet& packet, ID sender, sf::IpAddress ip, PORT port)
+{
+    std::uint32_t requestID;
+    if (!(packet >> requestID))
+        return;
+
+    RequestHandler handler;
+    {
+        std::lock_guard lock(m_awaitMutex);
+        handler = m_requestHandler;
+    }
+    if (!handler)
+        return;
+
+    sf::Packet response = ResponsePacket(requestID);
+    handler(packet, sender, response);
+    m_send(response, ip, port);
+}
+
+void Socket::m_handle_response(sf::Packet& packet, ID sender)
+{
+    std::uint32_t requestID;
+    if (!(packet >> requestID))
+        return;
+
+    std::shared_ptr<AsyncState<std::optional<Message>>> state;
+    {
+        std::lock_guard lock(m_awaitMutex);
+        auto iter = m_pendingRequests.find(requestID);
+        // the response must come from who the request was sent to
+        if (iter == m_pendingRequests.end() || iter->second.receiver != sender)
+            return;
+        state = std::move(iter->second.state);
+        m_pendingRequests.erase(iter);
+    }
+
+    Message message;
+    std::swap(message.packet, packet);
+    message.sender = sender;
+    if (auto handle = state->complete(std::move(message)))
+        m_schedule_resume(handle);
+}
+
+// -------------------------------
+
+//* Shared Memory Functions
+
+std::uint64_t Socket::m_shared_memory_key(sf::IpAddress ip, PORT port)
+{
+    return ((std::uint64_t)ip.toInteger() << 16) | port;
+}
+
+bool Socket::m_is_local_address(sf::IpAddress ip)
+{
+    if ((ip.toInteger() >> 24) == 127)
+        return true;
+    IpAddress_t local = sf::IpAddress::getLocalAddress();
+    return local.has_value() && local.value() == ip;
+}
+
+bool Socket::m_create_shared_memory_doorbell()
+{
+    if (m_sharedMemoryDoorbell == nullptr)
+        m_sharedMemoryDoorbell = SharedMemoryDoorbell::create();
+    return m_sharedMemoryDoorbell != nullptr;
+}
+
+void Socket::m_offer_shared_memory(sf::IpAddress ip, PORT port)
+{
+    if (!m_sharedMemoryEnabled || !m_is_local_address(ip))
+        return;
+
+    std::shared_ptr<SharedMemoryChannel> channel;
+    std::int32_t doorbellFD;
+    {
+        std::lock_guard lock(m_sharedMemoryMutex);
+        if (!m_create_shared_memory_doorbell())
+            return;
+        channel = SharedMemoryChannel::create();
+        if (channel == nullptr)
+            return;
+        m_sharedMemoryOffers[m_shared_memory_key(ip, port)] = channel;
+        doorbellFD = m_sharedMemoryDoorbell->getFD();
+    }
+
+    sf::Packet offer = SharedMemoryOfferPacket(getProcessID(), channel->getFD(), doorbellFD);
+    m_send(offer, ip, port);
+}
+
+void Socket::m_handle_shared_memory_offer(sf::Packet& packet, sf::IpAddress ip, PORT port)
+{
+    // the offer has to come from this host otherwise the process and files are not the senders
+    if (!m_sharedMemoryEnabled || !m_is_local_address(ip))
+        return;
+
+    std::uint32_t pid;
+    std::int32_t channelFD, remoteDoorbellFD;
+    if (!(packet >> pid >> channelFD >> remoteDoorbellFD))
+        return;
+
+    std::int32_t doorbellFD;
+    {
+        std::lock_guard lock(m_sharedMemoryMutex);
+        if (!m_create_shared_memory_doorbell())
+            return;
+        doorbellFD = m_sharedMemoryDoorbell->getFD();
+    }
+
+    // if anything fails the offer is ignored and the peer keeps using the transport
+    std::shared_ptr<SharedMemoryChannel> channel = SharedMemoryChannel::open(pid, channelFD);
+    if (channel == nullptr)
+        return;
+    std::unique_ptr<SharedMemoryDoorbell> remoteDoorbell = SharedMemoryDoorbell::open(pid, remoteDoorbellFD);
+    if (remoteDoorbell == nullptr)
+        return;
+    channel->setRemoteDoorbell(std::move(remoteDoorbell));
+
+    // accepting before the channel is used so the accept is not sent through the channel
+    sf::Packet accept = SharedMemoryAcceptPacket(getProcessID(), doorbellFD);
+    m_send(accept, ip, port);
+    m_add_shared_memory_channel(m_shared_memory_key(ip, port), std::move(channel));
+}
+
+void Socket::m_handle_shared_memory_accept(sf::Packet& packet, sf::IpAddress ip, PORT port)
+{
+    std::uint32_t pid;
+    std::int32_t remoteDoorbellFD;
+    if (!(packet >> pid >> remoteDoorbellFD))
+        return;
+
+    std::uint64_t key = m_shared_memory_key(ip, port);
+    std::shared_ptr<SharedMemoryChannel> channel;
+    {
+        std::lock_guard lock(m_sharedMemoryMutex);
+        auto iter = m_sharedMemoryOffers.find(key);
+        if (iter == m_sharedMemoryOffers.end())
+            return;
+        channel = std::move(iter->second);
+        m_sharedMemoryOffers.erase(iter);
+    }
+
+    std::unique_ptr<SharedMemoryDoorbell> remoteDoorbell = SharedMemoryDoorbell::open(pid, remoteDoorbellFD);
+    if (remoteDoorbell == nullptr)
+        return;
+    channel->setRemoteDoorbell(std::move(remoteDoorbell));
+    m_add_shared_memory_channel(key, std::move(channel));
+}
+
+void Socket::m_add_shared_memory_channel(std::uint64_t key, std::shared_ptr<SharedMemoryChannel> channel)
+{
+    {
+        std::lock_guard lock(m_sharedMemoryMutex);
+        m_sharedMemoryChannels[key] = std::move(channel);
+        m_sharedMemoryChannelCount = m_sharedMemoryChannels.size();
+        m_sharedMemoryVersion++;
+    }
+
+    {
+        std::lock_guard lock(m_threadMutex);
+        // the thread is stopped with the others so it is only started while they are running
+        if (m_sharedMemoryThread == nullptr && m_sSource != nullptr)
+        {
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            m_sharedMemoryThreadDone = done;
+            m_sharedMemoryThread = new std::jthread([this, done](std::stop_token sToken){
+                m_shared_memory_thread(sToken);
+                // this socket can be destroyed as soon as done is set so only the shared flag is used after
+                done->store(true);
+                done->notify_all();
+            }, m_sSource->get_token());
+            m_sharedMemoryThreadID = m_sharedMemoryThread->get_id();
+        }
+    }
+    m_sharedMemoryDoorbell->ring();
+}
+
+void Socket::m_close_shared_memory(sf::IpAddress ip, PORT port)
+{
+    if (m_sharedMemoryChannelCount.load() == 0)
+        return;
+
+    std::lock_guard lock(m_sharedMemoryMutex);
+    std::uint64_t key = m_shared_memory_key(ip, port);
+    m_sharedMemoryOffers.erase(key);
+    if (m_sharedMemoryChannels.erase(key) != 0)
+    {
+        m_sharedMemoryChannelCount = m_sharedMemoryChannels.size();
+        m_sharedMemoryVersion++;
+        m_sharedMemoryDoorbell->ring();
+    }
+}
+
+void Socket::m_close_all_shared_memory()
+{
+    std::lock_guard lock(m_sharedMemoryMutex);
+    m_sharedMemoryOffers.clear();
+    if (!m_sharedMemoryChannels.empty())
+    {
+        m_sharedMemoryChannels.clear();
+        m_sharedMemoryChannelCount = 0;
+        m_sharedMemoryVersion++;
+        m_sharedMemoryDoorbell->ring();
+    }
+}
+
+bool Socket::m_send_shared_memory(sf::Packet& packet, sf::IpAddress ip, PORT port)
+{
+    std::shared_ptr<SharedMemoryChannel> channel;
+    {
+        std::shared_lock lock(m_sharedMemoryMutex);
+        auto iter = m_sharedMemoryChannels.find(m_shared_memory_key(ip, port));
+        if (iter == m_sharedMemoryChannels.end())
+            return false;
+        channel = iter->second;
+    }
+    return channel->send(packet);
+}
+
+// -------------------------------
+
+//* Socket Functions
+
+void Socket::m_dispatch_data(sf::Packet& packet, ID sender)
+{
+    // anything waiting on a receive gets the data first
+    if (m_receiveWaiterCount.load(std::memory_order_relaxed) != 0)
+    {
+        std::shared_ptr<AsyncState<std::optional<Message>>> waiter;
+        {
+            std::lock_guard lock(m_awaitMutex);
+            if (!m_receiveWaiters.empty())
+            {
+                waiter = std::move(m_receiveWaiters.front());
+                m_receiveWaiters.pop_front();
+                m_receiveWaiterCount--;
+            }
+        }
+        if (waiter)
+        {
+            Message message;
+            std::swap(message.packet, packet);
+            message.sender = sender;
+            message.receiveTime = t_receiveTime;
+            message.arrivalTime = t_arrivalTime;
+            if (m_histogramsEnabled.load(std::memory_order_relaxed))
+                m_receiveLatencyHistogram.record(getNanoseconds() - t_receiveTime);
+            if (auto handle = waiter->complete(std::move(message)))
+                m_schedule_resume(handle);
+            return;
+        }
+    }
+
+    if (m_queueMessages.load(std::memory_order_relaxed))
+    {
+        Message message;
+        std::swap(message.packet, packet);
+        message.sender = sender;
+        // the latency is recorded once the message is polled
+        message.receiveTime = t_receiveTime;
+        message.arrivalTime = t_arrivalTime;
+        if (!m_messageQueue.push(message))
+            m_metrics.addDrop(DropReason::QueueFull);
+        // giving back whatever buffer was in the queue so it can be reused for the next receive
+        std::swap(message.packet, packet);
+        packet.clear();
+    }
+    else
+    {
+        if (m_histogramsEnabled.load(std::memory_order_relaxed))
+            m_receiveLatencyHistogram.record(getNanoseconds() - t_receiveTime);
+        onDataReceived.invoke(packet, sender, m_threadSafeEvents, m_overrideEvents);
+    }
+}
+
+void Socket::m_handle_packet(sf::Packet& packet, sf::IpAddress ip, PORT port, std::uint64_t arrivalTime)
+{
+    bool recordHistograms = m_histogramsEnabled.load(std::memory_order_relaxed);
+    std::uint64_t startTime = getNanoseconds();
+    t_receiveTime = startTime;
+    t_arrivalTime = arrivalTime;
+    if (recordHistograms && arrivalTime != 0)
+        m_receiveDelayHistogram.record(startTime > arrivalTime ? startTime - arrivalTime : 0);
+
+    std::int8_t packetType;
+    std::uint32_t connectionID;
+    if (!(packet >> packetType >> connectionID))
+    {
+        SocketMetrics::increment(m_metrics.parseErrors);
+        return;
+    }
+    t_connectionID = connectionID;
+
+    switch (packetType)
+    {
+    case (std::int8_t)PacketType::Data:
+        m_parse_data(packet, ip, port);
+        break;
+    
+    case (std::int8_t)PacketType::ConnectionRequest:
+        m_parse_connection_request(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::ConnectionClose:
+        m_parse_connection_close(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::ConnectionConfirm:
+        m_parse_connection_confirm(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::PasswordRequest:
+        m_parse_password_request(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::Password:
+        m_parse_password(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::Request:
+        m_parse_request(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::Response:
+        m_parse_response(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::Ping:
+        m_parse_ping(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::Pong:
+        m_parse_pong(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::SharedMemoryOffer:
+        m_parse_shared_memory_offer(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::SharedMemoryAccept:
+        m_parse_shared_memory_accept(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::PathChallenge:
+        m_parse_path_challenge(packet, ip, port);
+        break;
+
+    case (std::int8_t)PacketType::PathResponse:
+        m_parse_path_response(packet, ip, port);
+        break;
+
+    default:
+        SocketMetrics::increment(m_metrics.parseErrors);
+        m_parse_unkown(packet, ip, port);
+        return;
+    }
+
+    if (recordHistograms)
+        m_handlerHistograms[(std::size_t)packetType].record(getNanoseconds() - startTime);
+}
+
+ID Socket::m_get_connection_id()
+{
+    return t_connectionID;
+}
+
+std::uint64_t Socket::getArrivalTime()
+{
+    return t_arrivalTime;
+}
+
+namespace
+{
+
+void setHeaderID(sf::Packet& packet, std::uint32_t id)
+{
+    // anything shorter than the header was not made from a template so it is sent as is
+    if (packet.getDataSize() < PACKET_HEADER_SIZE)
+        return;
+    std::uint8_t* header = (std::uint8_t*)packet.getData() + 1;
+    header[0] = (std::uint8_t)(id >> 24);
+    header[1] = (std::uint8_t)(id >> 16);
+    header[2] = (std::uint8_t)(id >> 8);
+    header[3] = (std::uint8_t)id;
+}
+
+}
+
+SendResult Socket::m_send(sf::Packet& packet, sf::IpAddress ip, PORT port)
+{
+    setHeaderID(packet, m_id);
+    if (m_capture != nullptr)
+        m_capture->capture(packet.getData(), packet.getDataSize(), true, ip, port, m_port);
+    if (m_outgoingSimulator.isEnabled())
+    {
+        m_metrics.addOut(packet.getDataSize());
+        m_outgoingSimulator.push(packet, ip, port);
+        return SendResult::Sent;
+    }
+    if (m_sharedMemoryChannelCount.load(std::memory_order_relaxed) != 0 && m_send_shared_memory(packet, ip, port))
+    {
+        m_metrics.addOut(packet.getDataSize());
+        return SendResult::Sent;
+    }
+
+    if (!m_sendQueue.empty())
+        m_flush_send_queue();
+    // if packets are still waiting for the destination this one is queued behind them so they stay in order
+    bool dropped;
+    SendResult result = m_sendQueue.send(*m_transport, packet, ip, port, dropped);
+
+    if (result == SendResult::Sent)
+    {
+        m_metrics.addOut(packet.getDataSize());
+        return result;
+    }
+    if (result == SendResult::Failed)
+    {
+        SocketMetrics::increment(m_metrics.sendFailures);
+        return result;
+    }
+    SocketMetrics::increment(m_metrics.sendWouldBlock);
+    if (dropped)
+        SocketMetrics::increment(m_metrics.sendQueueDrops);
+    // the receive thread sends the queue as soon as the transport is writable again
+    m_transport->notifyWhenWritable();
+    return result;
+}
+
+SendResult Socket::m_send_batch(std::span<sf::Packet> packets, sf::IpAddress ip, PORT port)
+{
+    if (packets.size() < 2 || m_capture != nullptr || m_outgoingSimulator.isEnabled() ||
+        m_sharedMemoryChannelCount.load(std::memory_order_relaxed) != 0)
+    {
+        SendResult result = SendResult::Sent;
+        for (sf::Packet& packet: packets)
+        {
+            SendResult packetResult = m_send(packet, ip, port);
+            if (result == SendResult::Sent)
+                result = packetResult;
+        }
+        return result;
+    }
+
+    for (sf::Packet& packet: packets)
+        setHeaderID(packet, m_id);
+
+    // same as m_send, nothing can go ahead of packets already waiting for the destination
+    if (!m_sendQueue.empty())
+        m_flush_send_queue();
+    std::size_t sent;
+    std::size_t dropped;
+    SendResult result = m_sendQueue.sendBatch(*m_transport, packets, ip, port, sent, dropped);
+
+    for (std::size_t i = 0; i < sent; i++)
+        m_metrics.addOut(packets[i].getDataSize());
+    if (result == SendResult::Sent)
+        return result;
+    if (result == SendResult::Failed)
+    {
+        m_metrics.sendFailures.fetch_add(packets.size() - sent, std::memory_order_relaxed);
+        return result;
+    }
+    SocketMetrics::increment(m_metrics.sendWouldBlock);
+    m_metrics.sendQueueDrops.fetch_add(dropped, std::memory_order_relaxed);
+    m_transport->notifyWhenWritable();
+    return result;
+}
+
+void Socket::m_flush_send_queue()
+{
+    SendQueueFlush flush = m_sendQueue.flush(*m_transport);
+    m_metrics.packetsOut.fetch_add(flush.packets, std::memory_order_relaxed);
+    m_metrics.bytesOut.fetch_add(flush.bytes, std::memory_order_relaxed);
+    m_metrics.sendFailures.fetch_add(flush.failures, std::memory_order_relaxed);
+    if (flush.wouldBlock)
+        m_transport->notifyWhenWritable();
+}
+
+void Socket::m_send_pong(sf::Packet& ping, sf::IpAddress ip, PORT port)
+{
+    // the kernel arrival time keeps the wait for this thread out of the round trip time
+    std::int64_t receiveTime = t_arrivalTime != 0 ? (std::int64_t)(t_arrivalTime / 1000) : getClockTime();
+    std::int64_t pingSendTime;
+    if (!(ping >> pingSendTime))
+        return;
+
+    sf::Packet pong = PongPacket(pingSendTime, receiveTime);
+    m_send(pong, ip, port);
+}
+
+bool Socket::m_read_pong(sf::Packet& pong, RttEstimator& estimator, Histogram* histogram)
+{
+    std::int64_t arrivalTime = t_arrivalTime != 0 ? (std::int64_t)(t_arrivalTime / 1000) : getClockTime();
+    std::int64_t originTime, receiveTime, transmitTime;
+    if (!(pong >> originTime >> receiveTime >> transmitTime))
+        return false;
+
+    SocketMetrics::increment(m_metrics.pongsIn);
+    estimator.addSample(originTime, receiveTime, transmitTime, arrivalTime);
+    if (m_histogramsEnabled.load(std::memory_order_relaxed))
+    {
+        m_rttHistogram.recordSeconds(estimator.getLastRTT());
+        if (histogram != nullptr)
+            histogram->recordSeconds(estimator.getLastRTT());
+    }
+    return true;
+}
+
+void Socket::m_record_traffic_history(float rtt)
+{
+    m_trafficHistory.record({m_metrics.bytesIn.load(std::memory_order_relaxed), m_metrics.bytesOut.load(std::memory_order_relaxed),
+                             m_metrics.packetsIn.load(std::memory_order_relaxed), m_metrics.packetsOut.load(std::memory_order_relaxed),
+                             m_metrics.pingsOut.load(std::memory_order_relaxed), m_metrics.pongsIn.load(std::memory_order_relaxed)}, rtt);
+}
+
+// -----------------
+
+//* Public Thread functions
+
+void Socket::startThreads()
+{
+    std::lock_guard lock(m_threadMutex);
+    if (m_receiveThread == nullptr)
+    {
+        if (m_sSource != nullptr) delete(m_sSource);
+        m_sSource = new std::stop_source;
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        m_receiveThreadDone = done;
+        m_receiveThread = new std::jthread([this, done](std::stop_token sToken){
+            m_receive_packets_thread(sToken);
+            // this socket can be destroyed as soon as done is set so only the shared flag is used after
+            done->store(true);
+            done->notify_all();
+        }, m_sSource->get_token());
+        m_receiveThreadID = m_receiveThread->get_id();
+    }
+    if (m_updateThread == nullptr)
+    {
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        m_updateThreadDone = done;
+        m_updateThread = new std::jthread([this, done](std::stop_token sToken){
+            m_update_thread(sToken);
+            // this socket can be destroyed as soon as done is set so only the shared flag is used after
+            done->store(true);
+            done->notify_all();
+        }, m_sSource->get_token());
+        m_updateThreadID = m_updateThread->get_id();
+    }
+}
+
+void Socket::stopThreads()
+{
+    std::jthread* updateThread;
+    std::jthread* receiveThread;
+    std::jthread* sharedMemoryThread;
+    // taking the threads so that only one caller stops them if this is called from multiple threads at once
+    {
+        std::lock_guard lock(m_threadMutex);
+        if (m_sSource == nullptr) return;
+        m_sSource->request_stop();
+        delete(m_sSource);
+        m_sSource = nullptr;
+        updateThread = m_updateThread;
+        m_updateThread = nullptr;
+        receiveThread = m_receiveThread;
+        m_receiveThread = nullptr;
+        sharedMemoryThread = m_sharedMemoryThread;
+        m_sharedMemoryThread = nullptr;
+    }
+
+    if (sharedMemoryThread != nullptr)
+    {
+        m_sharedMemoryDoorbell->ring();
+        // the shared memory thread can not join its self (i.e. a handler closing the connection), destructors wait for that
+        if (sharedMemoryThread->get_id() == std::this_thread::get_id())
+            sharedMemoryThread->detach();
+        else
+            sharedMemoryThread->join();
+        delete(sharedMemoryThread);
+    }
+
+    if (updateThread != nullptr)
+    {
+        // the update thread wakes up as soon as a stop is requested so it can be joined
+        // unless this is being called from the update thread its self (i.e. a client timing out), destructors wait for that
+        if (updateThread->get_id() == std::this_thread::get_id())
+            updateThread->detach();
+        else
+            updateThread->join();
+        delete(updateThread);
+    }
+    // anything still delayed is sent now as it could be the connection close
+    m_outgoingSimulator.stop(true);
+    m_incomingSimulator.stop(false);
+    if (receiveThread != nullptr)
+    {
+        // the receive thread can not join its self, it exits once it is back in its loop and destructors wait for that
+        if (receiveThread->get_id() == std::this_thread::get_id())
+            receiveThread->detach();
+        else
+        {
+            // the stop is already requested so the thread leaves its loop on the next receive that returns
+            m_transport->interrupt();
+            receiveThread->join();
+        }
+        delete(receiveThread);
+    }
+}
+
+void Socket::setThreadSafeOverride(bool override)
+{
+    m_overrideEvents = override;
+}
+
+bool Socket::getThreadSafeOverride() const
+{
+    return m_overrideEvents;
+}
+
+// ------------------------
+
+//* Message Queue Functions
+
+void Socket::setMessageQueueEnabled(bool enabled)
+{
+    m_queueMessages = enabled;
+}
+
+bool Socket::isMessageQueueEnabled() const
+{
+    return m_queueMessages;
+}
+
+void Socket::setMessageQueueCapacity(std::size_t capacity)
+{
+    if (this->isConnectionOpen() || this->isReceivingPackets()) return;
 
-Socket::Socket()
+    m_messageQueue.reset(capacity);
+}
+
+std::size_t Socket::getMessageQueueCapacity() const
 {
-    if (const auto publicIP = sf::IpAddress::getPublicAddress(sf::seconds(1)))
-        m_id = publicIP->toInteger();
-    else
-        m_id = 0;
-    setPort(getLocalPort());
+    return m_messageQueue.capacity();
 }
 
-Socket::~Socket()
-{   
-    stopThreads();
-    close();
+std::size_t Socket::poll(std::span<Message> messages, std::size_t max)
+{
+    std::size_t count = std::min(messages.size(), max);
+    bool recordHistograms = m_histogramsEnabled.load(std::memory_order_relaxed);
+    std::uint64_t now = recordHistograms ? getNanoseconds() : 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (!m_messageQueue.pop(messages[i]))
+            return i;
+        if (recordHistograms)
+            m_receiveLatencyHistogram.record(now - messages[i].receiveTime);
+    }
+    return count;
 }
 
-// ------------------------------
+std::size_t Socket::getQueuedMessageCount() const
+{
+    return m_messageQueue.size();
+}
 
-//* Protected Thread Functions
+std::uint64_t Socket::getDroppedMessageCount() const
+{
+    return m_metrics.drops[(std::size_t)DropReason::QueueFull].load(std::memory_order_relaxed);
+}
 
-void Socket::m_receive_packets_thread(std::stop_token sToken)
+// ------------------------
+
+//* Send Queue Functions
+
+void Socket::setSendQueueCapacity(std::size_t capacity)
 {
-    sf::Packet packet;
-    IpAddress_t senderIP(sf::IpAddress::LocalHost);
-    unsigned short senderPort;
+    m_sendQueue.setCapacity(capacity);
+}
 
-    while (!sToken.stop_requested()) {
-        Status receiveStatus = this->receive(packet, senderIP, senderPort);
-        switch (receiveStatus)
-        {
-        case sf::Socket::Status::Error:
-            if (sToken.stop_requested()) return;
-            throw std::runtime_error("Error Receiving Packet (Code: " + std::to_string((int)receiveStatus) + ")");
-            break;
-        
-        case sf::Socket::Status::Disconnected:
-            if (sToken.stop_requested()) return;
-            break;
-        }
+std::size_t Socket::getSendQueueCapacity() const
+{
+    return m_sendQueue.getCapacity();
+}
 
-        std::int8_t packetType;
-        packet >> packetType;
+void Socket::setSendQueuePolicy(SendQueuePolicy policy)
+{
+    m_sendQueue.setPolicy(policy);
+}
 
-        if (!senderIP.has_value())
-            continue;
-        
-        switch (packetType)
-        {
-        case (std::int8_t)PacketType::Data:
-            m_parse_data(packet, senderIP.value(), senderPort);
-            break;
-        
-        case (std::int8_t)PacketType::ConnectionRequest:
-            m_parse_connection_request(packet, senderIP.value(), senderPort);
-            break;
+SendQueuePolicy Socket::getSendQueuePolicy() const
+{
+    return m_sendQueue.getPolicy();
+}
 
-        case (std::int8_t)PacketType::ConnectionClose:
-            m_parse_connection_close(packet, senderIP.value(), senderPort);
-            break;
+std::size_t Socket::getSendQueueSize() const
+{
+    return m_sendQueue.size();
+}
 
-        case (std::int8_t)PacketType::ConnectionConfirm:
-            m_parse_connection_confirm(packet, senderIP.value(), senderPort);
-            break;
+// ------------------------
 
-        case (std::int8_t)PacketType::PasswordRequest:
-            m_parse_password_request(packet, senderIP.value(), senderPort);
-            break;
+//* Shared Memory Functions
 
-        case (std::int8_t)PacketType::Password:
-            m_parse_password(packet, senderIP.value(), senderPort);
-            break;
+void Socket::setSharedMemoryEnabled(bool enabled)
+{
+    m_sharedMemoryEnabled = enabled;
+}
 
-        default:
-            m_parse_unkown(packet, senderIP.value(), senderPort);
-            break;
-        }
+bool Socket::isSharedMemoryEnabled() const
+{
+    return m_sharedMemoryEnabled;
+}
 
-        packet.clear();
-    }
+std::size_t Socket::getSharedMemoryChannelCount() const
+{
+    return m_sharedMemoryChannelCount;
 }
 
-void Socket::m_update_thread(std::stop_token sToken)
+// ------------------------
+
+//* Metrics Functions
+
+MetricsSnapshot Socket::getMetrics() const
 {
-    UpdateLimiter updateLimit(m_socketUpdateRate);
+    MetricsSnapshot snapshot;
+    snapshot.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    snapshot.copyCounters(m_metrics);
+    NetworkSimulatorStats incoming = m_incomingSimulator.getStats();
+    snapshot.drops[(std::size_t)DropReason::Simulated] = incoming.lost + incoming.queueDropped;
+
+    snapshot.connectionOpen = isConnectionOpen();
+    snapshot.messageQueueDepth = m_messageQueue.size();
+    snapshot.messageQueueCapacity = m_messageQueue.capacity();
+    snapshot.sendQueueDepth = m_sendQueue.size();
+    snapshot.sendQueueCapacity = m_sendQueue.getCapacity();
+    snapshot.simulatorIncomingPending = m_incomingSimulator.getPendingCount();
+    snapshot.simulatorOutgoingPending = m_outgoingSimulator.getPendingCount();
+    snapshot.sharedMemoryChannels = m_sharedMemoryChannelCount;
+    snapshot.ticks = m_tickScheduler.getStats();
+    return snapshot;
+}
 
-    sf::Clock deltaClock;
-    float deltaTime;
-    float secondTime;
-    
-    while (!sToken.stop_requested())
-    {
-        deltaTime = deltaClock.restart().asSeconds();
-        secondTime += deltaTime;
-        m_connectionTime += deltaTime;
-        
-        // checking if second update should be called
-        if (secondTime >= 1.f)
-        {
-            m_second_update_function();
-            secondTime = 0.f;
-        }
+void Socket::resetMetrics()
+{
+    m_metrics.reset();
+}
 
-        // calling the fixed update function
-        m_update_function(deltaTime);
-        
-        // if we are sending packets call the sending function
-        if (m_sendingPackets) 
-            m_packetSendFunction.invoke();
-        
-        updateLimit.wait();
-    }
+// -----------------
+
+//* Histogram Functions
+
+void Socket::setHistogramsEnabled(bool enabled)
+{
+    m_histogramsEnabled = enabled;
 }
 
-// ---------------------------
+bool Socket::isHistogramsEnabled() const
+{
+    return m_histogramsEnabled;
+}
 
-//* Protected Connection Functions
+HistogramSnapshot Socket::getReceiveLatencyHistogram() const
+{
+    return m_receiveLatencyHistogram.snapshot();
+}
 
-void Socket::m_reset_connection_data()
+HistogramSnapshot Socket::getReceiveDelayHistogram() const
 {
-    m_needsPassword = false;
-    setPassword("");
-    m_connectionOpen = false;
-    m_connectionTime = 0.f;
+    return m_receiveDelayHistogram.snapshot();
 }
 
-// -------------------------------
+HistogramSnapshot Socket::getHandlerHistogram(PacketType type) const
+{
+    if ((std::size_t)type >= m_handlerHistograms.size())
+        return {};
+    return m_handlerHistograms[(std::size_t)type].snapshot();
+}
 
-//* Socket Functions
+HistogramSnapshot Socket::getHandlerHistogram() const
+{
+    HistogramSnapshot snapshot;
+    for (auto& histogram: m_handlerHistograms)
+        snapshot.merge(histogram.snapshot());
+    return snapshot;
+}
+
+HistogramSnapshot Socket::getTickHistogram() const
+{
+    return m_tickHistogram.snapshot();
+}
 
-void Socket::m_send(sf::Packet& packet, sf::IpAddress ip, PORT port)
+HistogramSnapshot Socket::getRTTHistogram() const
 {
-    if (sf::UdpSocket::send(packet, sf::IpAddress(ip), port) != sf::Socket::Status::Done)
-        throw std::runtime_error("Could not send packet (Socket::m_send Function)");
+    return m_rttHistogram.snapshot();
+}
+
+void Socket::resetHistograms()
+{
+    m_receiveLatencyHistogram.reset();
+    m_receiveDelayHistogram.reset();
+    for (auto& histogram: m_handlerHistograms)
+        histogram.reset();
+    m_tickHistogram.reset();
+    m_rttHistogram.reset();
 }
 
 // -----------------
 
-//* Public Thread functions
+//* Traffic History Functions
 
-void Socket::startThreads()
+std::vector<TrafficSample> Socket::getTrafficHistory() const
 {
-    if (m_receiveThread == nullptr)
-    {
-        if (m_sSource != nullptr) delete(m_sSource);
-        m_sSource = new std::stop_source;
-        m_receiveThread = new std::jthread(&Socket::m_receive_packets_thread, this, m_sSource->get_token());
-    }
-    if (m_updateThread == nullptr) m_updateThread = new std::jthread(&Socket::m_update_thread, this, m_sSource->get_token());
+    return m_trafficHistory.getSamples();
 }
 
-void Socket::stopThreads()
+void Socket::clearTrafficHistory()
 {
-    if (m_sSource == nullptr) return;
-    m_sSource->request_stop();
-    if (m_updateThread != nullptr)
-    {
-        m_updateThread->detach();
-        delete(m_updateThread);
-        m_updateThread = nullptr;
-    }
-    if (m_receiveThread != nullptr)
-    {
-        // Sending a packet to its self so the receive thread can continue execution and exit
-        sf::Packet temp = DataPacketTemplate();
-        m_send(temp, sf::IpAddress{m_id}, m_port);
-        
-        m_receiveThread->detach();
-        delete(m_receiveThread);
-        m_receiveThread = nullptr;
-    }
-    delete(m_sSource);
-    m_sSource = nullptr;
+    m_trafficHistory.clear();
 }
 
-void Socket::setThreadSafeOverride(bool override)
+// -------------------------
+
+//* Transport Functions
+
+void Socket::setTransport(std::unique_ptr<Transport> transport)
 {
-    m_overrideEvents = override;
+    if (this->isConnectionOpen() || this->isReceivingPackets() || transport == nullptr) return;
+
+    m_transport->unbind();
+    m_transport = std::move(transport);
+    m_transport->setBufferSizes(m_bufferSizes);
+    m_transport->setTimestampsEnabled(m_kernelTimestamps);
+    m_transport->setOffloadEnabled(m_offloadEnabled);
 }
 
-bool Socket::getThreadSafeOverride() const
+Transport& Socket::getTransport()
 {
-    return m_overrideEvents;
+    return *m_transport;
+}
+
+void Socket::setBufferSizes(const SocketBufferSizes& sizes)
+{
+    m_bufferSizes = sizes;
+    m_transport->setBufferSizes(sizes);
+}
+
+const SocketBufferSizes& Socket::getBufferSizes() const
+{
+    return m_bufferSizes;
+}
+
+SocketBufferSizes Socket::getActualBufferSizes() const
+{
+    return m_transport->getBufferSizes();
+}
+
+void Socket::setKernelTimestampsEnabled(bool enabled)
+{
+    m_kernelTimestamps = enabled;
+    m_transport->setTimestampsEnabled(enabled);
+}
+
+bool Socket::isKernelTimestampsEnabled() const
+{
+    return m_kernelTimestamps;
+}
+
+void Socket::setSegmentationOffloadEnabled(bool enabled)
+{
+    m_offloadEnabled = enabled;
+    m_transport->setOffloadEnabled(enabled);
+}
+
+bool Socket::isSegmentationOffloadEnabled() const
+{
+    return m_offloadEnabled;
+}
+
+// ------------------------
+
+//* Capture Functions
+
+void Socket::setCapture(std::shared_ptr<PacketCapture> capture)
+{
+    if (this->isConnectionOpen() || this->isReceivingPackets()) return;
+
+    m_capture = std::move(capture);
+}
+
+std::shared_ptr<PacketCapture> Socket::getCapture() const
+{
+    return m_capture;
+}
+
+// ------------------------
+
+//* Network Simulator Functions
+
+NetworkSimulator& Socket::getOutgoingSimulator()
+{
+    return m_outgoingSimulator;
+}
+
+NetworkSimulator& Socket::getIncomingSimulator()
+{
+    return m_incomingSimulator;
 }
 
 
 // ------------------------
 
+//* Coroutine Functions
+
+Awaitable<std::optional<Message>> Socket::receive()
+{
+    if (!this->isConnectionOpen())
+        return Awaitable<std::optional<Message>>::ready(std::nullopt);
+
+    return Awaitable<std::optional<Message>>(std::make_shared<AsyncState<std::optional<Message>>>(),
+        [this](const auto& state){ m_add_receive_waiter(state); },
+        [this](const auto& state){ m_remove_receive_waiter(state); });
+}
+
+void Socket::setRequestHandler(const RequestHandler& handler)
+{
+    std::lock_guard lock(m_awaitMutex);
+    m_requestHandler = handler;
+}
+
+// --------------------
+
 //* Getter
 
 ID Socket::getID() const
@@ -203,7 +1331,22 @@ IpAddress_t Socket::getIP() const
 { 
     if (m_id == 0)
         return std::nullopt;
-    return sf::IpAddress(m_id); 
+    return sf::IpAddress(m_ip); 
+}
+
+IpAddress_t Socket::getPublicIP() const
+{
+    std::uint64_t publicIP = m_publicIP.load();
+    if (publicIP & PUBLIC_IP_SET)
+        return sf::IpAddress((std::uint32_t)publicIP);
+
+    PublicIPLookup& lookup = getPublicIPLookup();
+    PublicIPState state = lookup.state.load();
+    if (state == PublicIPState::Resolved)
+        return sf::IpAddress(lookup.address.load());
+    if (state == PublicIPState::NotStarted)
+        resolvePublicIP();
+    return std::nullopt;
 }
 
 IpAddress_t Socket::getLocalIP() const
@@ -216,7 +1359,10 @@ double Socket::getOpenTime() const
 { return m_connectionTime; }
 
 unsigned int Socket::getUpdateInterval() const
-{ return m_socketUpdateRate; }
+{ return m_tickScheduler.getTickRate(); }
+
+TickStats Socket::getTickStats() const
+{ return m_tickScheduler.getStats(); }
 
 unsigned int Socket::getPort() const
 { return m_port; }
@@ -234,18 +1380,24 @@ const funcHelper::func<void>& Socket::getPacketSendFunction() const
     return m_packetSendFunction;
 }
 
+float Socket::getPingInterval() const
+{ return m_pingInterval; }
+
 // -------
 
 //* Setters
 
 void Socket::setUpdateInterval(unsigned int interval)
 { 
-    if (this->isConnectionOpen()) return;
-
-    this->m_socketUpdateRate = interval;
-    onUpdateRateChanged.invoke(interval, m_threadSafeEvents, m_overrideEvents);
+    unsigned int oldRate = m_tickScheduler.getTickRate();
+    m_tickScheduler.setTickRate(interval);
+    if (m_tickScheduler.getTickRate() != oldRate)
+        onUpdateRateChanged.invoke(m_tickScheduler.getTickRate(), m_threadSafeEvents, m_overrideEvents);
 }
 
+void Socket::resetTickStats()
+{ m_tickScheduler.resetStats(); }
+
 void Socket::sendingPackets(bool sendPackets)
 { 
     if (this->isConnectionOpen()) return;
@@ -284,6 +1436,16 @@ void Socket::setPort(PORT port)
     onPortChanged.invoke(m_port, m_threadSafeEvents, m_overrideEvents);
 }
 
+void Socket::setPingInterval(float interval)
+{
+    m_pingInterval = std::max(interval, 0.f);
+}
+
+void Socket::setPublicIP(IpAddress_t publicIP)
+{
+    m_publicIP = publicIP.has_value() ? PUBLIC_IP_SET | publicIP->toInteger() : 0;
+}
+
 // --------
 
 //* Boolean question Functions
@@ -302,57 +1464,152 @@ bool Socket::isSendingPackets() const
 bool Socket::NeedsPassword() const
 { return this->m_needsPassword; }
 
+bool Socket::isResolvingPublicIP()
+{ return getPublicIPLookup().state.load() == PublicIPState::Resolving; }
+
 // TODO do this without requiring a dns query
 bool Socket::isValidIpAddress(const std::string& ipAddress)
 { return sf::Dns::resolve(ipAddress).has_value(); }
 
 // ---------------------------
 
+//* Time Functions
+
+std::int64_t Socket::getClockTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// -----------------
+
+//* Public IP Functions
+
+void Socket::resolvePublicIP(sf::Time timeout)
+{
+    PublicIPLookup& lookup = getPublicIPLookup();
+    PublicIPState state = lookup.state.load();
+    // only one lookup at a time and no need to look it up again once it is known
+    if (state == PublicIPState::Resolving || state == PublicIPState::Resolved ||
+        !lookup.state.compare_exchange_strong(state, PublicIPState::Resolving))
+        return;
+
+    // detached as the lookup is shared and should never hold up a socket from being destroyed
+    std::thread([timeout, lookup = &lookup](){
+        if (const auto publicIP = sf::IpAddress::getPublicAddress(timeout))
+        {
+            lookup->address = publicIP->toInteger();
+            lookup->state = PublicIPState::Resolved;
+        }
+        else
+            lookup->state = PublicIPState::Failed;
+    }).detach();
+}
+
+// -------------------
+
 //* Template Functions
 
 sf::Packet Socket::ConnectionCloseTemplate(std::string reason)
 {
-    sf::Packet out;
-    out << (std::int8_t)PacketType::ConnectionClose;
+    sf::Packet out = makePacket(PacketType::ConnectionClose);
     out << reason;
     return out;
 }
 
 sf::Packet Socket::ConnectionRequestTemplate()
 {
-    sf::Packet out;
-    out << (std::int8_t)PacketType::ConnectionRequest;
+    sf::Packet out = makePacket(PacketType::ConnectionRequest);
     return out;
 }
 
 sf::Packet Socket::DataPacketTemplate()
 {
-    sf::Packet out;
-    out << (std::int8_t)PacketType::Data;
+    sf::Packet out = makePacket(PacketType::Data);
     return out;
 }
 
-sf::Packet Socket::ConnectionConfirmPacket(std::uint32_t id)
+sf::Packet Socket::ConnectionConfirmPacket(std::uint32_t id, sf::IpAddress ip, std::uint64_t token)
 {
-    sf::Packet out;
-    out << (std::int8_t)PacketType::ConnectionConfirm;
+    sf::Packet out = makePacket(PacketType::ConnectionConfirm);
     out << id;
+    out << ip.toInteger();
+    out << token;
     return out;
 }
 
 sf::Packet Socket::PasswordRequestPacket()
 {
-    sf::Packet out;
-    out << (std::int8_t)PacketType::PasswordRequest;
+    sf::Packet out = makePacket(PacketType::PasswordRequest);
     return out;
 }
 
 sf::Packet Socket::PasswordPacket(const std::string& password)
 {
-    sf::Packet out;
-    out << (std::int8_t)PacketType::Password;
+    sf::Packet out = makePacket(PacketType::Password);
     out << password;
     return out;
 }
 
+sf::Packet Socket::RequestPacket(std::uint32_t requestID)
+{
+    sf::Packet out = makePacket(PacketType::Request);
+    out << requestID;
+    return out;
+}
+
+sf::Packet Socket::ResponsePacket(std::uint32_t requestID)
+{
+    sf::Packet out = makePacket(PacketType::Response);
+    out << requestID;
+    return out;
+}
+
+sf::Packet Socket::SharedMemoryOfferPacket(std::uint32_t pid, std::int32_t channelFD, std::int32_t doorbellFD)
+{
+    sf::Packet out = makePacket(PacketType::SharedMemoryOffer);
+    out << pid;
+    out << channelFD;
+    out << doorbellFD;
+    return out;
+}
+
+sf::Packet Socket::SharedMemoryAcceptPacket(std::uint32_t pid, std::int32_t doorbellFD)
+{
+    sf::Packet out = makePacket(PacketType::SharedMemoryAccept);
+    out << pid;
+    out << doorbellFD;
+    return out;
+}
+
+sf::Packet Socket::PathChallengePacket(std::uint64_t nonce)
+{
+    sf::Packet out = makePacket(PacketType::PathChallenge);
+    out << nonce;
+    return out;
+}
+
+sf::Packet Socket::PathResponsePacket(std::uint64_t nonce, std::uint64_t token)
+{
+    sf::Packet out = makePacket(PacketType::PathResponse);
+    out << nonce;
+    out << token;
+    return out;
+}
+
+sf::Packet Socket::PingPacket(std::int64_t sendTime)
+{
+    sf::Packet out = makePacket(PacketType::Ping);
+    out << sendTime;
+    return out;
+}
+
+sf::Packet Socket::PongPacket(std::int64_t pingSendTime, std::int64_t receiveTime)
+{
+    sf::Packet out = makePacket(PacketType::Pong);
+    out << pingSendTime;
+    out << receiveTime;
+    out << getClockTime();
+    return out;
+}
+
 // -------------------
\ No newline at end of file
@@ -2,9 +2,98 @@
 #include "SFML/Network/Dns.hpp"
 #include <SFML/Network/IpAddress.hpp>
 #include <optional>
+#include <cstdio>
+#include <algorithm>
 
 using namespace udp;
 
+namespace
+{
+
+/// @returns the percentiles in milliseconds (i.e. "p50 0.012 p99 0.25 p99.9 1.3 ms") or "NA" if nothing has been recorded
+std::string formatPercentiles(const HistogramSnapshot& histogram)
+{
+    if (histogram.count == 0)
+        return "NA";
+    char buffer[96];
+    std::snprintf(buffer, sizeof(buffer), "p50 %.3f  p99 %.3f  p99.9 %.3f  max %.3f ms",
+                  histogram.getPercentile(50) * 1000.0, histogram.getPercentile(99) * 1000.0,
+                  histogram.getPercentile(99.9) * 1000.0, histogram.getMax() * 1000.0);
+    return buffer;
+}
+
+/// @brief the number of seconds shown in each sparkline
+constexpr std::size_t SPARKLINE_LENGTH = 30;
+
+/// @returns the value of the last SPARKLINE_LENGTH samples as block characters scaled from 0 to the largest value
+template <typename Getter>
+std::string formatSparkline(const std::vector<TrafficSample>& samples, Getter getValue)
+{
+    static const char* const BLOCKS[] = {"\u2581", "\u2582", "\u2583", "\u2584", "\u2585", "\u2586", "\u2587", "\u2588"};
+
+    std::size_t first = samples.size() > SPARKLINE_LENGTH ? samples.size() - SPARKLINE_LENGTH : 0;
+    double max = 0.0;
+    for (std::size_t i = first; i < samples.size(); i++)
+        max = std::max(max, (double)getValue(samples[i]));
+
+    std::string line;
+    for (std::size_t i = first; i < samples.size(); i++)
+    {
+        double value = max <= 0.0 ? 0.0 : (double)getValue(samples[i]) / max;
+        line += BLOCKS[std::min<std::size_t>((std::size_t)(value * 7.0 + 0.5), 7)];
+    }
+    return line;
+}
+
+/// @returns the bytes as a rate (i.e. "12.3 KB/s")
+std::string formatByteRate(std::uint64_t bytes)
+{
+    char buffer[32];
+    if (bytes >= 1024 * 1024)
+        std::snprintf(buffer, sizeof(buffer), "%.2f MB/s", (double)bytes / (1024.0 * 1024.0));
+    else if (bytes >= 1024)
+        std::snprintf(buffer, sizeof(buffer), "%.1f KB/s", (double)bytes / 1024.0);
+    else
+        std::snprintf(buffer, sizeof(buffer), "%llu B/s", (unsigned long long)bytes);
+    return buffer;
+}
+
+/// @brief the text for each traffic graph (a sparkline followed by the last value)
+struct TrafficText
+{
+    std::string bytesIn = "NA";
+    std::string bytesOut = "NA";
+    std::string packets = "NA";
+    std::string loss = "NA";
+    std::string rtt = "NA";
+};
+
+TrafficText formatTraffic(const std::vector<TrafficSample>& samples)
+{
+    TrafficText text;
+    if (samples.empty())
+        return text;
+
+    const TrafficSample& last = samples.back();
+    char buffer[64];
+    text.bytesIn = formatSparkline(samples, [](auto& s){ return s.bytesIn; }) + "  " + formatByteRate(last.bytesIn);
+    text.bytesOut = formatSparkline(samples, [](auto& s){ return s.bytesOut; }) + "  " + formatByteRate(last.bytesOut);
+    std::snprintf(buffer, sizeof(buffer), "  in %llu  out %llu", (unsigned long long)last.packetsIn, (unsigned long long)last.packetsOut);
+    text.packets = formatSparkline(samples, [](auto& s){ return s.packetsIn + s.packetsOut; }) + buffer;
+    std::snprintf(buffer, sizeof(buffer), "  %.1f%%", last.loss * 100.f);
+    text.loss = formatSparkline(samples, [](auto& s){ return s.loss; }) + buffer;
+    std::snprintf(buffer, sizeof(buffer), "  %.3f ms", last.rtt * 1000.f);
+    text.rtt = formatSparkline(samples, [](auto& s){ return s.rtt; }) + buffer;
+    return text;
+}
+
+/// @brief the name of each row in the info list
+const std::array<const char*, 16> INFO_ROW_NAMES = {"ID", "Public IP", "Local IP", "Port", "Connection Open", "Connection Open Time",
+                                                    "Receive Delay", "Receive Latency", "Handler Time", "Tick Time", "RTT",
+                                                    "Bytes In", "Bytes Out", "Packets/s", "Ping Loss", "RTT History"};
+
+}
+
 SocketUI::SocketUI(tgui::Gui& gui, PORT serverPort) : 
     m_client(sf::IpAddress::LocalHost, serverPort), m_server(serverPort)
 {
@@ -37,8 +126,11 @@ void SocketUI::m_initEventCallbacks()
     {
         if (!m_infoParent)
             return;
-        m_updateInfo();
         data->setRunning();
+        if (m_infoRefreshRate > 0.f &&
+            std::chrono::steady_clock::now() - m_lastInfoUpdate < std::chrono::duration<float>(1.f / m_infoRefreshRate))
+            return;
+        m_updateInfo();
     }});
     m_tFuncID = updateFunc.getTypeid();
 
@@ -46,27 +138,6 @@ void SocketUI::m_initEventCallbacks()
     m_client.onConnectionOpen(TFunc::Add, updateFunc, std::numeric_limits<float>().infinity());
     m_server.onConnectionClose(TFunc::remove, m_tFuncID);
     m_client.onConnectionClose(TFunc::remove, m_tFuncID);
-
-    m_server.onClientConnected([this](ID id)
-    {
-        if (!m_infoParent) return;
-
-        std::string s_id = std::to_string(id);
-
-        auto data = m_server.getClientData(id);
-        m_clientData->addItem({"Client Data", s_id, "IP: " + sf::IpAddress(data->id).toString()});
-        m_clientData->addItem({"Client Data", s_id, "Port: " + std::to_string(data->port)});
-        m_clientData->addItem({"Client Data", s_id, "Packets/s: NA"});
-        m_clientData->addItem({"Client Data", s_id, "Last packet (s): NA"});
-        m_clientData->addItem({"Client Data", s_id, "Connection Time (s): NA"});
-        m_clientData->collapse({"Client Data", s_id});
-    });
-    m_server.onClientDisconnected([this](ID id)
-    {
-        if (!m_infoParent) return;
-
-        m_clientData->removeItem({"Client Data", std::to_string(id)}, false);
-    });
 }
 
 SocketUI::~SocketUI()
@@ -291,34 +362,48 @@ void SocketUI::setInfoVisible(bool visible)
         m_list->setMultiSelect(false);
         m_list->setAutoLayout(tgui::AutoLayout::Top);
         m_list->setAutoScroll(false);
-        m_list->addItem({"ID", "NA"});
-        m_list->addItem({"Public IP", "NA"});
-        m_list->addItem({"Local IP", "NA"});
-        m_list->addItem({"Port", "NA"});
-        m_list->addItem({"Connection Open", "NA"});
-        m_list->addItem({"Connection Open Time", "NA"});
+        for (auto name: INFO_ROW_NAMES)
+            m_list->addItem({name, "NA"});
+        m_infoRows.assign(INFO_ROW_NAMES.size(), "NA");
         m_list->setSize({"100%", tgui::bindMin(tgui::bindHeight(m_infoParent), m_list->getSizeLayout().y)});
         m_list->onItemSelect(&tgui::ListView::deselectItems, m_list);
 
+        //* client page controls (only visible if there is more than one page)
+        m_clientPageGroup = tgui::Group::create({"100%", 24});
+        m_infoParent->add(m_clientPageGroup);
+        m_clientPageGroup->setAutoLayout(tgui::AutoLayout::Bottom);
+        m_clientPageGroup->setVisible(false);
+        auto previousPage = tgui::Button::create("<");
+        auto nextPage = tgui::Button::create(">");
+        m_clientPageLabel = tgui::Label::create();
+        m_clientPageGroup->add(previousPage);
+        m_clientPageGroup->add(m_clientPageLabel);
+        m_clientPageGroup->add(nextPage);
+        previousPage->setSize({24, "100%"});
+        nextPage->setSize({24, "100%"});
+        nextPage->setPosition({tgui::bindWidth(m_clientPageGroup) - 24, 0});
+        m_clientPageLabel->setSize({tgui::bindWidth(m_clientPageGroup) - 56, "100%"});
+        m_clientPageLabel->setPosition({28, 0});
+        m_clientPageLabel->setHorizontalAlignment(tgui::Label::HorizontalAlignment::Center);
+        m_clientPageLabel->setVerticalAlignment(tgui::Label::VerticalAlignment::Center);
+        previousPage->onPress([this](){
+            if (m_clientPage == 0)
+                return;
+            m_clientPage--;
+            m_updateInfo();
+        });
+        nextPage->onPress([this](){
+            if (m_clientPage + 1 >= m_clientPageCount)
+                return;
+            m_clientPage++;
+            m_updateInfo();
+        });
+
         m_clientData = tgui::TreeView::create();
         m_infoParent->add(m_clientData);
         m_clientData->setAutoLayout(tgui::AutoLayout::Fill);
         m_clientData->onItemSelect(&tgui::TreeView::deselectItem, m_clientData);
 
-        if (isConnectionOpen() && isServer())
-        {
-            for (auto client: m_server.getClients())
-            {
-                std::string id = std::to_string(client->id);
-                m_clientData->addItem({"Client Data", id, "IP: " + sf::IpAddress(client->id).toString()});
-                m_clientData->addItem({"Client Data", id, "Port: " + std::to_string(client->port)});
-                m_clientData->addItem({"Client Data", id, "Packets/s: " + std::to_string(client->getPacketsPerSecond())});
-                m_clientData->addItem({"Client Data", id, "Last packet (s): " + std::to_string(client->getTimeSinceLastPacket())});
-                m_clientData->addItem({"Client Data", id, "Connection Time (s): " + std::to_string(client->getConnectionTime())});
-            }
-            m_clientData->collapseAll();
-        }
-
         m_updateInfo();
     }
 
@@ -335,6 +420,10 @@ void SocketUI::setInfoVisible(bool visible)
         m_infoParent = nullptr;
         m_list = nullptr;
         m_clientData = nullptr;
+        m_clientPageGroup = nullptr;
+        m_clientPageLabel = nullptr;
+        m_infoRows.clear();
+        m_clientRows.clear();
         TFunc::remove(m_tFuncID);
     }
 }
@@ -349,65 +438,206 @@ tgui::ChildWindow::Ptr SocketUI::getInfoWindow()
     return m_infoParent;
 }
 
+void SocketUI::setInfoRefreshRate(float refreshesPerSecond)
+{
+    m_infoRefreshRate = refreshesPerSecond;
+}
+
+float SocketUI::getInfoRefreshRate() const
+{
+    return m_infoRefreshRate;
+}
+
+void SocketUI::setInfoClientsPerPage(std::size_t count)
+{
+    m_clientsPerPage = count;
+    m_clientPage = 0;
+    m_updateInfo();
+}
+
+std::size_t SocketUI::getInfoClientsPerPage() const
+{
+    return m_clientsPerPage;
+}
+
 void SocketUI::m_updateInfo()
 {
     if (!isInfoVisible())
         return;
+    m_lastInfoUpdate = std::chrono::steady_clock::now();
 
-    if (m_socket == nullptr) 
-    {
-        m_list->changeItem(0, {"ID", "NA"});
-        m_list->changeItem(1, {"Public IP", "NA"});
-        m_list->changeItem(2, {"Local IP", "NA"});
-        m_list->changeItem(3, {"Port", "NA"});
-        m_list->changeItem(4, {"Connection Open", "NA"});
-        m_list->changeItem(5, {"Connection Open Time", "NA"});
-    }
-    else
+    std::array<tgui::String, INFO_ROW_NAMES.size()> rows;
+    rows.fill("NA");
+    MetricsSnapshot snapshot;
+
+    if (m_socket != nullptr)
     {
-        m_list->changeItem(0, {"ID", std::to_string(m_socket->getID())});
-        if (m_socket->getIP().has_value())
-            m_list->changeItem(1, {"Public IP", m_socket->getIP().value().toString()});
+        rows[0] = std::to_string(m_socket->getID());
+        if (m_socket->getPublicIP().has_value())
+            rows[1] = m_socket->getPublicIP().value().toString();
+        else if (Socket::isResolvingPublicIP())
+            rows[1] = "Resolving...";
         else
-            m_list->changeItem(1, {"Public IP", "Unable to resolve"});
+            rows[1] = "Unable to resolve";
 
         if (m_socket->getLocalIP().has_value())
-            m_list->changeItem(2, {"Local IP", m_socket->getLocalIP().value().toString()});
+            rows[2] = m_socket->getLocalIP().value().toString();
         else 
-            m_list->changeItem(2, {"Local IP", "Unable to resolve"});
+            rows[2] = "Unable to resolve";
+
+        rows[3] = std::to_string(m_socket->getPort());
+        rows[4] = m_socket->isConnectionOpen() ? "True" : "False";
+        rows[5] = std::to_string(m_socket->getConnectionTime());
+        // only recorded with kernel timestamps so it stays NA without them
+        rows[6] = formatPercentiles(m_socket->getReceiveDelayHistogram());
+        rows[7] = formatPercentiles(m_socket->getReceiveLatencyHistogram());
+        rows[8] = formatPercentiles(m_socket->getHandlerHistogram());
+        rows[9] = formatPercentiles(m_socket->getTickHistogram());
+        rows[10] = formatPercentiles(m_socket->getRTTHistogram());
+
+        TrafficText traffic = formatTraffic(m_socket->getTrafficHistory());
+        rows[11] = traffic.bytesIn;
+        rows[12] = traffic.bytesOut;
+        rows[13] = traffic.packets;
+        rows[14] = traffic.loss;
+        rows[15] = traffic.rtt;
+
+        // the client rows are copied from the ones the update thread publishes so the table below never blocks the network threads
+        if (m_isServer)
+            snapshot = m_server.getMetrics();
+    }
 
-        m_list->changeItem(3, {"Port", std::to_string(m_socket->getPort())});
-        m_list->changeItem(4, {"Connection Open", (m_socket->isConnectionOpen() ? "True" : "False")});
-        m_list->changeItem(5, {"Connection Open Time", std::to_string(m_socket->getConnectionTime())});
+    for (std::size_t i = 0; i < rows.size(); i++)
+    {
+        if (rows[i] == m_infoRows[i])
+            continue;
+        m_list->changeItem(i, {INFO_ROW_NAMES[i], rows[i]});
+        m_infoRows[i] = rows[i];
+    }
 
-        if (m_isServer)
+    if (m_socket != nullptr && m_isServer)
+    {
+        if (!m_clientData->isVisible())
         {
             m_clientData->setVisible(true);
             m_clientData->setEnabled(true);
-            if (m_clientData->getNode({"Client Data"}).text == "")
-                m_clientData->addItem({"Client Data"});
+        }
+        m_updateClientInfo(snapshot);
+    }
+    else if (m_clientData->isVisible())
+    {
+        m_clearClientInfo();
+        m_clientData->setVisible(false);
+        m_clientData->setEnabled(false);
+        m_clientPageGroup->setVisible(false);
+    }
+}
 
-            for (auto data: m_server.getClients())
-            {
-                tgui::String id(data->id);
+void SocketUI::m_updateClientInfo(const MetricsSnapshot& snapshot)
+{
+    if (m_clientData->getNode({"Client Data"}).text == "")
+        m_clientData->addItem({"Client Data"});
+
+    // sorted so clients stay on the same page between updates
+    std::vector<const ClientMetricsSnapshot*> clients;
+    clients.reserve(snapshot.clients.size());
+    for (auto& client: snapshot.clients)
+        clients.push_back(&client);
+    std::sort(clients.begin(), clients.end(), [](auto* a, auto* b){ return a->id < b->id; });
+
+    std::size_t first = 0;
+    std::size_t last = clients.size();
+    m_clientPageCount = 1;
+    if (m_clientsPerPage > 0)
+    {
+        m_clientPageCount = std::max<std::size_t>((clients.size() + m_clientsPerPage - 1) / m_clientsPerPage, 1);
+        m_clientPage = std::min(m_clientPage, m_clientPageCount - 1);
+        first = m_clientPage * m_clientsPerPage;
+        last = std::min(first + m_clientsPerPage, clients.size());
+    }
 
-                for (auto leaf: m_clientData->getNode({"Client Data", id}).nodes)
-                {
-                    if (leaf.text.starts_with("Pa"))
-                        m_clientData->changeItem({"Client Data", id, leaf.text}, {"Packets/s: " + std::to_string(data->getPacketsPerSecond())});
-                    else if (leaf.text.starts_with("L"))
-                        m_clientData->changeItem({"Client Data", id, leaf.text}, {"Last packet (s): " + std::to_string(data->getTimeSinceLastPacket())});
-                    else if (leaf.text.starts_with("C"))
-                        m_clientData->changeItem({"Client Data", id, leaf.text}, {"Connection Time (s): " + std::to_string(data->getConnectionTime())});
-                }
-            }
+    // removing clients that left or are no longer on this page
+    for (auto iter = m_clientRows.begin(); iter != m_clientRows.end();)
+    {
+        auto pageEnd = clients.begin() + last;
+        auto client = std::lower_bound(clients.begin() + first, pageEnd, iter->first,
+                                       [](const ClientMetricsSnapshot* client, ID id){ return client->id < id; });
+        if (client != pageEnd && (*client)->id == iter->first)
+        {
+            iter++;
+            continue;
         }
-        else
+        m_clientData->removeItem({"Client Data", std::to_string(iter->first)}, false);
+        iter = m_clientRows.erase(iter);
+    }
+
+    for (std::size_t i = first; i < last; i++)
+    {
+        const ClientMetricsSnapshot& client = *clients[i];
+        tgui::String id(std::to_string(client.id));
+        auto rows = m_clientRows.find(client.id);
+        bool added = rows == m_clientRows.end();
+        // the data of collapsed clients can not be seen so it is only updated once the client is expanded
+        if (!added && !m_clientData->getNode({"Client Data", id}).expanded)
+            continue;
+
+        std::array<tgui::String, CLIENT_ROW_COUNT> leaves = {
+            "IP: " + sf::IpAddress(client.ip).toString(),
+            "Port: " + std::to_string(client.port),
+            "Packets/s: " + std::to_string(client.packetsPerSecond),
+            "Last packet (s): " + std::to_string(client.timeSinceLastPacket),
+            "Connection Time (s): " + std::to_string(client.connectionTime),
+            "RTT: NA",
+            "Bytes In: NA",
+            "Bytes Out: NA",
+            "Ping Loss: NA",
+            "RTT History: NA"
+        };
+
+        if (added)
+        {
+            for (auto& leaf: leaves)
+                m_clientData->addItem({"Client Data", id, leaf});
+            m_clientData->collapse({"Client Data", id});
+            m_clientRows.emplace(client.id, leaves);
+            continue;
+        }
+
+        std::optional<HistogramSnapshot> rtt = m_server.getClientRTTHistogram(client.id);
+        if (rtt.has_value())
+            leaves[5] = "RTT: " + formatPercentiles(rtt.value());
+        std::optional<std::vector<TrafficSample>> history = m_server.getClientTrafficHistory(client.id);
+        if (history.has_value())
+        {
+            TrafficText traffic = formatTraffic(history.value());
+            leaves[6] = "Bytes In: " + traffic.bytesIn;
+            leaves[7] = "Bytes Out: " + traffic.bytesOut;
+            leaves[8] = "Ping Loss: " + traffic.loss;
+            leaves[9] = "RTT History: " + traffic.rtt;
+        }
+
+        for (std::size_t leaf = 0; leaf < CLIENT_ROW_COUNT; leaf++)
         {
-            m_clientData->setVisible(false);
-            m_clientData->setEnabled(false);
+            if (leaves[leaf] == rows->second[leaf])
+                continue;
+            m_clientData->changeItem({"Client Data", id, rows->second[leaf]}, leaves[leaf]);
+            rows->second[leaf] = leaves[leaf];
         }
     }
+
+    m_clientPageGroup->setVisible(m_clientPageCount > 1);
+    if (m_clientPageCount > 1)
+    {
+        m_clientPageLabel->setText("Clients " + std::to_string(first + 1) + "-" + std::to_string(last) + " of " + std::to_string(clients.size()) +
+                                   " (page " + std::to_string(m_clientPage + 1) + "/" + std::to_string(m_clientPageCount) + ")");
+    }
+}
+
+void SocketUI::m_clearClientInfo()
+{
+    m_clientData->removeAllItems();
+    m_clientRows.clear();
+    m_clientPageCount = 1;
 }
 
 bool SocketUI::isConnectionOpen()
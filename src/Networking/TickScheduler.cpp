@@ -0,0 +1,111 @@
+#include "Networking/TickScheduler.hpp"
+#include <algorithm>
+
+using namespace udp;
+
+TickScheduler::TickScheduler(unsigned int tickRate) : m_tickRate(std::max(tickRate, 1u))
+{
+    reset();
+}
+
+void TickScheduler::reset()
+{
+    m_timelineRate = m_tickRate.load();
+    m_tickInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(1000000000) / m_timelineRate);
+    m_timelineStart = Clock::now();
+    m_tickStart = m_timelineStart;
+    m_tickIndex = 0;
+}
+
+double TickScheduler::waitForNextTick(std::stop_token sToken)
+{
+    // the rate was changed so start a new timeline from the last scheduled tick
+    if (m_timelineRate != m_tickRate.load(std::memory_order_relaxed))
+    {
+        Clock::time_point lastTick = m_timelineStart + m_tickInterval * m_tickIndex;
+        m_timelineRate = m_tickRate.load(std::memory_order_relaxed);
+        m_tickInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(1000000000) / m_timelineRate);
+        m_timelineStart = lastTick;
+        m_tickIndex = 0;
+    }
+
+    m_tickIndex++;
+    Clock::time_point deadline = m_timelineStart + m_tickInterval * m_tickIndex;
+    Clock::time_point now = Clock::now();
+
+    // skipping any ticks that we are more than a full tick behind on
+    if (now - deadline >= m_tickInterval)
+    {
+        std::uint64_t behind = (std::uint64_t)((now - deadline) / m_tickInterval);
+        m_missedTicks.fetch_add(behind, std::memory_order_relaxed);
+        m_tickIndex += behind;
+        deadline += m_tickInterval * behind;
+    }
+
+    if (now < deadline)
+    {
+        std::unique_lock lock(m_sleepMutex);
+        if (m_sleepCondition.wait_until(lock, sToken, deadline, [](){ return false; }) || sToken.stop_requested())
+            return 0.0;
+        now = Clock::now();
+    }
+
+    std::int64_t jitter = std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline).count();
+    m_totalJitter.fetch_add(jitter, std::memory_order_relaxed);
+    if (jitter > m_maxJitter.load(std::memory_order_relaxed))
+        m_maxJitter.store(jitter, std::memory_order_relaxed);
+
+    double deltaTime = std::chrono::duration<double>(now - m_tickStart).count();
+    m_tickStart = now;
+    return deltaTime;
+}
+
+void TickScheduler::endTick()
+{
+    Clock::duration duration = Clock::now() - m_tickStart;
+    if (duration > m_tickInterval)
+        m_overruns.fetch_add(1, std::memory_order_relaxed);
+
+    std::int64_t durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    m_totalTickDuration.fetch_add(durationNs, std::memory_order_relaxed);
+    if (durationNs > m_maxTickDuration.load(std::memory_order_relaxed))
+        m_maxTickDuration.store(durationNs, std::memory_order_relaxed);
+    m_ticks.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TickScheduler::setTickRate(unsigned int tickRate)
+{
+    m_tickRate = std::max(tickRate, 1u);
+}
+
+unsigned int TickScheduler::getTickRate() const
+{
+    return m_tickRate;
+}
+
+TickStats TickScheduler::getStats() const
+{
+    TickStats stats;
+    stats.ticks = m_ticks.load(std::memory_order_relaxed);
+    stats.missedTicks = m_missedTicks.load(std::memory_order_relaxed);
+    stats.overruns = m_overruns.load(std::memory_order_relaxed);
+    stats.maxJitter = m_maxJitter.load(std::memory_order_relaxed) / 1e9;
+    stats.maxTickDuration = m_maxTickDuration.load(std::memory_order_relaxed) / 1e9;
+    if (stats.ticks != 0)
+    {
+        stats.averageJitter = m_totalJitter.load(std::memory_order_relaxed) / 1e9 / stats.ticks;
+        stats.averageTickDuration = m_totalTickDuration.load(std::memory_order_relaxed) / 1e9 / stats.ticks;
+    }
+    return stats;
+}
+
+void TickScheduler::resetStats()
+{
+    m_ticks = 0;
+    m_missedTicks = 0;
+    m_overruns = 0;
+    m_totalJitter = 0;
+    m_maxJitter = 0;
+    m_totalTickDuration = 0;
+    m_maxTickDuration = 0;
+}
@@ -0,0 +1,87 @@
+#include "Networking/TrafficHistory.hpp"
+#include <algorithm>
+
+using namespace udp;
+
+namespace
+{
+
+/// @returns the change from last to current (current if the counter was reset in between)
+std::uint64_t getDelta(std::uint64_t current, std::uint64_t last)
+{
+    return current >= last ? current - last : current;
+}
+
+}
+
+void TrafficRing::record(const TrafficTotals& totals, float rtt)
+{
+    if (!m_hasTotals)
+    {
+        m_lastTotals = totals;
+        m_hasTotals = true;
+        return;
+    }
+
+    TrafficSample& sample = m_samples[m_next];
+    sample.bytesIn = getDelta(totals.bytesIn, m_lastTotals.bytesIn);
+    sample.bytesOut = getDelta(totals.bytesOut, m_lastTotals.bytesOut);
+    sample.packetsIn = getDelta(totals.packetsIn, m_lastTotals.packetsIn);
+    sample.packetsOut = getDelta(totals.packetsOut, m_lastTotals.packetsOut);
+    sample.rtt = rtt;
+
+    std::uint64_t pings = getDelta(totals.pingsOut, m_lastTotals.pingsOut);
+    std::uint64_t pongs = getDelta(totals.pongsIn, m_lastTotals.pongsIn);
+    sample.loss = pings == 0 ? 0.f : std::clamp(1.f - (float)pongs / (float)pings, 0.f, 1.f);
+
+    m_lastTotals = totals;
+    m_next = (m_next + 1) % CAPACITY;
+    m_size = std::min(m_size + 1, CAPACITY);
+}
+
+std::vector<TrafficSample> TrafficRing::getSamples() const
+{
+    std::vector<TrafficSample> samples;
+    samples.reserve(m_size);
+    std::size_t first = (m_next + CAPACITY - m_size) % CAPACITY;
+    for (std::size_t i = 0; i < m_size; i++)
+        samples.push_back(m_samples[(first + i) % CAPACITY]);
+    return samples;
+}
+
+std::size_t TrafficRing::getSize() const
+{
+    return m_size;
+}
+
+void TrafficRing::clear()
+{
+    m_next = 0;
+    m_size = 0;
+    m_lastTotals = {};
+    m_hasTotals = false;
+}
+
+void TrafficHistory::record(const TrafficTotals& totals, float rtt)
+{
+    std::lock_guard lock(m_mutex);
+    m_ring.record(totals, rtt);
+}
+
+std::vector<TrafficSample> TrafficHistory::getSamples() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_ring.getSamples();
+}
+
+std::size_t TrafficHistory::getSize() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_ring.getSize();
+}
+
+void TrafficHistory::clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_ring.clear();
+}
@@ -0,0 +1,165 @@
+#include "Networking/TrafficReplay.hpp"
+#include "Networking/Socket.hpp"
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+
+using namespace udp;
+
+namespace
+{
+
+/// @returns false if the value does not fit before the end
+bool readVarint(const std::vector<std::uint8_t>& data, std::size_t& offset, std::uint64_t& value)
+{
+    value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        if (offset >= data.size())
+            return false;
+        std::uint8_t byte = data[offset++];
+        value |= (std::uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+template <typename T>
+bool readLittleEndian(const std::vector<std::uint8_t>& data, std::size_t& offset, T& value)
+{
+    if (data.size() - offset < sizeof(T))
+        return false;
+    std::uint64_t result = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++)
+        result |= (std::uint64_t)data[offset + i] << (i * 8);
+    value = (T)result;
+    offset += sizeof(T);
+    return true;
+}
+
+}
+
+bool TrafficReplay::load(const std::string& path)
+{
+    clear();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    std::size_t offset = 0;
+    std::uint32_t magic, version;
+    if (!readLittleEndian(m_data, offset, magic) || !readLittleEndian(m_data, offset, version) || !readLittleEndian(m_data, offset, m_startTime) ||
+        magic != ReplayLogFormat::MAGIC || version != ReplayLogFormat::VERSION)
+    {
+        clear();
+        return false;
+    }
+
+    std::uint64_t time = 0;
+    bool first = true;
+    while (offset < m_data.size())
+    {
+        Packet packet;
+        std::uint64_t delta, size;
+        if (!readVarint(m_data, offset, delta) || !readLittleEndian(m_data, offset, packet.ip) ||
+            !readLittleEndian(m_data, offset, packet.port) || !readVarint(m_data, offset, size) || m_data.size() - offset < size)
+            break;
+
+        // times are kept relative to the first packet so the wait before it is not replayed
+        if (first)
+            m_firstPacketTime = delta;
+        time = first ? 0 : time + delta;
+        first = false;
+        packet.time = time;
+        packet.offset = offset;
+        packet.size = (std::size_t)size;
+        offset += packet.size;
+        m_bytes += packet.size;
+        m_packets.push_back(packet);
+    }
+    return true;
+}
+
+void TrafficReplay::clear()
+{
+    m_data.clear();
+    m_packets.clear();
+    m_bytes = 0;
+    m_startTime = 0;
+    m_firstPacketTime = 0;
+}
+
+const std::vector<TrafficReplay::Packet>& TrafficReplay::getPackets() const
+{
+    return m_packets;
+}
+
+const std::uint8_t* TrafficReplay::getData(const Packet& packet) const
+{
+    return m_data.data() + packet.offset;
+}
+
+std::size_t TrafficReplay::getPacketCount() const
+{
+    return m_packets.size();
+}
+
+std::uint64_t TrafficReplay::getByteCount() const
+{
+    return m_bytes;
+}
+
+double TrafficReplay::getDuration() const
+{
+    return m_packets.empty() ? 0.0 : (double)m_packets.back().time / 1000000000.0;
+}
+
+std::uint64_t TrafficReplay::getStartTime() const
+{
+    return m_startTime;
+}
+
+std::uint64_t TrafficReplay::getCaptureTime(const Packet& packet) const
+{
+    return m_startTime + m_firstPacketTime + packet.time;
+}
+
+ReplayStats TrafficReplay::replay(Socket& socket, float speed, std::stop_token sToken) const
+{
+    using Clock = std::chrono::steady_clock;
+
+    ReplayStats stats;
+    sf::Packet packet;
+    auto start = Clock::now();
+
+    for (auto& recorded: m_packets)
+    {
+        if (sToken.stop_requested())
+            break;
+
+        if (speed > 0.f)
+        {
+            auto target = start + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds((std::uint64_t)((double)recorded.time / speed)));
+            auto now = Clock::now();
+            if (now < target)
+                std::this_thread::sleep_until(target);
+            else
+                stats.maxLag = std::max(stats.maxLag, std::chrono::duration<double>(now - target).count());
+        }
+
+        packet.clear();
+        packet.append(getData(recorded), recorded.size);
+        socket.m_metrics.addIn(recorded.size);
+        socket.m_handle_packet(packet, sf::IpAddress(recorded.ip), recorded.port);
+        stats.packets++;
+        stats.bytes += recorded.size;
+    }
+
+    stats.duration = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,423 @@
+#include "Networking/Transport.hpp"
+#include <chrono>
+#include <algorithm>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+// older headers do not have the UDP offload options
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
+using namespace udp;
+
+sf::Socket::Status Transport::sendBatch(std::span<sf::Packet> packets, sf::IpAddress ip, unsigned short port, std::size_t& sent)
+{
+    for (sent = 0; sent < packets.size(); sent++)
+    {
+        sf::Socket::Status status = send(packets[sent], ip, port);
+        if (status != sf::Socket::Status::Done)
+            return status;
+    }
+    return sf::Socket::Status::Done;
+}
+
+#ifdef __linux__
+namespace
+{
+
+sockaddr_in makeAddress(sf::IpAddress ip, unsigned short port)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(ip.toInteger());
+    address.sin_port = htons(port);
+    return address;
+}
+
+/// @returns the status for the errno of a failed send
+sf::Socket::Status getSendStatus(int error)
+{
+    if (error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS || error == EINTR)
+        return sf::Socket::Status::NotReady;
+    return sf::Socket::Status::Error;
+}
+
+}
+#endif
+
+UdpTransport::UdpTransport(sf::IpAddress bindAddress) : m_bindAddress(bindAddress)
+{
+#ifdef __linux__
+    m_wakeFD = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+UdpTransport::~UdpTransport()
+{
+#ifdef __linux__
+    if (m_wakeFD != -1)
+        ::close(m_wakeFD);
+#endif
+}
+
+sf::Socket::Status UdpTransport::bind(unsigned short port)
+{
+    sf::Socket::Status status = sf::UdpSocket::bind(port, m_bindAddress);
+    if (status == sf::Socket::Status::Done)
+    {
+        // a new socket so the kernel count starts over
+        m_lastOverflowCount = 0;
+        m_overflowCount = 0;
+        m_coalescedOffset = m_coalescedEnd = 0;
+#ifdef __linux__
+        // a wake up left over from the last receive thread is not meant for the next one
+        std::uint64_t signals;
+        if (m_wakeFD != -1)
+            (void)::read(m_wakeFD, &signals, sizeof(signals));
+#endif
+        m_apply_options();
+    }
+    return status;
+}
+
+void UdpTransport::unbind()
+{
+    sf::UdpSocket::unbind();
+}
+
+unsigned short UdpTransport::getLocalPort() const
+{
+    return sf::UdpSocket::getLocalPort();
+}
+
+sf::Socket::Status UdpTransport::send(sf::Packet& packet, sf::IpAddress ip, unsigned short port)
+{
+#ifdef __linux__
+    if (packet.getDataSize() > sf::UdpSocket::MaxDatagramSize)
+        return sf::Socket::Status::Error;
+
+    sockaddr_in address = makeAddress(ip, port);
+    // only this send is non blocking so the receive thread can keep blocking on the same socket
+    ssize_t sent = ::sendto(getNativeHandle(), packet.getData(), packet.getDataSize(), MSG_DONTWAIT | MSG_NOSIGNAL,
+                            reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    if (sent >= 0)
+        return sf::Socket::Status::Done;
+    return getSendStatus(errno);
+#else
+    return sf::UdpSocket::send(packet, ip, port);
+#endif
+}
+
+sf::Socket::Status UdpTransport::sendBatch(std::span<sf::Packet> packets, sf::IpAddress ip, unsigned short port, std::size_t& sent)
+{
+#ifdef __linux__
+    sockaddr_in address = makeAddress(ip, port);
+    sent = 0;
+    // packets before this are sent one at a time since their run could not be segmented
+    std::size_t unsegmentedEnd = 0;
+    while (sent < packets.size())
+    {
+        // every segment is the size of the first one except the last which can be smaller
+        std::size_t segmentSize = packets[sent].getDataSize();
+        std::size_t count = 1;
+        std::size_t total = segmentSize;
+        if (segmentSize != 0 && sent >= unsegmentedEnd && m_segmentationSupported.load(std::memory_order_relaxed))
+        {
+            while (sent + count < packets.size() && count < MAX_SEGMENTS)
+            {
+                std::size_t size = packets[sent + count].getDataSize();
+                if (size == 0 || size > segmentSize || total + size > sf::UdpSocket::MaxDatagramSize)
+                    break;
+                count++;
+                total += size;
+                if (size < segmentSize)
+                    break;
+            }
+        }
+
+        if (count == 1)
+        {
+            sf::Socket::Status status = send(packets[sent], ip, port);
+            if (status != sf::Socket::Status::Done)
+                return status;
+            sent++;
+            continue;
+        }
+
+        iovec data[MAX_SEGMENTS];
+        for (std::size_t i = 0; i < count; i++)
+            data[i] = {const_cast<void*>(packets[sent + i].getData()), packets[sent + i].getDataSize()};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(std::uint16_t))] = {};
+        msghdr message{};
+        message.msg_name = &address;
+        message.msg_namelen = sizeof(address);
+        message.msg_iov = data;
+        message.msg_iovlen = count;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_UDP;
+        header->cmsg_type = UDP_SEGMENT;
+        header->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+        std::uint16_t segment = (std::uint16_t)segmentSize;
+        std::memcpy(CMSG_DATA(header), &segment, sizeof(segment));
+
+        if (::sendmsg(getNativeHandle(), &message, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0)
+        {
+            sent += count;
+            continue;
+        }
+        int error = errno;
+        // the kernel or the device can not segment so this run (and every send after it) is sent one packet at a time
+        if (error == EIO || error == ENOPROTOOPT || error == EOPNOTSUPP)
+        {
+            m_segmentationSupported = false;
+            continue;
+        }
+        // only this run could not be segmented (i.e. a route with a smaller mtu than the segment size) so only it is sent one packet at a time
+        if (error == EINVAL)
+        {
+            unsegmentedEnd = sent + count;
+            continue;
+        }
+        return getSendStatus(error);
+    }
+    return sf::Socket::Status::Done;
+#else
+    return Transport::sendBatch(packets, ip, port, sent);
+#endif
+}
+
+bool UdpTransport::isWritable()
+{
+#ifdef __linux__
+    pollfd fd{getNativeHandle(), POLLOUT, 0};
+    return ::poll(&fd, 1, 0) > 0 && (fd.revents & POLLOUT);
+#else
+    return true;
+#endif
+}
+
+sf::Socket::Status UdpTransport::receive(sf::Packet& packet, std::optional<sf::IpAddress>& senderIP, unsigned short& senderPort)
+{
+#ifdef __linux__
+    packet.clear();
+    // the rest of the segments from the last coalesced receive (they share its sender and timestamp)
+    if (m_coalescedOffset < m_coalescedEnd)
+    {
+        std::size_t size = std::min(m_coalescedSegmentSize, m_coalescedEnd - m_coalescedOffset);
+        packet.append(m_receiveBuffer.data() + m_coalescedOffset, size);
+        m_coalescedOffset += size;
+        senderIP = m_coalescedSender;
+        senderPort = m_coalescedPort;
+        return sf::Socket::Status::Done;
+    }
+
+    // coalesced receives can be larger than one datagram
+    if (m_receiveBuffer.empty())
+        m_receiveBuffer.resize(1 << 16);
+
+    sockaddr_in address{};
+    iovec data{m_receiveBuffer.data(), m_receiveBuffer.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(std::uint32_t)) + CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(int))];
+    msghdr message{};
+    message.msg_name = &address;
+    message.msg_namelen = sizeof(address);
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    senderIP = std::nullopt;
+    senderPort = 0;
+    m_receiveTimestamp = 0;
+    std::size_t segmentSize = 0;
+    // without the eventfd this blocks in recvmsg and is woken up by the empty packet interrupt sends
+    ssize_t received = ::recvmsg(getNativeHandle(), &message, m_wakeFD == -1 ? 0 : MSG_DONTWAIT);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && m_wakeFD != -1)
+    {
+        // only waits when nothing is queued so a busy socket still takes one call per packet
+        short events = m_notifyWritable.load() ? POLLIN | POLLOUT : POLLIN;
+        pollfd fds[2] = {{getNativeHandle(), events, 0}, {m_wakeFD, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0)
+            return errno == EINTR ? sf::Socket::Status::NotReady : sf::Socket::Status::Error;
+        if (fds[1].revents & POLLIN)
+        {
+            std::uint64_t signals;
+            (void)::read(m_wakeFD, &signals, sizeof(signals));
+            return sf::Socket::Status::NotReady;
+        }
+        if (fds[0].revents & POLLOUT)
+        {
+            m_notifyWritable = false;
+            return sf::Socket::Status::NotReady;
+        }
+        received = ::recvmsg(getNativeHandle(), &message, MSG_DONTWAIT);
+    }
+    if (received < 0)
+        return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK ? sf::Socket::Status::NotReady : sf::Socket::Status::Error;
+
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SO_RXQ_OVFL)
+        {
+            std::uint32_t count;
+            std::memcpy(&count, CMSG_DATA(header), sizeof(count));
+            // unsigned subtraction so the count wrapping is still the right difference
+            m_overflowCount.fetch_add(count - m_lastOverflowCount, std::memory_order_relaxed);
+            m_lastOverflowCount = count;
+        }
+        else if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SO_TIMESTAMPNS)
+        {
+            timespec arrival;
+            std::memcpy(&arrival, CMSG_DATA(header), sizeof(arrival));
+            // how long ago the packet arrived on the real time clock taken from the steady clock now
+            std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            std::int64_t age = std::max<std::int64_t>(now - ((std::int64_t)arrival.tv_sec * 1000000000 + arrival.tv_nsec), 0);
+            std::int64_t steadyNow = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            m_receiveTimestamp = (std::uint64_t)std::max<std::int64_t>(steadyNow - age, 1);
+        }
+        else if (header->cmsg_level == SOL_UDP && header->cmsg_type == UDP_GRO)
+        {
+            int size;
+            std::memcpy(&size, CMSG_DATA(header), sizeof(size));
+            segmentSize = (std::size_t)std::max(size, 0);
+        }
+    }
+
+    // the empty packets sent by interrupt
+    if (received == 0)
+        return sf::Socket::Status::NotReady;
+    senderIP = sf::IpAddress(ntohl(address.sin_addr.s_addr));
+    senderPort = ntohs(address.sin_port);
+    if (segmentSize != 0 && (std::size_t)received > segmentSize)
+    {
+        m_coalescedOffset = segmentSize;
+        m_coalescedEnd = (std::size_t)received;
+        m_coalescedSegmentSize = segmentSize;
+        m_coalescedSender = senderIP.value();
+        m_coalescedPort = senderPort;
+        received = (ssize_t)segmentSize;
+    }
+    packet.append(m_receiveBuffer.data(), (std::size_t)received);
+    return sf::Socket::Status::Done;
+#else
+    return sf::UdpSocket::receive(packet, senderIP, senderPort);
+#endif
+}
+
+void UdpTransport::interrupt()
+{
+#ifdef __linux__
+    if (m_wakeFD != -1)
+    {
+        std::uint64_t signal = 1;
+        (void)::write(m_wakeFD, &signal, sizeof(signal));
+        return;
+    }
+#endif
+    unsigned short port = sf::UdpSocket::getLocalPort();
+    if (port == 0)
+        return;
+
+    sf::Packet empty;
+    (void)sf::UdpSocket::send(empty, m_bindAddress == sf::IpAddress::Any ? sf::IpAddress::LocalHost : m_bindAddress, port);
+}
+
+void UdpTransport::notifyWhenWritable()
+{
+#ifdef __linux__
+    // a receive that is already waiting has to be woken up to start waiting for POLLOUT as well
+    if (m_wakeFD != -1 && !m_notifyWritable.exchange(true))
+    {
+        std::uint64_t signal = 1;
+        (void)::write(m_wakeFD, &signal, sizeof(signal));
+    }
+#endif
+}
+
+void UdpTransport::setBufferSizes(const SocketBufferSizes& sizes)
+{
+    m_bufferSizes = sizes;
+    if (sf::UdpSocket::getLocalPort() != 0)
+        m_apply_options();
+}
+
+SocketBufferSizes UdpTransport::getBufferSizes() const
+{
+    SocketBufferSizes sizes;
+#ifdef __linux__
+    if (sf::UdpSocket::getLocalPort() == 0)
+        return sizes;
+    socklen_t length = sizeof(int);
+    (void)::getsockopt(getNativeHandle(), SOL_SOCKET, SO_RCVBUF, &sizes.receive, &length);
+    length = sizeof(int);
+    (void)::getsockopt(getNativeHandle(), SOL_SOCKET, SO_SNDBUF, &sizes.send, &length);
+#endif
+    return sizes;
+}
+
+std::uint64_t UdpTransport::getReceiveOverflowCount() const
+{
+    return m_overflowCount.load(std::memory_order_relaxed);
+}
+
+void UdpTransport::setTimestampsEnabled(bool enabled)
+{
+    m_timestampsEnabled = enabled;
+    if (sf::UdpSocket::getLocalPort() != 0)
+        m_apply_options();
+}
+
+std::uint64_t UdpTransport::getReceiveTimestamp() const
+{
+    return m_receiveTimestamp;
+}
+
+void UdpTransport::setOffloadEnabled(bool enabled)
+{
+    m_offloadEnabled = enabled;
+    m_segmentationSupported = enabled;
+    if (sf::UdpSocket::getLocalPort() != 0)
+        m_apply_options();
+}
+
+bool UdpTransport::isSegmentationSupported() const
+{
+    return m_segmentationSupported;
+}
+
+void UdpTransport::m_apply_options()
+{
+#ifdef __linux__
+    int handle = getNativeHandle();
+    int enabled = 1;
+    (void)::setsockopt(handle, SOL_SOCKET, SO_RXQ_OVFL, &enabled, sizeof(enabled));
+    int timestamps = m_timestampsEnabled ? 1 : 0;
+    (void)::setsockopt(handle, SOL_SOCKET, SO_TIMESTAMPNS, &timestamps, sizeof(timestamps));
+    // fails on kernels without GRO for UDP sockets which just means every packet is received on its own
+    int coalesce = m_offloadEnabled ? 1 : 0;
+    (void)::setsockopt(handle, SOL_UDP, UDP_GRO, &coalesce, sizeof(coalesce));
+
+    // the force options fail without CAP_NET_ADMIN so the normal (capped) option is used instead
+    if (m_bufferSizes.receive > 0 && (!m_bufferSizes.force ||
+        ::setsockopt(handle, SOL_SOCKET, SO_RCVBUFFORCE, &m_bufferSizes.receive, sizeof(int)) != 0))
+        (void)::setsockopt(handle, SOL_SOCKET, SO_RCVBUF, &m_bufferSizes.receive, sizeof(int));
+    if (m_bufferSizes.send > 0 && (!m_bufferSizes.force ||
+        ::setsockopt(handle, SOL_SOCKET, SO_SNDBUFFORCE, &m_bufferSizes.send, sizeof(int)) != 0))
+        (void)::setsockopt(handle, SOL_SOCKET, SO_SNDBUF, &m_bufferSizes.send, sizeof(int));
+#endif
+}
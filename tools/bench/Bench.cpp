@@ -0,0 +1,275 @@
+#include "Bench.hpp"
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <ctime>
+#include <cmath>
+#include <new>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+using namespace bench;
+
+//* Arguments
+
+Arguments::Arguments(int argc, char** argv, int start)
+{
+    for (int i = start; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0)
+            continue;
+        std::string name = arg.substr(2);
+        // a flag if there is no value after it
+        if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0)
+            m_values[name] = argv[++i];
+        else
+            m_values[name] = "";
+    }
+}
+
+bool Arguments::has(const std::string& name) const
+{
+    return m_values.contains(name);
+}
+
+std::string Arguments::getString(const std::string& name, const std::string& defaultValue) const
+{
+    auto iter = m_values.find(name);
+    if (iter == m_values.end() || iter->second.empty())
+        return defaultValue;
+    return iter->second;
+}
+
+std::int64_t Arguments::getInt(const std::string& name, std::int64_t defaultValue) const
+{
+    std::string value = getString(name, "");
+    if (value.empty())
+        return defaultValue;
+    return std::stoll(value);
+}
+
+double Arguments::getDouble(const std::string& name, double defaultValue) const
+{
+    std::string value = getString(name, "");
+    if (value.empty())
+        return defaultValue;
+    return std::stod(value);
+}
+
+// ------------------
+
+//* Latency Recorder
+
+LatencyRecorder::LatencyRecorder(std::size_t maxSamples) : m_maxSamples(maxSamples) {}
+
+void LatencyRecorder::add(std::int64_t latency)
+{
+    if (m_samples.size() >= m_maxSamples)
+        return;
+    m_samples.push_back(latency);
+    m_sorted = false;
+}
+
+void LatencyRecorder::merge(const LatencyRecorder& other)
+{
+    std::size_t count = std::min(other.m_samples.size(), m_maxSamples - std::min(m_maxSamples, m_samples.size()));
+    m_samples.insert(m_samples.end(), other.m_samples.begin(), other.m_samples.begin() + count);
+    m_sorted = false;
+}
+
+std::size_t LatencyRecorder::getCount() const
+{
+    return m_samples.size();
+}
+
+double LatencyRecorder::getPercentile(double percentile)
+{
+    if (m_samples.empty())
+        return 0.0;
+    if (!m_sorted)
+    {
+        std::sort(m_samples.begin(), m_samples.end());
+        m_sorted = true;
+    }
+    // nearest rank
+    std::size_t rank = (std::size_t)std::ceil(percentile / 100.0 * (double)m_samples.size());
+    rank = std::clamp(rank, (std::size_t)1, m_samples.size());
+    return (double)m_samples[rank - 1];
+}
+
+double LatencyRecorder::getAverage() const
+{
+    if (m_samples.empty())
+        return 0.0;
+    long double total = 0;
+    for (auto sample: m_samples)
+        total += sample;
+    return (double)(total / m_samples.size());
+}
+
+// ------------------
+
+double bench::getProcessCPUTime()
+{
+#ifdef __linux__
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1e6 +
+           (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1e6;
+#else
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+//* Allocation Counting
+
+namespace
+{
+
+thread_local std::uint64_t t_allocations = 0;
+thread_local std::uint64_t t_allocatedBytes = 0;
+
+void* countedAllocate(std::size_t size)
+{
+    t_allocations++;
+    t_allocatedBytes += size;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+}
+
+AllocationCount bench::getThreadAllocations()
+{
+    return AllocationCount{t_allocations, t_allocatedBytes};
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// ------------------
+
+//* Report
+
+namespace
+{
+
+std::string escapeJson(const std::string& str)
+{
+    std::string out;
+    for (char c: str)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+std::string formatNumber(double value)
+{
+    if (!std::isfinite(value))
+        return "null";
+    std::ostringstream stream;
+    stream << std::setprecision(10) << value;
+    return stream.str();
+}
+
+}
+
+Report::Report(const std::string& benchmark) : m_benchmark(benchmark)
+{
+    m_cases.push_back(Case{"", {}});
+}
+
+void Report::setConfig(const std::string& name, const std::string& value)
+{
+    m_config.emplace_back(name, "\"" + escapeJson(value) + "\"");
+}
+
+void Report::setConfig(const std::string& name, double value)
+{
+    m_config.emplace_back(name, formatNumber(value));
+}
+
+void Report::addResult(const std::string& name, double value, const std::string& unit)
+{
+    m_cases.back().results.push_back(Result{name, value, unit});
+}
+
+void Report::beginCase(const std::string& name)
+{
+    if (m_cases.size() == 1 && m_cases.front().name.empty() && m_cases.front().results.empty())
+        m_cases.front().name = name;
+    else
+        m_cases.push_back(Case{name, {}});
+}
+
+void Report::print() const
+{
+    std::cout << "== " << m_benchmark << " ==\n";
+    for (auto& [name, value]: m_config)
+        std::cout << "  " << name << ": " << value << "\n";
+    for (auto& benchCase: m_cases)
+    {
+        if (benchCase.results.empty())
+            continue;
+        if (!benchCase.name.empty())
+            std::cout << "-- " << benchCase.name << "\n";
+        for (auto& result: benchCase.results)
+        {
+            std::cout << "  " << std::left << std::setw(24) << result.name << std::right << std::setw(16) 
+                      << std::fixed << std::setprecision(2) << result.value << " " << result.unit << "\n";
+        }
+    }
+    std::cout << std::defaultfloat;
+}
+
+bool Report::writeJson(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+        return false;
+
+    file << "{\n  \"benchmark\": \"" << escapeJson(m_benchmark) << "\",\n  \"timestamp\": " << std::time(nullptr) << ",\n  \"config\": {";
+    for (std::size_t i = 0; i < m_config.size(); i++)
+        file << (i == 0 ? "\n" : ",\n") << "    \"" << escapeJson(m_config[i].first) << "\": " << m_config[i].second;
+    file << "\n  },\n  \"cases\": [";
+    bool firstCase = true;
+    for (auto& benchCase: m_cases)
+    {
+        if (benchCase.results.empty())
+            continue;
+        file << (firstCase ? "\n" : ",\n") << "    {\"name\": \"" << escapeJson(benchCase.name) << "\", \"results\": {";
+        firstCase = false;
+        for (std::size_t i = 0; i < benchCase.results.size(); i++)
+            file << (i == 0 ? "" : ", ") << "\"" << escapeJson(benchCase.results[i].name) << "\": " << formatNumber(benchCase.results[i].value);
+        file << "}}";
+    }
+    file << "\n  ]\n}\n";
+    return (bool)file;
+}
+
+// ------------------
+
+std::vector<Command>& bench::getCommands()
+{
+    static std::vector<Command> commands;
+    return commands;
+}
+
+RegisterCommand::RegisterCommand(const Command& command)
+{
+    getCommands().push_back(command);
+}
@@ -0,0 +1,192 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace bench
+{
+
+/// @brief the command line arguments for a benchmark ("--name value" or "--flag")
+class Arguments
+{
+public:
+    Arguments(int argc, char** argv, int start);
+
+    bool has(const std::string& name) const;
+    std::string getString(const std::string& name, const std::string& defaultValue) const;
+    std::int64_t getInt(const std::string& name, std::int64_t defaultValue) const;
+    double getDouble(const std::string& name, double defaultValue) const;
+
+private:
+    std::unordered_map<std::string, std::string> m_values;
+};
+
+/// @brief stores latency samples and calculates percentiles from them
+class LatencyRecorder
+{
+public:
+    /// @param maxSamples samples after this are ignored so memory use is bounded
+    LatencyRecorder(std::size_t maxSamples = 1 << 24);
+
+    /// @param latency in microseconds
+    void add(std::int64_t latency);
+    /// @brief adds all the samples from the other recorder
+    void merge(const LatencyRecorder& other);
+    std::size_t getCount() const;
+    /// @param percentile from 0 to 100
+    /// @returns the latency in microseconds (0 if there are no samples)
+    double getPercentile(double percentile);
+    double getAverage() const;
+
+private:
+    std::vector<std::int64_t> m_samples;
+    std::size_t m_maxSamples;
+    bool m_sorted = true;
+};
+
+/// @returns the cpu time used by the whole process in seconds
+double getProcessCPUTime();
+
+/// @brief heap allocations made by the calling thread
+/// @note counted by replacing the global operator new for the bench tool
+struct AllocationCount
+{
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+/// @returns the allocations the calling thread has made since it started
+AllocationCount getThreadAllocations();
+
+/// @brief stops the compiler from optimizing away a value that is not used
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/// @brief the average cost of one call of a micro benchmark
+struct MicroResult
+{
+    std::uint64_t iterations = 0;
+    double nanoseconds = 0.0;
+    double allocations = 0.0;
+    double allocatedBytes = 0.0;
+    /// @brief the size returned by the benchmark function (i.e. the serialized size)
+    double bytes = 0.0;
+};
+
+/// @brief calls the function in batches until at least minSeconds has passed
+/// @param function returns the number of bytes the operation produced or consumed
+template <typename Function>
+MicroResult measure(Function&& function, double minSeconds)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // warming up caches and finding how many calls fit in a batch of about a millisecond
+    std::uint64_t batch = 1;
+    while (true)
+    {
+        auto start = Clock::now();
+        for (std::uint64_t i = 0; i < batch; i++)
+            doNotOptimize(function());
+        if (Clock::now() - start > std::chrono::milliseconds(1) || batch >= (1ull << 30))
+            break;
+        batch *= 2;
+    }
+
+    MicroResult result;
+    std::uint64_t bytes = 0;
+    AllocationCount allocStart = getThreadAllocations();
+    auto start = Clock::now();
+    auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(minSeconds));
+    Clock::time_point now;
+    do
+    {
+        for (std::uint64_t i = 0; i < batch; i++)
+        {
+            std::size_t size = function();
+            doNotOptimize(size);
+            bytes += size;
+        }
+        result.iterations += batch;
+        now = Clock::now();
+    } while (now < end);
+    AllocationCount allocEnd = getThreadAllocations();
+
+    double iterations = (double)result.iterations;
+    result.nanoseconds = std::chrono::duration<double, std::nano>(now - start).count() / iterations;
+    result.allocations = (double)(allocEnd.allocations - allocStart.allocations) / iterations;
+    result.allocatedBytes = (double)(allocEnd.bytes - allocStart.bytes) / iterations;
+    result.bytes = (double)bytes / iterations;
+    return result;
+}
+
+/// @brief the results of one benchmark run
+/// @note printed as a table and optionally written as json so results can be compared between versions
+class Report
+{
+public:
+    Report(const std::string& benchmark);
+
+    void setConfig(const std::string& name, const std::string& value);
+    void setConfig(const std::string& name, double value);
+    /// @param unit only used when printing
+    void addResult(const std::string& name, double value, const std::string& unit = "");
+    /// @brief starts a new group of results (i.e. one per case in a micro benchmark)
+    void beginCase(const std::string& name);
+
+    void print() const;
+    /// @returns false if the file could not be written
+    bool writeJson(const std::string& path) const;
+
+private:
+    struct Result
+    {
+        std::string name;
+        double value;
+        std::string unit;
+    };
+    struct Case
+    {
+        std::string name;
+        std::vector<Result> results;
+    };
+
+    std::string m_benchmark;
+    std::vector<std::pair<std::string, std::string>> m_config;
+    std::vector<Case> m_cases;
+};
+
+/// @brief a benchmark that can be run from the command line
+struct Command
+{
+    std::string name;
+    std::string description;
+    std::function<int(const Arguments& args, Report& report)> run;
+};
+
+/// @returns every benchmark (each one registers its self in its own file)
+std::vector<Command>& getCommands();
+
+/// @brief registers a command when constructed so benchmarks only have to declare a static instance
+struct RegisterCommand
+{
+    RegisterCommand(const Command& command);
+};
+
+}
+
+#endif
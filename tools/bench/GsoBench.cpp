@@ -0,0 +1,186 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+#include "Networking/Server.hpp"
+#include "Networking/Client.hpp"
+
+#include "Bench.hpp"
+
+using namespace std::chrono_literals;
+
+// a server sends snapshots made of equal sized datagrams to one client over loopback
+// first with sendTo for every datagram and no offload, then with sendBatchTo and UDP_SEGMENT/UDP_GRO
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::size_t size;
+    std::size_t segments;
+    std::uint64_t snapshots;
+    udp::PORT port;
+    /// @brief snapshots that can be in flight before the sender waits for the client
+    std::uint64_t window;
+};
+
+struct Result
+{
+    std::uint64_t sent = 0;
+    std::uint64_t received = 0;
+    double sendTime = 0;
+    double elapsed = 0;
+    double cpu = 0;
+    bool segmentation = false;
+};
+
+template <typename Condition>
+bool waitFor(Condition condition, std::chrono::milliseconds timeout)
+{
+    auto end = Clock::now() + timeout;
+    while (!condition())
+    {
+        if (Clock::now() > end)
+            return false;
+        std::this_thread::sleep_for(5ms);
+    }
+    return true;
+}
+
+/// @returns false if the client could not connect
+bool runPhase(const Options& options, udp::PORT port, bool batched, Result& result)
+{
+    udp::Server server(port);
+    udp::Client client(sf::IpAddress::LocalHost, port);
+    udp::SocketBufferSizes buffers{.receive = 8 << 20, .send = 4 << 20, .force = true};
+    for (udp::Socket* socket: {(udp::Socket*)&server, (udp::Socket*)&client})
+    {
+        socket->setMessageQueueEnabled();
+        socket->setMessageQueueCapacity(1 << 16);
+        socket->setSendQueueCapacity(1 << 16);
+        socket->setBufferSizes(buffers);
+        socket->setSegmentationOffloadEnabled(batched);
+    }
+
+    if (!server.tryOpenConnection())
+    {
+        std::cerr << "could not open the server on port " << port << "\n";
+        return false;
+    }
+    client.tryOpenConnection();
+    if (!waitFor([&](){ return server.getClientsSize() == 1 && client.isConnectionOpen(); }, 5000ms))
+    {
+        std::cerr << "the client did not connect\n";
+        return false;
+    }
+    udp::ID id = (*server.getClients().begin())->id;
+
+    std::atomic<bool> stop = false;
+    std::atomic<std::uint64_t> received = 0;
+    std::thread receiveThread([&](){
+        std::vector<udp::Message> messages(1024);
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            std::size_t count = client.poll(messages);
+            if (count == 0)
+                std::this_thread::yield();
+            received.fetch_add(count, std::memory_order_relaxed);
+        }
+    });
+
+    std::vector<sf::Packet> snapshot(options.segments);
+    for (std::uint32_t i = 0; i < snapshot.size(); i++)
+    {
+        snapshot[i] = udp::Socket::DataPacketTemplate();
+        snapshot[i] << i;
+        std::vector<std::uint8_t> padding(options.size - std::min(options.size, snapshot[i].getDataSize()), 0xAB);
+        snapshot[i].append(padding.data(), padding.size());
+    }
+
+    double cpuStart = bench::getProcessCPUTime();
+    auto start = Clock::now();
+    Clock::duration sendTime{};
+    const std::uint64_t window = options.window * options.segments;
+    for (std::uint64_t i = 0; i < options.snapshots; i++)
+    {
+        // keeping the client close behind so the benchmark measures sending and not the receive buffer overflowing
+        auto waitEnd = Clock::now() + 100ms;
+        while (result.sent > received.load(std::memory_order_relaxed) + window && Clock::now() < waitEnd)
+            std::this_thread::yield();
+
+        auto sendStart = Clock::now();
+        if (batched)
+            server.sendBatchTo(snapshot, id);
+        else
+        {
+            for (sf::Packet& packet: snapshot)
+                server.sendTo(packet, id);
+        }
+        sendTime += Clock::now() - sendStart;
+        result.sent += snapshot.size();
+    }
+    waitFor([&](){ return received.load() >= result.sent; }, 250ms);
+
+    result.elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    result.cpu = bench::getProcessCPUTime() - cpuStart;
+    result.sendTime = std::chrono::duration<double>(sendTime).count();
+    result.received = received.load();
+    if (auto* transport = dynamic_cast<udp::UdpTransport*>(&server.getTransport()))
+        result.segmentation = batched && transport->isSegmentationSupported();
+
+    stop = true;
+    receiveThread.join();
+    // closing the server first so it is not removing the client while its update thread is still using it
+    server.closeConnection();
+    client.closeConnection();
+    return true;
+}
+
+void addResults(bench::Report& report, const std::string& name, const Result& result)
+{
+    report.addResult(name + "_received", (double)result.received, "packets");
+    report.addResult(name + "_loss", result.sent == 0 ? 0.0 : 100.0 * (double)(result.sent - std::min(result.sent, result.received)) / (double)result.sent, "%");
+    report.addResult(name + "_packets_per_second", (double)result.received / result.elapsed, "packets/s");
+    report.addResult(name + "_send_per_packet", result.sent == 0 ? 0.0 : result.sendTime * 1e9 / (double)result.sent, "ns");
+    report.addResult(name + "_cpu_per_packet", result.received == 0 ? 0.0 : result.cpu * 1e9 / (double)result.received, "ns");
+}
+
+int runGso(const bench::Arguments& args, bench::Report& report)
+{
+    Options options;
+    options.size = (std::size_t)std::clamp<std::int64_t>(args.getInt("size", 1200), udp::PACKET_HEADER_SIZE + sizeof(std::uint32_t), 8192);
+    options.segments = (std::size_t)std::clamp<std::int64_t>(args.getInt("segments", 32), 1, (std::int64_t)udp::UdpTransport::MAX_SEGMENTS);
+    options.snapshots = (std::uint64_t)std::max<std::int64_t>(args.getInt("snapshots", 20000), 1);
+    options.port = (udp::PORT)args.getInt("port", 47200);
+    options.window = (std::uint64_t)std::max<std::int64_t>(args.getInt("window", 8), 1);
+
+    report.setConfig("datagram_bytes", (double)options.size);
+    report.setConfig("segments", (double)options.segments);
+    report.setConfig("snapshots", (double)options.snapshots);
+    report.setConfig("window", (double)options.window);
+
+    Result perDatagram, batched;
+    if (!runPhase(options, options.port, false, perDatagram) || !runPhase(options, options.port + 1, true, batched))
+        return 1;
+    report.setConfig("segmentation", batched.segmentation ? "UDP_SEGMENT" : "fallback");
+
+    report.addResult("sent", (double)perDatagram.sent, "packets");
+    addResults(report, "per_datagram", perDatagram);
+    addResults(report, "batched", batched);
+    report.addResult("speedup", perDatagram.sendTime == 0 || batched.sendTime == 0 ? 0.0 : perDatagram.sendTime / batched.sendTime, "x");
+    return 0;
+}
+
+bench::RegisterCommand gso({"gso",
+    "snapshots of equal sized datagrams sent with sendTo vs sendBatchTo (UDP_SEGMENT/UDP_GRO) over loopback (--size 1200 --segments 32 --snapshots 20000 --window 8 --port 47200)",
+    runGso});
+
+}
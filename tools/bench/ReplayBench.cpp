@@ -0,0 +1,120 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "Networking/Server.hpp"
+#include "Networking/MemoryTransport.hpp"
+#include "Networking/TrafficReplay.hpp"
+
+#include "Bench.hpp"
+
+using namespace std::chrono_literals;
+
+// replays a recorded log of received packets into a server without any system sockets
+// logs are recorded with a PacketCapture in the replay format (i.e. loadgen --server --record <file>)
+
+namespace
+{
+
+int runReplay(const bench::Arguments& args, bench::Report& report)
+{
+    std::string path = args.getString("file", "");
+    if (path.empty())
+    {
+        std::cerr << "--file <replay log> is required\n";
+        return 1;
+    }
+    float speed = (float)args.getDouble("speed", 0.0);
+    int repeat = (int)std::max<std::int64_t>(args.getInt("repeat", 1), 1);
+    udp::PORT port = (udp::PORT)args.getInt("port", 47100);
+
+    udp::TrafficReplay replay;
+    if (!replay.load(path))
+    {
+        std::cerr << "could not read the replay log " << path << "\n";
+        return 1;
+    }
+
+    report.setConfig("file", path);
+    report.setConfig("speed", speed > 0.f ? std::to_string(speed) : "flat out");
+    report.setConfig("repeat", repeat);
+    report.setConfig("log_packets", (double)replay.getPacketCount());
+    report.setConfig("log_seconds", replay.getDuration());
+    report.setConfig("log_started", (double)replay.getStartTime() / 1e9);
+
+    std::size_t queueCapacity = 1 << 16;
+    udp::Server server(port);
+    // anything the server sends back goes nowhere since nothing else is bound in the memory network
+    server.setTransport(std::make_unique<udp::MemoryTransport>(sf::IpAddress::LocalHost, queueCapacity));
+    server.setMessageQueueEnabled();
+    server.setMessageQueueCapacity(queueCapacity);
+    if (!server.tryOpenConnection())
+    {
+        std::cerr << "could not open the server\n";
+        return 1;
+    }
+
+    std::atomic<bool> stop = false;
+    std::atomic<std::uint64_t> polled = 0;
+    std::thread drainThread([&](){
+        std::vector<udp::Message> messages(256);
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            std::size_t count = server.poll(messages);
+            polled.fetch_add(count, std::memory_order_relaxed);
+            if (count == 0)
+                std::this_thread::yield();
+        }
+    });
+
+    udp::ReplayStats total;
+    double cpuStart = bench::getProcessCPUTime();
+    for (int i = 0; i < repeat; i++)
+    {
+        udp::ReplayStats stats = replay.replay(server, speed);
+        total.packets += stats.packets;
+        total.bytes += stats.bytes;
+        total.duration += stats.duration;
+        total.maxLag = std::max(total.maxLag, stats.maxLag);
+        // every run starts with no clients so the connection requests in the log are handled the same way each time
+        server.disconnectAllClients();
+    }
+    double cpu = bench::getProcessCPUTime() - cpuStart;
+
+    std::this_thread::sleep_for(50ms);
+    stop = true;
+    drainThread.join();
+
+    udp::HistogramSnapshot data = server.getHandlerHistogram(udp::PacketType::Data);
+    udp::HistogramSnapshot handlers = server.getHandlerHistogram();
+    udp::HistogramSnapshot latency = server.getReceiveLatencyHistogram();
+    udp::MetricsSnapshot metrics = server.getMetrics();
+    server.closeConnection();
+
+    report.addResult("packets", (double)total.packets, "packets");
+    report.addResult("packets_per_second", total.duration > 0 ? (double)total.packets / total.duration : 0.0, "packets/s");
+    report.addResult("bytes_per_second", total.duration > 0 ? (double)total.bytes / total.duration : 0.0, "bytes/s");
+    report.addResult("cpu_per_packet", total.packets == 0 ? 0.0 : cpu * 1e9 / (double)total.packets, "ns");
+    report.addResult("max_lag", total.maxLag * 1e6, "us");
+    report.addResult("data_polled", (double)polled.load(), "packets");
+    report.addResult("queue_full_drops", (double)metrics.drops[(std::size_t)udp::DropReason::QueueFull], "packets");
+    report.addResult("not_connected_drops", (double)metrics.drops[(std::size_t)udp::DropReason::NotConnected], "packets");
+    report.addResult("connections_opened", (double)metrics.connectionsOpened, "clients");
+    report.addResult("data_handler_p50", data.getPercentile(50) * 1e9, "ns");
+    report.addResult("data_handler_p99", data.getPercentile(99) * 1e9, "ns");
+    report.addResult("data_handler_p999", data.getPercentile(99.9) * 1e9, "ns");
+    report.addResult("handler_p99", handlers.getPercentile(99) * 1e9, "ns");
+    report.addResult("receive_to_poll_p50", latency.getPercentile(50) * 1e6, "us");
+    report.addResult("receive_to_poll_p99", latency.getPercentile(99) * 1e6, "us");
+    return 0;
+}
+
+bench::RegisterCommand replayCommand({"replay",
+    "replays a recorded log of received packets into a server without sockets (--file <log> --speed 0 (flat out) | 1 (original) --repeat 1 --port 47100)",
+    runReplay});
+
+}
@@ -0,0 +1,173 @@
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "Networking/Socket.hpp"
+
+#include "Bench.hpp"
+
+// per operation cost of building and reading packets
+// every case returns the number of bytes it wrote or read so bytes/op shows the wire size
+
+namespace
+{
+
+struct Case
+{
+    std::string name;
+    std::function<std::size_t()> function;
+};
+
+/// @returns a packet with the read position moved past the packet type (like a received packet)
+sf::Packet received(const sf::Packet& packet)
+{
+    sf::Packet out;
+    out.append(packet.getData(), packet.getDataSize());
+    std::int8_t type;
+    out >> type;
+    return out;
+}
+
+std::vector<Case> makeCases(std::size_t nestedSize, std::size_t stringSize)
+{
+    std::vector<Case> cases;
+    std::string shortReason = "Timedout";
+    std::string longReason(stringSize, 'r');
+
+    //* sf::Packet streaming
+
+        cases.push_back({"packet/write_primitives", [](){
+            sf::Packet packet;
+            packet << (std::int8_t)1 << (std::int32_t)2 << (std::int64_t)3 << 4.f << 5.0;
+            return packet.getDataSize();
+        }});
+
+        sf::Packet primitives;
+        primitives << (std::int8_t)1 << (std::int32_t)2 << (std::int64_t)3 << 4.f << 5.0;
+        cases.push_back({"packet/read_primitives", [primitives](){
+            sf::Packet packet = primitives;
+            std::int8_t a; std::int32_t b; std::int64_t c; float d; double e;
+            packet >> a >> b >> c >> d >> e;
+            return packet.getDataSize();
+        }});
+
+        cases.push_back({"packet/write_string", [longReason](){
+            sf::Packet packet;
+            packet << longReason;
+            return packet.getDataSize();
+        }});
+
+        sf::Packet stringPacket;
+        stringPacket << longReason;
+        cases.push_back({"packet/read_string", [stringPacket](){
+            sf::Packet packet = stringPacket;
+            std::string str;
+            packet >> str;
+            return str.size() + sizeof(std::uint32_t);
+        }});
+
+        cases.push_back({"packet/copy", [stringPacket](){
+            sf::Packet packet = stringPacket;
+            return packet.getDataSize();
+        }});
+
+    // ----------------------
+
+    //* Nested packets (operator<< and operator>> from Socket.hpp)
+
+        sf::Packet inner;
+        inner.append(std::vector<std::uint8_t>(nestedSize, 7).data(), nestedSize);
+
+        cases.push_back({"nested/write", [inner](){
+            sf::Packet packet;
+            packet << inner;
+            return packet.getDataSize();
+        }});
+
+        sf::Packet nested;
+        nested << inner;
+        cases.push_back({"nested/read", [nested](){
+            sf::Packet packet = nested;
+            sf::Packet out;
+            packet >> out;
+            return packet.getDataSize();
+        }});
+
+    // ----------------------
+
+    //* Socket templates and packets
+
+        cases.push_back({"template/connection_close_short", [shortReason](){ return udp::Socket::ConnectionCloseTemplate(shortReason).getDataSize(); }});
+        cases.push_back({"template/connection_close_long", [longReason](){ return udp::Socket::ConnectionCloseTemplate(longReason).getDataSize(); }});
+        cases.push_back({"template/connection_request", [](){ return udp::Socket::ConnectionRequestTemplate().getDataSize(); }});
+        cases.push_back({"template/data", [](){ return udp::Socket::DataPacketTemplate().getDataSize(); }});
+        cases.push_back({"packet/connection_confirm", [](){ return udp::Socket::ConnectionConfirmPacket(1, sf::IpAddress::LocalHost, 0x0123456789ABCDEF).getDataSize(); }});
+        cases.push_back({"packet/password_request", [](){ return udp::Socket::PasswordRequestPacket().getDataSize(); }});
+        cases.push_back({"packet/password", [](){ return udp::Socket::PasswordPacket("password123").getDataSize(); }});
+        cases.push_back({"packet/request", [](){ return udp::Socket::RequestPacket(12345).getDataSize(); }});
+        cases.push_back({"packet/response", [](){ return udp::Socket::ResponsePacket(12345).getDataSize(); }});
+        cases.push_back({"packet/ping", [](){ return udp::Socket::PingPacket(123456789).getDataSize(); }});
+        cases.push_back({"packet/pong", [](){ return udp::Socket::PongPacket(123456789, 123456999).getDataSize(); }});
+        cases.push_back({"packet/shared_memory_offer", [](){ return udp::Socket::SharedMemoryOfferPacket(1234, 5, 6).getDataSize(); }});
+        cases.push_back({"packet/shared_memory_accept", [](){ return udp::Socket::SharedMemoryAcceptPacket(1234, 6).getDataSize(); }});
+        cases.push_back({"packet/path_challenge", [](){ return udp::Socket::PathChallengePacket(0x0123456789ABCDEF).getDataSize(); }});
+        cases.push_back({"packet/path_response", [](){ return udp::Socket::PathResponsePacket(0x0123456789ABCDEF, 0xFEDCBA9876543210).getDataSize(); }});
+
+    // ----------------------
+
+    //* Parsing close reasons (what m_parse_connection_close does)
+
+        for (auto& [name, reason]: {std::pair{"short", shortReason}, std::pair{"long", longReason}})
+        {
+            sf::Packet closePacket = received(udp::Socket::ConnectionCloseTemplate(reason));
+            cases.push_back({std::string("parse/connection_close_") + name, [closePacket](){
+                sf::Packet packet = closePacket;
+                std::string reason;
+                if (packet.endOfPacket())
+                    reason = "Unknown";
+                else
+                    packet >> reason;
+                return reason.size() + sizeof(std::uint32_t);
+            }});
+        }
+
+    // ----------------------
+
+    return cases;
+}
+
+int runSerialization(const bench::Arguments& args, bench::Report& report)
+{
+    double minTime = args.getDouble("time", 0.2);
+    std::string filter = args.getString("filter", "");
+    std::size_t nestedSize = (std::size_t)args.getInt("nested-size", 256);
+    std::size_t stringSize = (std::size_t)args.getInt("string-size", 200);
+
+    report.setConfig("time_per_case", minTime);
+    report.setConfig("nested_size", (double)nestedSize);
+    report.setConfig("string_size", (double)stringSize);
+    if (!filter.empty())
+        report.setConfig("filter", filter);
+
+    for (auto& benchCase: makeCases(nestedSize, stringSize))
+    {
+        if (!filter.empty() && benchCase.name.find(filter) == std::string::npos)
+            continue;
+
+        // cases that read copy their input first so that copy is included in the result
+        bench::MicroResult result = bench::measure(benchCase.function, minTime);
+        report.beginCase(benchCase.name);
+        report.addResult("ns_per_op", result.nanoseconds, "ns/op");
+        report.addResult("allocs_per_op", result.allocations, "allocs/op");
+        report.addResult("alloc_bytes_per_op", result.allocatedBytes, "B alloc/op");
+        report.addResult("bytes_per_op", result.bytes, "B/op");
+        report.addResult("iterations", (double)result.iterations);
+    }
+    return 0;
+}
+
+bench::RegisterCommand serialization({"serialization", 
+    "per operation cost of packet streaming, nested packets and the Socket packet templates (--time 0.2 --filter <text> --nested-size 256 --string-size 200)", 
+    runSerialization});
+
+}
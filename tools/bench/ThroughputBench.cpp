@@ -0,0 +1,311 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "Networking/Server.hpp"
+#include "Networking/Client.hpp"
+#include "Networking/MemoryTransport.hpp"
+
+#include "Bench.hpp"
+
+using namespace std::chrono_literals;
+
+// drives N clients against one server and measures delivered packets and one way latency
+// in "up" mode every client sends to the server, in "broadcast" mode the server uses sendToAll
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/// @brief sendTime (int64) + sequence (uint32) + sender index (uint32)
+constexpr std::size_t HEADER_SIZE = sizeof(std::int64_t) + sizeof(std::uint32_t) * 2;
+
+struct Options
+{
+    std::uint32_t clients;
+    double duration;
+    std::size_t size;
+    double rate;
+    udp::PORT port;
+    bool memory;
+    bool broadcast;
+    bool timestamps;
+};
+
+/// @brief what one receiving thread saw
+struct Receiver
+{
+    bench::LatencyRecorder latency;
+    std::uint64_t packets = 0;
+    std::uint64_t bytes = 0;
+    /// @brief when the last benchmark packet was handled
+    Clock::time_point lastReceive{};
+};
+
+sf::Packet makePacket(std::uint32_t sequence, std::uint32_t sender, const std::vector<std::uint8_t>& padding)
+{
+    sf::Packet packet = udp::Socket::DataPacketTemplate();
+    packet << udp::Socket::getClockTime() << sequence << sender;
+    if (!padding.empty())
+        packet.append(padding.data(), padding.size());
+    return packet;
+}
+
+/// @brief polls the socket until stop is set and records every benchmark packet
+void receive(udp::Socket& socket, Receiver& receiver, const std::atomic<bool>& stop)
+{
+    std::vector<udp::Message> messages(256);
+    int idlePolls = 0;
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        std::size_t count = socket.poll(messages);
+        if (count == 0)
+        {
+            // spinning for a short time keeps the latency low without burning a core while idle
+            if (++idlePolls < 1000)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(50us);
+            continue;
+        }
+        idlePolls = 0;
+
+        std::int64_t now = udp::Socket::getClockTime();
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::int64_t sendTime;
+            std::uint32_t sequence, sender;
+            if (!(messages[i].packet >> sendTime >> sequence >> sender))
+                continue;
+            receiver.latency.add(now - sendTime);
+            receiver.packets++;
+            receiver.bytes += messages[i].packet.getDataSize();
+        }
+        receiver.lastReceive = Clock::now();
+    }
+}
+
+/// @brief calls send at the given rate until the duration is over
+/// @returns the number of packets sent
+template <typename SendFunction>
+std::uint64_t sendLoop(const Options& options, std::uint32_t sender, const std::vector<std::uint8_t>& padding, SendFunction send)
+{
+    auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+    auto interval = options.rate > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.rate)) : Clock::duration::zero();
+    auto next = Clock::now();
+    std::uint32_t sequence = 0;
+
+    while (Clock::now() < end)
+    {
+        if (options.rate > 0)
+        {
+            if (Clock::now() < next)
+            {
+                std::this_thread::sleep_until(next);
+                continue;
+            }
+            next += interval;
+        }
+        sf::Packet packet = makePacket(sequence++, sender, padding);
+        send(packet);
+    }
+    return sequence;
+}
+
+template <typename Condition>
+bool waitFor(Condition condition, std::chrono::milliseconds timeout)
+{
+    auto end = Clock::now() + timeout;
+    while (!condition())
+    {
+        if (Clock::now() > end)
+            return false;
+        std::this_thread::sleep_for(5ms);
+    }
+    return true;
+}
+
+int runThroughput(const bench::Arguments& args, bench::Report& report)
+{
+    Options options;
+    options.clients = (std::uint32_t)std::clamp<std::int64_t>(args.getInt("clients", 8), 1, 250);
+    options.duration = args.getDouble("duration", 5.0);
+    options.size = (std::size_t)std::max<std::int64_t>(args.getInt("size", 64), 0);
+    options.rate = args.getDouble("rate", 10000.0);
+    options.port = (udp::PORT)args.getInt("port", 47000);
+    options.memory = args.has("memory");
+    options.broadcast = args.getString("mode", "up") == "broadcast";
+    options.timestamps = args.has("timestamps");
+
+    report.setConfig("mode", options.broadcast ? "broadcast" : "up");
+    report.setConfig("transport", options.memory ? "memory" : "udp");
+    report.setConfig("clients", options.clients);
+    report.setConfig("duration", options.duration);
+    report.setConfig("payload_bytes", (double)std::max(options.size, HEADER_SIZE));
+    report.setConfig("rate_per_sender", options.rate);
+    report.setConfig("timestamps", options.timestamps ? "kernel" : "off");
+
+    std::vector<std::uint8_t> padding(options.size > HEADER_SIZE ? options.size - HEADER_SIZE : 0, 0xAB);
+    std::size_t queueCapacity = 1 << 16;
+
+    udp::Server server(options.port);
+    server.setMessageQueueEnabled();
+    server.setMessageQueueCapacity(queueCapacity);
+    server.setKernelTimestampsEnabled(options.timestamps);
+    if (options.memory)
+        server.setTransport(std::make_unique<udp::MemoryTransport>(sf::IpAddress::LocalHost, queueCapacity));
+
+    std::vector<std::unique_ptr<udp::Client>> clients;
+    for (std::uint32_t i = 0; i < options.clients; i++)
+    {
+        auto client = std::make_unique<udp::Client>(sf::IpAddress::LocalHost, options.port);
+        client->setMessageQueueEnabled();
+        client->setMessageQueueCapacity(queueCapacity);
+        client->setKernelTimestampsEnabled(options.timestamps);
+        // the server tells clients apart by connection ID, each client still gets its own loopback address so the traffic comes from separate hosts
+        if (options.memory)
+            client->setTransport(std::make_unique<udp::MemoryTransport>(std::nullopt, queueCapacity));
+        else
+            client->setTransport(std::make_unique<udp::UdpTransport>(sf::IpAddress(127, 0, 0, (std::uint8_t)(2 + i))));
+        clients.push_back(std::move(client));
+    }
+
+    if (!server.tryOpenConnection())
+    {
+        std::cerr << "could not open the server on port " << options.port << "\n";
+        return 1;
+    }
+    for (auto& client: clients)
+        client->tryOpenConnection();
+
+    bool connected = waitFor([&](){
+        return server.getClientsSize() == options.clients && 
+               std::all_of(clients.begin(), clients.end(), [](const auto& client){ return client->isConnectionOpen(); });
+    }, 5000ms);
+    if (!connected)
+    {
+        std::cerr << "only " << server.getClientsSize() << " of " << options.clients << " clients connected\n";
+        return 1;
+    }
+
+    std::atomic<bool> stop = false;
+    std::vector<Receiver> receivers(options.broadcast ? options.clients : 1);
+    std::vector<std::thread> receiveThreads;
+    if (options.broadcast)
+    {
+        for (std::uint32_t i = 0; i < options.clients; i++)
+            receiveThreads.emplace_back(receive, std::ref(*clients[i]), std::ref(receivers[i]), std::cref(stop));
+    }
+    else
+        receiveThreads.emplace_back(receive, std::ref(server), std::ref(receivers[0]), std::cref(stop));
+
+    double cpuStart = bench::getProcessCPUTime();
+    auto start = Clock::now();
+
+    std::vector<std::uint64_t> sent(options.broadcast ? 1 : options.clients, 0);
+    std::vector<std::thread> sendThreads;
+    if (options.broadcast)
+    {
+        sendThreads.emplace_back([&](){
+            sent[0] = sendLoop(options, 0, padding, [&server](sf::Packet& packet){ server.sendToAll(packet); });
+        });
+    }
+    else
+    {
+        for (std::uint32_t i = 0; i < options.clients; i++)
+        {
+            sendThreads.emplace_back([&, i](){
+                sent[i] = sendLoop(options, i, padding, [&client = *clients[i]](sf::Packet& packet){ client.sendToServer(packet); });
+            });
+        }
+    }
+    for (auto& thread: sendThreads)
+        thread.join();
+    auto sendEnd = Clock::now();
+
+    // giving packets that are still in flight time to arrive, this is not part of the measured time
+    std::this_thread::sleep_for(250ms);
+    stop = true;
+    for (auto& thread: receiveThreads)
+        thread.join();
+
+    // the measured time ends when sending is done or when the last packet in flight was handled, whichever is later
+    auto end = sendEnd;
+    for (auto& receiver: receivers)
+        end = std::max(end, receiver.lastReceive);
+    double elapsed = std::chrono::duration<double>(end - start).count();
+    double cpu = bench::getProcessCPUTime() - cpuStart;
+
+    // sends that found the send buffer full and were queued (or dropped) instead
+    std::uint64_t wouldBlock = 0;
+    std::uint64_t queueDrops = 0;
+    // time from the kernel getting each packet to the receive thread handling it (only with --timestamps)
+    udp::HistogramSnapshot receiveDelay;
+    if (options.broadcast)
+    {
+        udp::MetricsSnapshot metrics = server.getMetrics();
+        wouldBlock = metrics.sendWouldBlock;
+        queueDrops = metrics.sendQueueDrops;
+        for (auto& client: clients)
+            receiveDelay.merge(client->getReceiveDelayHistogram());
+    }
+    else
+    {
+        for (auto& client: clients)
+        {
+            udp::MetricsSnapshot metrics = client->getMetrics();
+            wouldBlock += metrics.sendWouldBlock;
+            queueDrops += metrics.sendQueueDrops;
+        }
+        receiveDelay = server.getReceiveDelayHistogram();
+    }
+
+    // closing the server first so it is not removing clients while its update thread is still using them
+    server.closeConnection();
+    for (auto& client: clients)
+        client->closeConnection();
+
+    Receiver total;
+    for (auto& receiver: receivers)
+    {
+        total.latency.merge(receiver.latency);
+        total.packets += receiver.packets;
+        total.bytes += receiver.bytes;
+    }
+    std::uint64_t expected = 0;
+    for (auto count: sent)
+        expected += count;
+    if (options.broadcast)
+        expected *= options.clients;
+
+    report.addResult("sent", (double)expected, "packets");
+    report.addResult("received", (double)total.packets, "packets");
+    report.addResult("loss", expected == 0 ? 0.0 : 100.0 * (double)(expected - std::min(expected, total.packets)) / (double)expected, "%");
+    report.addResult("packets_per_second", (double)total.packets / elapsed, "packets/s");
+    report.addResult("bytes_per_second", (double)total.bytes / elapsed, "bytes/s");
+    report.addResult("latency_avg", total.latency.getAverage(), "us");
+    report.addResult("latency_p50", total.latency.getPercentile(50), "us");
+    report.addResult("latency_p99", total.latency.getPercentile(99), "us");
+    report.addResult("latency_p999", total.latency.getPercentile(99.9), "us");
+    report.addResult("latency_max", total.latency.getPercentile(100), "us");
+    report.addResult("cpu_per_packet", total.packets == 0 ? 0.0 : cpu * 1e9 / (double)total.packets, "ns");
+    report.addResult("send_would_block", (double)wouldBlock, "packets");
+    report.addResult("send_queue_drops", (double)queueDrops, "packets");
+    if (options.timestamps)
+    {
+        report.addResult("receive_delay_p50", receiveDelay.getPercentile(50) * 1e6, "us");
+        report.addResult("receive_delay_p99", receiveDelay.getPercentile(99) * 1e6, "us");
+    }
+    return 0;
+}
+
+bench::RegisterCommand throughput({"throughput", 
+    "N clients against a server over loopback (--clients 8 --duration 5 --size 64 --rate 10000 --port 47000 --mode up|broadcast --memory --timestamps)", 
+    runThroughput});
+
+}
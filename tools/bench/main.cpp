@@ -0,0 +1,49 @@
+#include <iostream>
+#include <algorithm>
+
+#include "Bench.hpp"
+
+void printUsage()
+{
+    std::cout << "usage: bench <benchmark> [--option value]... [--json <file>]\n\nbenchmarks:\n";
+    auto commands = bench::getCommands();
+    std::sort(commands.begin(), commands.end(), [](const bench::Command& a, const bench::Command& b){ return a.name < b.name; });
+    for (auto& command: commands)
+        std::cout << "  " << command.name << "\n      " << command.description << "\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || std::string(argv[1]) == "--help" || std::string(argv[1]) == "help")
+    {
+        printUsage();
+        return argc < 2 ? 1 : 0;
+    }
+
+    std::string name = argv[1];
+    auto& commands = bench::getCommands();
+    auto command = std::find_if(commands.begin(), commands.end(), [&name](const bench::Command& c){ return c.name == name; });
+    if (command == commands.end())
+    {
+        std::cerr << "unknown benchmark '" << name << "'\n";
+        printUsage();
+        return 1;
+    }
+
+    bench::Arguments args(argc, argv, 2);
+    bench::Report report(command->name);
+    int result = command->run(args, report);
+    report.print();
+
+    if (args.has("json"))
+    {
+        std::string path = args.getString("json", command->name + ".json");
+        if (!report.writeJson(path))
+        {
+            std::cerr << "could not write " << path << "\n";
+            return 1;
+        }
+        std::cout << "results written to " << path << "\n";
+    }
+    return result;
+}
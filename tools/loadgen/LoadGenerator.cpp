@@ -0,0 +1,704 @@
+#include "LoadGenerator.hpp"
+
+#include <queue>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+
+#include "Networking/Socket.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+using namespace loadgen;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/// @brief 127.1.0.1 (keeps clear of 127.0.0.x which servers and other tools use)
+constexpr std::uint32_t FIRST_CLIENT_ADDRESS = 0x7F010001;
+constexpr std::uint32_t MAX_CLIENTS = 1 << 20;
+/// @brief how often a connection request is sent again while waiting for a confirmation
+constexpr auto CONNECT_RETRY = std::chrono::milliseconds(250);
+/// @brief the most packets a client sends at once when it has fallen behind its rate
+constexpr std::uint32_t MAX_BURST = 16;
+
+Clock::duration toDuration(double seconds)
+{
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+std::vector<std::string> split(const std::string& str, char delimiter)
+{
+    std::vector<std::string> parts;
+    std::stringstream stream(str);
+    std::string part;
+    while (std::getline(stream, part, delimiter))
+    {
+        part.erase(0, part.find_first_not_of(" \t"));
+        part.erase(part.find_last_not_of(" \t") + 1);
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+}
+
+//* Script
+
+std::optional<std::vector<ScriptStep>> loadgen::parseScript(const std::string& script, std::uint32_t defaultSize, double defaultRate, std::string& error)
+{
+    std::vector<ScriptStep> steps;
+    bool canBlock = false;
+    for (const std::string& text: split(script, ';'))
+    {
+        if (text.empty())
+            continue;
+
+        std::size_t colon = text.find(':');
+        std::string name = text.substr(0, colon);
+        std::vector<std::string> args = colon == std::string::npos ? std::vector<std::string>{} : split(text.substr(colon + 1), ',');
+
+        ScriptStep step;
+        try
+        {
+            if (name == "connect")
+                step.type = ScriptStep::Type::Connect;
+            else if (name == "password" && args.size() == 1)
+            {
+                step.type = ScriptStep::Type::Password;
+                step.text = args[0];
+            }
+            else if (name == "send" && args.size() >= 1 && args.size() <= 3)
+            {
+                step.type = ScriptStep::Type::Send;
+                step.count = (std::uint32_t)std::stoul(args[0]);
+                step.size = args.size() > 1 ? (std::uint32_t)std::stoul(args[1]) : defaultSize;
+                step.rate = args.size() > 2 ? std::stod(args[2]) : defaultRate;
+                canBlock = true;
+            }
+            else if (name == "wait" && args.size() == 1)
+            {
+                step.type = ScriptStep::Type::Wait;
+                step.seconds = std::stod(args[0]);
+                canBlock = true;
+            }
+            else if (name == "disconnect")
+            {
+                step.type = ScriptStep::Type::Disconnect;
+                step.text = args.empty() ? "Load generator disconnect" : args[0];
+            }
+            else if (name == "loop")
+                step.type = ScriptStep::Type::Loop;
+            else
+            {
+                error = "unknown or invalid step '" + text + "'";
+                return std::nullopt;
+            }
+        }
+        catch (const std::exception&)
+        {
+            error = "invalid number in step '" + text + "'";
+            return std::nullopt;
+        }
+        steps.push_back(step);
+    }
+
+    if (steps.empty())
+    {
+        error = "the script is empty";
+        return std::nullopt;
+    }
+    if (steps.back().type == ScriptStep::Type::Loop && !canBlock)
+    {
+        error = "a script that loops needs a send or wait step";
+        return std::nullopt;
+    }
+    return steps;
+}
+
+// ------
+
+//* Worker
+
+namespace
+{
+
+struct VirtualClient
+{
+    enum class State
+    {
+        Idle,
+        Connecting,
+        Connected
+    };
+
+    std::uint32_t address = 0;
+    /// @brief the connection ID the server gave this client (0 until connected)
+    std::uint32_t connectionID = 0;
+    State state = State::Idle;
+    /// @brief the current script step
+    std::size_t step = 0;
+    /// @brief packets left in the current send step
+    std::uint32_t remaining = 0;
+    Clock::time_point nextSend;
+    Clock::time_point waitUntil;
+    Clock::time_point connectStart;
+    /// @brief timers made before the last schedule are ignored
+    std::uint32_t generation = 0;
+    std::uint32_t sequence = 0;
+    const std::string* password = nullptr;
+};
+
+struct Timer
+{
+    Clock::time_point time;
+    std::uint32_t client;
+    std::uint32_t generation;
+
+    inline bool operator>(const Timer& other) const
+    {
+        return time > other.time;
+    }
+};
+
+}
+
+struct LoadGenerator::Worker
+{
+    std::uint32_t index = 0;
+    const LoadConfig* config = nullptr;
+    std::atomic<std::uint32_t>* connected = nullptr;
+    int fd = -1;
+    /// @brief the client with index i is clients[i / threads] of worker i % threads
+    std::vector<VirtualClient> clients;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::vector<std::uint8_t> padding;
+    std::vector<std::uint8_t> buffer = std::vector<std::uint8_t>(65536);
+    /// @brief only used by the workers thread until it is stopped
+    LoadStats stats;
+    std::atomic<std::uint64_t> packetsSent = 0;
+    std::atomic<std::uint64_t> packetsReceived = 0;
+
+    ~Worker()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+            ::close(fd);
+#endif
+    }
+
+    void schedule(VirtualClient& client, Clock::time_point time)
+    {
+        client.generation++;
+        timers.push(Timer{time, (std::uint32_t)(&client - clients.data()), client.generation});
+    }
+
+    /// @brief starts the script from the first step at the given time
+    void restart(VirtualClient& client, Clock::time_point time)
+    {
+        client.step = 0;
+        client.remaining = 0;
+        client.waitUntil = {};
+        schedule(client, time);
+    }
+
+    /// @brief runs the script until the client has to wait for something
+    void run(VirtualClient& client, Clock::time_point now);
+    void receive(VirtualClient& client, sf::Packet& packet, Clock::time_point now);
+    void send(VirtualClient& client, const sf::Packet& packet);
+    /// @brief receives every datagram that is waiting
+    void receiveAll(Clock::time_point now);
+    /// @brief tells the server that every connected client has disconnected
+    void disconnectAll();
+};
+
+#ifdef __linux__
+
+void LoadGenerator::Worker::run(VirtualClient& client, Clock::time_point now)
+{
+    // a limit so a script that never blocks still lets the other clients run
+    for (int executed = 0; executed < 64; executed++)
+    {
+        if (client.step >= config->script.size())
+            return; // the script is done so the client only answers pings from now on
+
+        const ScriptStep& step = config->script[client.step];
+        switch (step.type)
+        {
+        case ScriptStep::Type::Connect:
+            if (client.state == VirtualClient::State::Connected)
+            {
+                client.step++;
+                continue;
+            }
+            if (client.state == VirtualClient::State::Idle)
+            {
+                client.state = VirtualClient::State::Connecting;
+                client.connectionID = 0;
+                client.connectStart = now;
+                stats.connectAttempts++;
+            }
+            else if (now - client.connectStart > toDuration(config->connectTimeout))
+            {
+                stats.connectTimeouts++;
+                client.state = VirtualClient::State::Idle;
+                restart(client, now + toDuration(config->reconnectDelay));
+                return;
+            }
+            send(client, udp::Socket::ConnectionRequestTemplate());
+            // the step is finished by the confirmation
+            schedule(client, now + CONNECT_RETRY);
+            return;
+
+        case ScriptStep::Type::Password:
+            client.password = &step.text;
+            client.step++;
+            continue;
+
+        case ScriptStep::Type::Send:
+        {
+            if (client.state != VirtualClient::State::Connected)
+            {
+                client.step++;
+                continue;
+            }
+            bool forever = step.count == 0;
+            if (client.remaining == 0)
+            {
+                client.remaining = forever ? 1 : step.count;
+                client.nextSend = now;
+            }
+
+            auto interval = step.rate > 0 ? toDuration(1.0 / step.rate) : Clock::duration::zero();
+            for (std::uint32_t burst = 0; client.remaining > 0 && client.nextSend <= now && burst < MAX_BURST; burst++)
+            {
+                sf::Packet packet = udp::Socket::DataPacketTemplate();
+                packet << udp::Socket::getClockTime() << client.sequence++;
+                std::size_t headerSize = packet.getDataSize();
+                if (step.size > headerSize)
+                    packet.append(padding.data(), std::min<std::size_t>(step.size - headerSize, padding.size()));
+                send(client, packet);
+
+                if (!forever)
+                    client.remaining--;
+                client.nextSend += interval;
+            }
+            if (client.remaining == 0)
+            {
+                client.step++;
+                continue;
+            }
+            // if the thread has fallen far behind the backlog is dropped instead of sent in bursts
+            if (now - client.nextSend > std::chrono::seconds(1))
+                client.nextSend = now;
+            schedule(client, std::max(client.nextSend, now));
+            return;
+        }
+
+        case ScriptStep::Type::Wait:
+            if (client.waitUntil == Clock::time_point{})
+            {
+                client.waitUntil = now + toDuration(step.seconds);
+                schedule(client, client.waitUntil);
+                return;
+            }
+            if (now < client.waitUntil)
+            {
+                schedule(client, client.waitUntil);
+                return;
+            }
+            client.waitUntil = {};
+            client.step++;
+            continue;
+
+        case ScriptStep::Type::Disconnect:
+            if (client.state == VirtualClient::State::Connected)
+            {
+                send(client, udp::Socket::ConnectionCloseTemplate(step.text));
+                (*connected)--;
+                stats.disconnects++;
+            }
+            client.state = VirtualClient::State::Idle;
+            client.step++;
+            continue;
+
+        case ScriptStep::Type::Loop:
+            client.step = 0;
+            continue;
+        }
+    }
+    schedule(client, now);
+}
+
+void LoadGenerator::Worker::receive(VirtualClient& client, sf::Packet& packet, Clock::time_point now)
+{
+    std::int8_t type;
+    std::uint32_t senderID;
+    if (!(packet >> type >> senderID))
+    {
+        stats.unknownPackets++;
+        return;
+    }
+
+    switch ((udp::PacketType)type)
+    {
+    case udp::PacketType::ConnectionConfirm:
+        if (client.state != VirtualClient::State::Connecting)
+            return; // a late duplicate
+        if (!(packet >> client.connectionID))
+            return;
+        client.state = VirtualClient::State::Connected;
+        (*connected)++;
+        stats.connects++;
+        stats.connectLatencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(now - client.connectStart).count());
+        client.step++;
+        run(client, now);
+        return;
+
+    case udp::PacketType::PasswordRequest:
+        stats.passwordRequests++;
+        if (client.state == VirtualClient::State::Connecting && client.password != nullptr)
+            send(client, udp::Socket::PasswordPacket(*client.password));
+        return;
+
+    case udp::PacketType::Ping:
+    {
+        std::int64_t receiveTime = udp::Socket::getClockTime();
+        std::int64_t sendTime;
+        if (!(packet >> sendTime))
+            return;
+        send(client, udp::Socket::PongPacket(sendTime, receiveTime));
+        stats.pongsSent++;
+        return;
+    }
+
+    case udp::PacketType::ConnectionClose:
+        if (client.state == VirtualClient::State::Idle)
+            return;
+        if (client.state == VirtualClient::State::Connected)
+            (*connected)--;
+        client.state = VirtualClient::State::Idle;
+        stats.serverDisconnects++;
+        restart(client, now + toDuration(config->reconnectDelay));
+        return;
+
+    case udp::PacketType::Data:
+        stats.dataReceived++;
+        return;
+
+    default:
+        return;
+    }
+}
+
+void LoadGenerator::Worker::send(VirtualClient& client, const sf::Packet& packet)
+{
+    sockaddr_in server{};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(config->port);
+    server.sin_addr.s_addr = htonl(config->server.toInteger());
+    // the packet header holds the connection ID of the client (see udp::PACKET_HEADER_SIZE)
+    // the templates leave it as 0 so the header is copied with the ID filled in
+    const std::uint8_t* bytes = (const std::uint8_t*)packet.getData();
+    std::uint8_t packetHeader[udp::PACKET_HEADER_SIZE] = {bytes[0], (std::uint8_t)(client.connectionID >> 24), (std::uint8_t)(client.connectionID >> 16),
+                                                          (std::uint8_t)(client.connectionID >> 8), (std::uint8_t)client.connectionID};
+    iovec data[2] = {{packetHeader, sizeof(packetHeader)},
+                     {const_cast<std::uint8_t*>(bytes) + udp::PACKET_HEADER_SIZE, packet.getDataSize() - udp::PACKET_HEADER_SIZE}};
+
+    // the source address is picked per datagram so one socket can send for every client
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(in_pktinfo))]{};
+    msghdr message{};
+    message.msg_name = &server;
+    message.msg_namelen = sizeof(server);
+    message.msg_iov = data;
+    message.msg_iovlen = 2;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = IPPROTO_IP;
+    header->cmsg_type = IP_PKTINFO;
+    header->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+    in_pktinfo info{};
+    info.ipi_spec_dst.s_addr = htonl(client.address);
+    std::memcpy(CMSG_DATA(header), &info, sizeof(info));
+
+    if (sendmsg(fd, &message, 0) < 0)
+    {
+        stats.sendErrors++;
+        return;
+    }
+    stats.packetsSent++;
+    stats.bytesSent += packet.getDataSize();
+    packetsSent.store(stats.packetsSent, std::memory_order_relaxed);
+}
+
+void LoadGenerator::Worker::receiveAll(Clock::time_point now)
+{
+    const std::uint32_t threads = config->threads;
+    // a limit so timers are not starved when the socket is flooded
+    for (int i = 0; i < 1024; i++)
+    {
+        iovec data{buffer.data(), buffer.size()};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(in_pktinfo))];
+        sockaddr_in sender{};
+        msghdr message{};
+        message.msg_name = &sender;
+        message.msg_namelen = sizeof(sender);
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t size = recvmsg(fd, &message, MSG_DONTWAIT);
+        if (size < 0)
+            return;
+
+        stats.packetsReceived++;
+        stats.bytesReceived += (std::uint64_t)size;
+        packetsReceived.store(stats.packetsReceived, std::memory_order_relaxed);
+
+        // the address the datagram was sent to tells which client it is for
+        std::optional<std::uint32_t> destination;
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header))
+        {
+            if (header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_PKTINFO)
+            {
+                in_pktinfo info;
+                std::memcpy(&info, CMSG_DATA(header), sizeof(info));
+                destination = ntohl(info.ipi_addr.s_addr);
+            }
+        }
+        if (!destination || *destination < FIRST_CLIENT_ADDRESS || ntohl(sender.sin_addr.s_addr) != config->server.toInteger())
+        {
+            stats.unknownPackets++;
+            continue;
+        }
+        std::uint32_t clientIndex = *destination - FIRST_CLIENT_ADDRESS;
+        if (clientIndex % threads != index || clientIndex / threads >= clients.size())
+        {
+            stats.unknownPackets++;
+            continue;
+        }
+
+        sf::Packet packet;
+        packet.append(buffer.data(), (std::size_t)size);
+        receive(clients[clientIndex / threads], packet, now);
+    }
+}
+
+void LoadGenerator::Worker::disconnectAll()
+{
+    for (auto& client: clients)
+    {
+        if (client.state != VirtualClient::State::Connected)
+            continue;
+        send(client, udp::Socket::ConnectionCloseTemplate("Load generator stopped"));
+        client.state = VirtualClient::State::Idle;
+        (*connected)--;
+        stats.disconnects++;
+    }
+}
+
+#endif
+
+// ------
+
+//* Load Generator
+
+LoadGenerator::LoadGenerator(const LoadConfig& config) : m_config(config)
+{
+    m_config.threads = std::clamp<std::uint32_t>(m_config.threads, 1, std::max<std::uint32_t>(m_config.clients, 1));
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    stop();
+}
+
+std::uint32_t LoadGenerator::getClientAddress(std::uint32_t index)
+{
+    return FIRST_CLIENT_ADDRESS + index;
+}
+
+bool LoadGenerator::start(std::string& error)
+{
+#ifdef __linux__
+    if (!m_threads.empty())
+    {
+        error = "already started";
+        return false;
+    }
+    if (m_config.clients == 0 || m_config.clients > MAX_CLIENTS)
+    {
+        error = "the number of clients must be from 1 to " + std::to_string(MAX_CLIENTS);
+        return false;
+    }
+    if ((m_config.server.toInteger() >> 24) != 127)
+    {
+        error = "the server must be on a loopback address as every client uses its own loopback address";
+        return false;
+    }
+    if (m_config.script.empty())
+    {
+        error = "there is no script";
+        return false;
+    }
+
+    std::uint32_t maxSize = 0;
+    for (auto& step: m_config.script)
+        maxSize = std::max(maxSize, step.size);
+
+    auto startTime = Clock::now();
+    for (std::uint32_t i = 0; i < m_config.threads; i++)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->index = i;
+        worker->config = &m_config;
+        worker->connected = &m_connected;
+        worker->padding.assign(maxSize, 0xAB);
+        worker->fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (worker->fd < 0)
+        {
+            error = std::string("could not create a socket: ") + std::strerror(errno);
+            m_workers.clear();
+            return false;
+        }
+        int enabled = 1;
+        int bufferSize = 4 << 20;
+        setsockopt(worker->fd, IPPROTO_IP, IP_PKTINFO, &enabled, sizeof(enabled));
+        setsockopt(worker->fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        setsockopt(worker->fd, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+        // bound to every address so replies to any client address arrive here
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = 0;
+        if (bind(worker->fd, (sockaddr*)&address, sizeof(address)) != 0)
+        {
+            error = std::string("could not bind a socket: ") + std::strerror(errno);
+            m_workers.clear();
+            return false;
+        }
+
+        for (std::uint32_t client = i; client < m_config.clients; client += m_config.threads)
+        {
+            worker->clients.emplace_back();
+            worker->clients.back().address = getClientAddress(client);
+            // spreading the starts over the ramp time so the server is not hit by every connection at once
+            auto startOffset = toDuration(m_config.ramp * (double)client / (double)m_config.clients);
+            worker->timers.push(Timer{startTime + startOffset, (std::uint32_t)worker->clients.size() - 1, 0});
+        }
+        m_workers.push_back(std::move(worker));
+    }
+
+    for (auto& worker: m_workers)
+        m_threads.emplace_back([this, &worker = *worker](std::stop_token sToken){ m_worker_thread(worker, sToken); });
+    return true;
+#else
+    error = "the load generator is only supported on linux";
+    return false;
+#endif
+}
+
+void LoadGenerator::stop()
+{
+    for (auto& thread: m_threads)
+        thread.request_stop();
+    for (auto& thread: m_threads)
+        thread.join();
+    m_threads.clear();
+}
+
+void LoadGenerator::m_worker_thread(Worker& worker, std::stop_token sToken)
+{
+#ifdef __linux__
+    while (!sToken.stop_requested())
+    {
+        auto now = Clock::now();
+        while (!worker.timers.empty() && worker.timers.top().time <= now)
+        {
+            Timer timer = worker.timers.top();
+            worker.timers.pop();
+            VirtualClient& client = worker.clients[timer.client];
+            if (timer.generation == client.generation)
+                worker.run(client, now);
+        }
+
+        // sleeping until the next timer or a packet arrives (waking up at least every 10ms to check for stop)
+        auto wait = std::chrono::nanoseconds(std::chrono::milliseconds(10));
+        if (!worker.timers.empty())
+            wait = std::clamp(std::chrono::duration_cast<std::chrono::nanoseconds>(worker.timers.top().time - Clock::now()), std::chrono::nanoseconds(0), wait);
+        timespec timeout{(time_t)(wait.count() / 1000000000), (long)(wait.count() % 1000000000)};
+        pollfd descriptor{worker.fd, POLLIN, 0};
+        ppoll(&descriptor, 1, &timeout, nullptr);
+
+        worker.receiveAll(Clock::now());
+    }
+
+    worker.disconnectAll();
+#endif
+}
+
+std::uint32_t LoadGenerator::getConnectedCount() const
+{
+    return m_connected.load();
+}
+
+std::uint64_t LoadGenerator::getPacketsSent() const
+{
+    std::uint64_t total = 0;
+    for (auto& worker: m_workers)
+        total += worker->packetsSent.load(std::memory_order_relaxed);
+    return total;
+}
+
+std::uint64_t LoadGenerator::getPacketsReceived() const
+{
+    std::uint64_t total = 0;
+    for (auto& worker: m_workers)
+        total += worker->packetsReceived.load(std::memory_order_relaxed);
+    return total;
+}
+
+LoadStats LoadGenerator::getStats() const
+{
+    LoadStats total;
+    // the per thread stats are only safe to read once the threads have stopped
+    if (!m_threads.empty())
+    {
+        total.packetsSent = getPacketsSent();
+        total.packetsReceived = getPacketsReceived();
+        return total;
+    }
+
+    for (auto& worker: m_workers)
+    {
+        const LoadStats& stats = worker->stats;
+        total.packetsSent += stats.packetsSent;
+        total.bytesSent += stats.bytesSent;
+        total.packetsReceived += stats.packetsReceived;
+        total.bytesReceived += stats.bytesReceived;
+        total.dataReceived += stats.dataReceived;
+        total.connectAttempts += stats.connectAttempts;
+        total.connects += stats.connects;
+        total.connectTimeouts += stats.connectTimeouts;
+        total.passwordRequests += stats.passwordRequests;
+        total.disconnects += stats.disconnects;
+        total.serverDisconnects += stats.serverDisconnects;
+        total.pongsSent += stats.pongsSent;
+        total.sendErrors += stats.sendErrors;
+        total.unknownPackets += stats.unknownPackets;
+        total.connectLatencies.insert(total.connectLatencies.end(), stats.connectLatencies.begin(), stats.connectLatencies.end());
+    }
+    return total;
+}
@@ -0,0 +1,140 @@
+#ifndef LOAD_GENERATOR_HPP
+#define LOAD_GENERATOR_HPP
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include <optional>
+
+#include <SFML/Network/IpAddress.hpp>
+
+namespace loadgen
+{
+
+/// @brief one step that every virtual client runs through in order
+struct ScriptStep
+{
+    enum class Type
+    {
+        /// @brief sends connection requests until confirmed (answers password requests with the current password)
+        Connect,
+        /// @brief sets the password used when the server asks for one
+        Password,
+        /// @brief sends count data packets of size bytes at rate packets per second (a count of 0 sends until stopped)
+        Send,
+        /// @brief waits for seconds
+        Wait,
+        /// @brief tells the server the connection is closed
+        Disconnect,
+        /// @brief starts the script again from the first step
+        Loop
+    };
+
+    Type type;
+    std::string text;
+    std::uint32_t count = 0;
+    std::uint32_t size = 0;
+    double rate = 0.0;
+    double seconds = 0.0;
+};
+
+/// @brief parses a script like "connect;send:1000,64,20;wait:1;disconnect;loop"
+/// @note steps: connect, password:<text>, send:<count>[,<size>[,<rate>]], wait:<seconds>, disconnect[:<reason>], loop
+/// @param defaultSize used by send steps that do not give a size
+/// @param defaultRate used by send steps that do not give a rate
+/// @returns nullopt if the script is not valid (error is set to why)
+std::optional<std::vector<ScriptStep>> parseScript(const std::string& script, std::uint32_t defaultSize, double defaultRate, std::string& error);
+
+struct LoadConfig
+{
+    /// @brief the number of virtual clients
+    std::uint32_t clients = 1000;
+    /// @brief the number of sockets and threads the clients are spread over
+    std::uint32_t threads = 4;
+    /// @brief must be a loopback address as every virtual client uses its own loopback address
+    sf::IpAddress server = sf::IpAddress::LocalHost;
+    unsigned short port = 50001;
+    /// @brief clients start their script evenly spread over this many seconds
+    double ramp = 1.0;
+    /// @brief how long a connect step waits for a confirmation before it is counted as failed
+    double connectTimeout = 5.0;
+    /// @brief how long a client waits before starting its script again after the connection fails or is closed by the server
+    double reconnectDelay = 1.0;
+    std::vector<ScriptStep> script;
+};
+
+/// @brief totals across all virtual clients
+struct LoadStats
+{
+    std::uint64_t packetsSent = 0;
+    std::uint64_t bytesSent = 0;
+    std::uint64_t packetsReceived = 0;
+    std::uint64_t bytesReceived = 0;
+    std::uint64_t dataReceived = 0;
+    std::uint64_t connectAttempts = 0;
+    std::uint64_t connects = 0;
+    std::uint64_t connectTimeouts = 0;
+    std::uint64_t passwordRequests = 0;
+    std::uint64_t disconnects = 0;
+    /// @brief connections closed by the server
+    std::uint64_t serverDisconnects = 0;
+    std::uint64_t pongsSent = 0;
+    /// @brief datagrams that could not be sent (i.e. full socket buffer)
+    std::uint64_t sendErrors = 0;
+    /// @brief datagrams that were not for any client of the receiving thread or could not be parsed
+    std::uint64_t unknownPackets = 0;
+    /// @brief microseconds from the first connection request to the confirmation
+    std::vector<std::int64_t> connectLatencies;
+};
+
+/// @brief simulates many clients over a few sockets and threads by speaking the wire protocol directly
+/// @note each virtual client sends from its own loopback address (127.1.0.1 and up) so every worker can share one socket
+///       while the server still sees a new address for each client until it has given it a connection ID
+/// @note only supported on linux (needs IP_PKTINFO to pick the source address of every datagram)
+class LoadGenerator
+{
+public:
+    LoadGenerator(const LoadConfig& config);
+    ~LoadGenerator();
+
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+    /// @returns false if the sockets could not be created (error is set to why)
+    bool start(std::string& error);
+    /// @brief stops every thread (connected clients send a connection close first)
+    void stop();
+
+    /// @returns the number of clients currently connected
+    std::uint32_t getConnectedCount() const;
+    /// @returns the number of packets sent so far
+    std::uint64_t getPacketsSent() const;
+    /// @returns the number of packets received so far
+    std::uint64_t getPacketsReceived() const;
+    /// @returns the totals from every thread
+    /// @note the connect latencies are only included once stopped
+    LoadStats getStats() const;
+
+    /// @returns the address used by the virtual client with the given index
+    static std::uint32_t getClientAddress(std::uint32_t index);
+
+protected:
+    struct Worker;
+
+    void m_worker_thread(Worker& worker, std::stop_token sToken);
+
+private:
+    LoadConfig m_config;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::jthread> m_threads;
+    std::atomic<std::uint32_t> m_connected = 0;
+};
+
+}
+
+#endif
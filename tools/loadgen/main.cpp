@@ -0,0 +1,250 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Networking/Server.hpp"
+
+#include "LoadGenerator.hpp"
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+void printUsage()
+{
+    std::cout << 
+        "usage: loadgen [--option value]...\n\n"
+        "  --clients <n>        virtual clients (default 1000)\n"
+        "  --threads <n>        sockets/threads the clients are spread over (default 4)\n"
+        "  --address <ip>       server address, must be loopback (default 127.0.0.1)\n"
+        "  --port <port>        server port (default 50001)\n"
+        "  --duration <s>       how long to run (default 10)\n"
+        "  --ramp <s>           clients start spread over this time (default 1)\n"
+        "  --rate <pkts/s>      default send rate per client (default 10)\n"
+        "  --size <bytes>       default data packet size (default 64)\n"
+        "  --script <script>    steps every client runs (default \"connect;send:0\")\n"
+        "                       connect, password:<text>, send:<count>[,<size>[,<rate>]] (count 0 is forever),\n"
+        "                       wait:<s>, disconnect[:<reason>], loop\n"
+        "  --server             also runs a Server in this process on --port\n"
+        "  --server-password <text>  password for the in process server\n"
+        "  --record <file>      writes every packet the in process server receives to a replay log (see bench replay)\n"
+        "  --json <file>        write the results as json\n";
+}
+
+double getProcessCPUTime()
+{
+#ifdef __linux__
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1e6 +
+           (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1e6;
+#else
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+double percentile(std::vector<std::int64_t>& values, double percent)
+{
+    if (values.empty())
+        return 0.0;
+    std::size_t index = std::min(values.size() - 1, (std::size_t)(percent / 100.0 * (double)values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return (double)values[index];
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::unordered_map<std::string, std::string> args;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h" || arg.rfind("--", 0) != 0)
+        {
+            printUsage();
+            return arg.rfind("--", 0) == 0 ? 0 : 1;
+        }
+        bool hasValue = i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0;
+        args[arg.substr(2)] = hasValue ? argv[++i] : "";
+    }
+    auto get = [&args](const std::string& name, const std::string& defaultValue){
+        auto iter = args.find(name);
+        return iter == args.end() || iter->second.empty() ? defaultValue : iter->second;
+    };
+
+    loadgen::LoadConfig config;
+    double duration;
+    std::string error;
+    try
+    {
+        config.clients = (std::uint32_t)std::stoul(get("clients", "1000"));
+        config.threads = (std::uint32_t)std::stoul(get("threads", "4"));
+        config.port = (unsigned short)std::stoul(get("port", "50001"));
+        config.ramp = std::stod(get("ramp", "1"));
+        duration = std::stod(get("duration", "10"));
+
+        auto address = sf::IpAddress::resolve(get("address", "127.0.0.1"));
+        if (!address)
+        {
+            std::cerr << "invalid address\n";
+            return 1;
+        }
+        config.server = *address;
+
+        auto script = loadgen::parseScript(get("script", "connect;send:0"), (std::uint32_t)std::stoul(get("size", "64")), std::stod(get("rate", "10")), error);
+        if (!script)
+        {
+            std::cerr << "invalid script: " << error << "\n";
+            return 1;
+        }
+        config.script = *script;
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "invalid number in the arguments\n";
+        printUsage();
+        return 1;
+    }
+
+    // an in process server makes the tool self contained, the server still only sees real udp traffic
+    std::unique_ptr<udp::Server> server;
+    std::atomic<bool> stopDraining = false;
+    std::atomic<std::uint64_t> serverReceived = 0;
+    std::thread drainThread;
+    std::shared_ptr<udp::PacketCapture> recorder;
+    if (args.contains("server"))
+    {
+        server = std::make_unique<udp::Server>(config.port);
+        if (args.contains("server-password"))
+            server->setPasswordRequired(true, get("server-password", ""));
+        server->setMessageQueueEnabled();
+        server->setMessageQueueCapacity(1 << 16);
+        if (args.contains("record"))
+        {
+            recorder = std::make_shared<udp::PacketCapture>(udp::CaptureOptions{.format = udp::CaptureFormat::Replay, .path = get("record", "loadgen.replay"), .queueCapacity = 1 << 16});
+            if (!recorder->start())
+            {
+                std::cerr << "could not open " << get("record", "loadgen.replay") << "\n";
+                return 1;
+            }
+            server->setCapture(recorder);
+        }
+        if (!server->tryOpenConnection())
+        {
+            std::cerr << "could not open the server on port " << config.port << "\n";
+            return 1;
+        }
+        drainThread = std::thread([&](){
+            std::vector<udp::Message> messages(256);
+            while (!stopDraining)
+            {
+                std::size_t count = server->poll(messages);
+                serverReceived += count;
+                if (count == 0)
+                    std::this_thread::sleep_for(1ms);
+            }
+        });
+    }
+
+    loadgen::LoadGenerator generator(config);
+    if (!generator.start(error))
+    {
+        std::cerr << error << "\n";
+        stopDraining = true;
+        if (drainThread.joinable())
+            drainThread.join();
+        return 1;
+    }
+
+    double cpuStart = getProcessCPUTime();
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t lastSent = 0, lastReceived = 0;
+    for (int second = 1; second <= (int)std::ceil(duration); second++)
+    {
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::min((double)second, duration))));
+        std::uint64_t sent = generator.getPacketsSent(), received = generator.getPacketsReceived();
+        std::cout << "[" << std::setw(4) << second << "s] connected " << std::setw(7) << generator.getConnectedCount() 
+                  << "  sent/s " << std::setw(9) << sent - lastSent << "  received/s " << std::setw(9) << received - lastReceived;
+        if (server != nullptr)
+            std::cout << "  server clients " << std::setw(7) << server->getClientsSize();
+        std::cout << std::endl;
+        lastSent = sent;
+        lastReceived = received;
+    }
+    std::uint32_t connected = generator.getConnectedCount();
+    generator.stop();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = getProcessCPUTime() - cpuStart;
+
+    if (server != nullptr)
+    {
+        // giving the server time to handle the last packets and the disconnects
+        std::this_thread::sleep_for(250ms);
+        stopDraining = true;
+        drainThread.join();
+        server->closeConnection();
+        if (recorder != nullptr)
+        {
+            recorder->stop();
+            std::cout << "recorded " << recorder->getStats().written << " packets (" << recorder->getStats().dropped << " dropped) to " << get("record", "loadgen.replay") << "\n";
+        }
+    }
+
+    loadgen::LoadStats stats = generator.getStats();
+    std::vector<std::pair<std::string, double>> results = {
+        {"clients", (double)config.clients},
+        {"threads", (double)config.threads},
+        {"connected_at_end", (double)connected},
+        {"connect_attempts", (double)stats.connectAttempts},
+        {"connects", (double)stats.connects},
+        {"connect_timeouts", (double)stats.connectTimeouts},
+        {"connect_p50_us", percentile(stats.connectLatencies, 50)},
+        {"connect_p99_us", percentile(stats.connectLatencies, 99)},
+        {"password_requests", (double)stats.passwordRequests},
+        {"disconnects", (double)stats.disconnects},
+        {"server_disconnects", (double)stats.serverDisconnects},
+        {"packets_sent", (double)stats.packetsSent},
+        {"bytes_sent", (double)stats.bytesSent},
+        {"send_errors", (double)stats.sendErrors},
+        {"packets_received", (double)stats.packetsReceived},
+        {"bytes_received", (double)stats.bytesReceived},
+        {"pongs_sent", (double)stats.pongsSent},
+        {"unknown_packets", (double)stats.unknownPackets},
+        {"packets_sent_per_second", (double)stats.packetsSent / elapsed},
+        {"cpu_seconds", cpu}
+    };
+    if (server != nullptr)
+        results.push_back({"server_data_received", (double)serverReceived.load()});
+
+    std::cout << "== loadgen ==\n";
+    for (auto& [name, value]: results)
+        std::cout << "  " << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(2) << value << "\n";
+
+    if (args.contains("json"))
+    {
+        std::string path = get("json", "loadgen.json");
+        std::ofstream file(path);
+        file << "{\n  \"script\": \"" << get("script", "connect;send:0") << "\"";
+        for (auto& [name, value]: results)
+            file << ",\n  \"" << name << "\": " << std::setprecision(10) << std::defaultfloat << value;
+        file << "\n}\n";
+        if (!file)
+        {
+            std::cerr << "could not write " << path << "\n";
+            return 1;
+        }
+        std::cout << "results written to " << path << "\n";
+    }
+    return 0;
+}